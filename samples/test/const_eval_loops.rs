@@ -0,0 +1,66 @@
+// compile-flags: --test
+//
+// Loop-heavy constant evaluation (also a rough benchmark for the constant evaluator)
+
+const fn triangle(n: u32) -> u32 {
+    let mut s = 0;
+    let mut i = 0;
+    while i < n {
+        s = s + i;
+        i = i + 1;
+    }
+    s
+}
+
+const fn collatz_steps(n: u32) -> u32 {
+    let mut total = 0;
+    let mut i = 1;
+    while i < n {
+        let mut x = i;
+        while x != 1 {
+            x = if x % 2 == 0 { x / 2 } else { x * 3 + 1 };
+            total = total + 1;
+        }
+        i = i + 1;
+    }
+    total
+}
+
+const fn is_prime(n: u32) -> bool {
+    if n < 2 {
+        return false;
+    }
+    let mut d = 2;
+    while d * d <= n {
+        if n % d == 0 {
+            return false;
+        }
+        d = d + 1;
+    }
+    true
+}
+
+const fn count_primes(n: u32) -> u32 {
+    let mut c = 0;
+    let mut i = 0;
+    while i < n {
+        if is_prime(i) {
+            c = c + 1;
+        }
+        i = i + 1;
+    }
+    c
+}
+
+const TRI: u32 = triangle(20000);
+const COLLATZ: u32 = collatz_steps(3000);
+const PRIMES: u32 = count_primes(5000);
+const NOT_PRIME: bool = is_prime(91);
+
+#[test]
+fn const_loops() {
+    assert_eq!(TRI, 199990000);
+    assert_eq!(COLLATZ, 215015);
+    assert_eq!(PRIMES, 669);
+    assert!(!NOT_PRIME);
+}
@@ -0,0 +1,94 @@
+// compile-flags: --test
+//
+// Identical code folding of monomorphised functions - functions that only differ by same-layout types are merged,
+// but anything that depends on the actual type (drop glue, trait impls, layout) must keep them apart.
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+struct A(u32);
+struct B(u32);
+struct C(u64);
+
+#[inline(never)]
+fn sum_ptrs<T>(v: &[*const T], keys: &[u32]) -> u32 {
+    let mut s = 0;
+    for (i, p) in v.iter().enumerate() {
+        if !p.is_null() {
+            s = s * 3 + keys[i];
+        }
+    }
+    s
+}
+
+#[inline(never)]
+fn first_field<T: Copy>(v: &[T], f: fn(T) -> u64) -> u64 {
+    let mut s = 0;
+    for x in v {
+        s = s * 7 + f(*x);
+    }
+    s
+}
+
+static DROPS_D: AtomicUsize = AtomicUsize::new(0);
+static DROPS_E: AtomicUsize = AtomicUsize::new(0);
+struct D(u32);
+struct E(u32);
+impl Drop for D {
+    fn drop(&mut self) { DROPS_D.fetch_add(self.0 as usize, Ordering::SeqCst); }
+}
+impl Drop for E {
+    fn drop(&mut self) { DROPS_E.fetch_add(self.0 as usize * 100, Ordering::SeqCst); }
+}
+
+#[inline(never)]
+fn consume<T>(v: Vec<T>) -> usize {
+    let n = v.len();
+    drop(v);
+    n
+}
+
+trait Value { fn value(&self) -> u32; }
+impl Value for A { fn value(&self) -> u32 { self.0 } }
+impl Value for B { fn value(&self) -> u32 { self.0 + 1000 } }
+
+#[inline(never)]
+fn total<T: Value>(v: &[T]) -> u32 {
+    let mut s = 0;
+    for x in v {
+        s += x.value();
+    }
+    s
+}
+
+#[test]
+fn same_layout_pointers() {
+    let a = A(1);
+    let b = B(2);
+    let keys = [1, 2, 3, 4];
+    let pa = [&a as *const A, std::ptr::null(), &a, &a];
+    let pb = [&b as *const B, &b, std::ptr::null(), &b];
+    let pc = [std::ptr::null(), &C(3) as *const C, &C(4), &C(5)];
+    assert_eq!(sum_ptrs(&pa, &keys), (1 * 3 + 3) * 3 + 4);
+    assert_eq!(sum_ptrs(&pb, &keys), (1 * 3 + 2) * 3 + 4);
+    assert_eq!(sum_ptrs(&pc, &keys), (2 * 3 + 3) * 3 + 4);
+}
+
+#[test]
+fn different_layouts() {
+    assert_eq!(first_field(&[1u32, 2, 3], |x| x as u64), (1 * 7 + 2) * 7 + 3);
+    assert_eq!(first_field(&[1i32, -2, 3], |x| (x + 10) as u64), (11 * 7 + 8) * 7 + 13);
+    assert_eq!(first_field(&[1.5f32, 2.5], |x| (x * 2.0) as u64), 3 * 7 + 5);
+}
+
+#[test]
+fn different_drop_glue() {
+    assert_eq!(consume(vec![D(1), D(2)]), 2);
+    assert_eq!(consume(vec![E(1), E(2)]), 2);
+    assert_eq!(DROPS_D.load(Ordering::SeqCst), 3);
+    assert_eq!(DROPS_E.load(Ordering::SeqCst), 300);
+}
+
+#[test]
+fn different_impls() {
+    assert_eq!(total(&[A(1), A(2)]), 3);
+    assert_eq!(total(&[B(1), B(2)]), 2003);
+}
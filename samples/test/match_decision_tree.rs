@@ -0,0 +1,108 @@
+// compile-flags: --test
+//
+// Match lowering where later arms re-test values already tested by earlier arms (and guards in the middle of value
+// groups). Each match is checked against the equivalent `if` chain.
+
+fn tuple(a: u32, b: u32) -> u32 {
+    match (a, b) {
+        (1, 1) => 10,
+        (_, 2) => 20,
+        (1, 3) => 30,
+        (2, _) => 40,
+        (1, _) => 50,
+        (_, 5) => 60,
+        _ => 0,
+    }
+}
+fn tuple_ref(a: u32, b: u32) -> u32 {
+    if a == 1 && b == 1 { 10 }
+    else if b == 2 { 20 }
+    else if a == 1 && b == 3 { 30 }
+    else if a == 2 { 40 }
+    else if a == 1 { 50 }
+    else if b == 5 { 60 }
+    else { 0 }
+}
+
+fn guarded(a: u32, b: u32) -> u32 {
+    match (a, b) {
+        (1, x) if x > 3 => 10,
+        (1, 2) | (2, 1) => 20,
+        (x, y) if x == y => 30,
+        (3, _) => 40,
+        (_, 3) if a > 5 => 50,
+        (4, 4) => 60,
+        _ => 0,
+    }
+}
+fn guarded_ref(a: u32, b: u32) -> u32 {
+    if a == 1 && b > 3 { 10 }
+    else if (a == 1 && b == 2) || (a == 2 && b == 1) { 20 }
+    else if a == b { 30 }
+    else if a == 3 { 40 }
+    else if b == 3 && a > 5 { 50 }
+    else { 0 }
+}
+
+#[derive(Copy,Clone)]
+enum E {
+    A(u32),
+    B(u32, u32),
+    C,
+}
+fn mk_e(k: u32) -> E {
+    match k % 3 {
+        0 => E::A(k / 3 % 4),
+        1 => E::B(k / 3 % 3, k / 9 % 3),
+        _ => E::C,
+    }
+}
+fn enums(e: E, v: Option<u32>) -> u32 {
+    match (e, v) {
+        (E::A(1), None) => 1,
+        (E::C, _) => 2,
+        (_, Some(1)) => 3,
+        (E::A(1), _) => 4,
+        (E::A(x), Some(y)) if x == y => 5,
+        (E::B(a, b), Some(c)) if a + b == c => 6,
+        (E::B(0, _), _) => 7,
+        (E::A(_), None) => 8,
+        _ => 9,
+    }
+}
+fn enums_ref(e: E, v: Option<u32>) -> u32 {
+    match e {
+        E::A(1) if v.is_none() => return 1,
+        E::C => return 2,
+        _ => {},
+    }
+    if v == Some(1) { return 3; }
+    match e {
+        E::A(1) => return 4,
+        E::A(x) if v == Some(x) => return 5,
+        E::B(a, b) if v == Some(a + b) => return 6,
+        E::B(0, _) => return 7,
+        E::A(_) if v.is_none() => return 8,
+        _ => 9,
+    }
+}
+
+#[test]
+fn shared_tests() {
+    for a in 0 .. 8 {
+        for b in 0 .. 8 {
+            assert_eq!(tuple(a, b), tuple_ref(a, b), "tuple({}, {})", a, b);
+            assert_eq!(guarded(a, b), guarded_ref(a, b), "guarded({}, {})", a, b);
+        }
+    }
+}
+
+#[test]
+fn shared_enum_tests() {
+    for k in 0 .. 60 {
+        for v in 0 .. 6 {
+            let v = if v == 5 { None } else { Some(v) };
+            assert_eq!(enums(mk_e(k), v), enums_ref(mk_e(k), v), "enums({}, {:?})", k, v);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+// compile-flags: --test
+//
+// Polymorphisation - instances that only differ in type parameters that the function doesn't use (or only uses
+// behind a pointer) share code, but must still behave as if they were separate.
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+struct A(u32);
+struct B(u64);
+
+#[inline(never)]
+fn unused<T>(n: u32) -> u32 {
+    let mut s = 1;
+    for i in 0..n {
+        s = s * 5 + i;
+    }
+    s
+}
+
+#[inline(never)]
+fn pointer_only<T>(p: *const T, n: u32) -> u32 {
+    let mut s = if p as usize == 0 { 7 } else { 3 };
+    for i in 0..n {
+        s = s * 3 + i;
+    }
+    s
+}
+
+#[inline(never)]
+fn identity<T, U>(p: *const T, _other: &U) -> *const T {
+    p
+}
+
+static DROPS: AtomicUsize = AtomicUsize::new(0);
+struct D(usize);
+impl Drop for D {
+    fn drop(&mut self) { DROPS.fetch_add(self.0, Ordering::SeqCst); }
+}
+
+#[inline(never)]
+fn consume<T>(v: T, n: usize) -> usize {
+    let _v = v;
+    n
+}
+
+#[inline(never)]
+fn size<T>() -> usize {
+    std::mem::size_of::<T>()
+}
+
+#[test]
+fn unused_params() {
+    assert_eq!(unused::<A>(3), unused::<B>(3));
+    assert_eq!(unused::<D>(3), unused::<Vec<String>>(3));
+}
+
+#[test]
+fn pointer_params() {
+    let a = A(1);
+    let b = B(2);
+    assert_eq!(pointer_only(&a as *const A, 4), pointer_only(&b as *const B, 4));
+    assert_ne!(pointer_only(std::ptr::null::<A>(), 4), pointer_only(&b as *const B, 4));
+
+    assert!(identity(&a as *const A, &b) == &a as *const A);
+    assert!(identity(&b as *const B, &a) == &b as *const B);
+}
+
+#[test]
+fn used_params() {
+    assert_eq!(consume(D(1), 1), 1);
+    assert_eq!(consume(A(10), 2), 2);
+    assert_eq!(DROPS.load(Ordering::SeqCst), 1);
+    assert_eq!(size::<A>(), 4);
+    assert_eq!(size::<B>(), 8);
+}
@@ -0,0 +1,63 @@
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+# Compares the goto-based and structured (`-C structured-c`) C output for a crate:
+# generated C size, C compiler time/peak memory, and (optionally) runtime of a test executable.
+#
+# e.g. `python3 scripts/bench_structured_c.py --run samples/test/match_decision_tree.rs -- -L output`
+
+def run_child(cmd, env=None):
+    start = time.time()
+    p = subprocess.Popen(cmd, env=env)
+    # Wait with `wait4` to get the usage of this child alone (RUSAGE_CHILDREN is a high-water mark over every child)
+    _, status, usage = os.wait4(p.pid, 0)
+    elapsed = time.time() - start
+    p.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -os.WTERMSIG(status)
+    if p.returncode != 0:
+        sys.stderr.write("Command failed ({}): {}\n".format(p.returncode, ' '.join(cmd)))
+        sys.exit(1)
+    return elapsed, usage.ru_maxrss
+
+def main():
+    argp = argparse.ArgumentParser()
+    argp.add_argument("--mrustc", default="bin/mrustc")
+    argp.add_argument("--cc", default="gcc")
+    argp.add_argument("--cflags", default="-O2")
+    argp.add_argument("--outdir", default="output/bench_structured_c")
+    argp.add_argument("--run", action='store_true', help="Build with --test and time the resulting executable")
+    argp.add_argument("source", type=str)
+    argp.add_argument("mrustc_args", nargs='*')
+    args = argp.parse_args()
+
+    if not os.path.isdir(args.outdir):
+        os.makedirs(args.outdir)
+
+    results = []
+    for mode in ["yes", "no"]:
+        name = "structured" if mode == "yes" else "goto"
+        out = os.path.join(args.outdir, name)
+        cmd = [args.mrustc, args.source, "-o", out, "-C", "structured-c=" + mode] + args.mrustc_args
+        if args.run:
+            cmd.append("--test")
+        # Generate the C only, then time the C compiler separately
+        env = dict(os.environ)
+        env["CC"] = "true"
+        run_child(cmd, env=env)
+        c_file = out + ".c"
+        cc_time, cc_rss = run_child([args.cc] + args.cflags.split() + ["-c", "-o", out + ".o", c_file])
+        run_time = None
+        if args.run:
+            run_child(cmd)
+            run_time, _ = run_child([out])
+        results.append( (name, os.path.getsize(c_file), cc_time, cc_rss, run_time) )
+
+    print("{:12} {:>12} {:>10} {:>12} {:>10}".format("mode", "C bytes", "cc (s)", "cc maxrss", "run (s)"))
+    for name, size, cc_time, cc_rss, run_time in results:
+        print("{:12} {:>12} {:>10.2f} {:>12} {:>10}".format(name, size, cc_time, cc_rss,
+            "-" if run_time is None else "{:.2f}".format(run_time)))
+
+if __name__ == "__main__":
+    main()
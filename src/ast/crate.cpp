@@ -11,6 +11,7 @@
 #include "../expand/cfg.hpp"
 #include <hir/hir.hpp>  // HIR::Crate
 #include <hir/main_bindings.hpp>    // HIR_Deserialise
+#include <compile_server.hpp>   // CompileServer_LoadCrate
 #include <fstream>
 #ifdef _WIN32
 # define NOGDI  // prevent ERROR from being defined
@@ -325,7 +326,7 @@ ExternCrate::ExternCrate(const RcString& name, const ::std::string& path):
     m_filename(path)
 {
     TRACE_FUNCTION_F("name=" << name << ", path='" << path << "'");
-    m_hir = HIR_Deserialise(path);
+    m_hir = CompileServer_LoadCrate(path);
 
     m_hir->post_load_update(name);
     m_name = m_hir->m_crate_name;
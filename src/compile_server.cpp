@@ -0,0 +1,431 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * compile_server.cpp
+ * - Persistent compile server (keeps loaded crates resident between compilations)
+ *
+ * The server listens on a unix socket, and forks a child for each request that runs the normal compiler entrypoint.
+ * Forking means that each compilation starts from the server's clean state (all compiler state is global), while
+ * crates that the server has loaded are shared copy-on-write with the child.
+ *
+ * Protocol (client to server): A single message with the client's stdout and stderr attached (SCM_RIGHTS), then the
+ * following NUL-terminated strings, then the client shuts down its side of the connection.
+ * - Working directory
+ * - Number of environment entries (decimal), then that many `NAME=value` entries
+ * - Number of arguments (decimal, not including the program name), then the arguments
+ * Reply: The child's wait status (decimal, as from `waitpid`)
+ */
+#include <compile_server.hpp>
+#include <hir/hir.hpp>
+#include <hir/main_bindings.hpp>    // HIR_Deserialise
+#include <debug.hpp>
+#include <map>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>   // fflush
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <sys/stat.h>
+# include <sys/wait.h>
+# include <poll.h>
+# include <unistd.h>
+# include <fcntl.h>
+# include <signal.h>
+# include <cerrno>
+extern char **environ;
+#endif
+
+#ifndef _WIN32
+namespace {
+    struct FileStamp
+    {
+        int64_t mtime_ns = 0;
+        uint64_t size = 0;
+
+        bool operator==(const FileStamp& x) const { return mtime_ns == x.mtime_ns && size == x.size; }
+    };
+    struct ResidentCrate
+    {
+        ::HIR::CratePtr crate;
+        /// Metadata file state when the crate was loaded (if it changes, the crate is reloaded)
+        FileStamp   stamp;
+    };
+
+    /// Crates loaded by the server, indexed by path
+    // NOTE: Never freed, so the compiler doesn't spend time at exit destroying crates it didn't use
+    ::std::map<::std::string, ResidentCrate>& resident_crates()
+    {
+        static auto* rv = new ::std::map<::std::string, ResidentCrate>();
+        return *rv;
+    }
+    /// Pipe to the server for the paths of crates loaded by this compilation (-1 if not running under the server)
+    int s_report_fd = -1;
+
+    bool get_stamp(const ::std::string& path, FileStamp& out)
+    {
+        // NOTE: `HIR_Deserialise` reads the `.hir` file next to the crate
+        struct stat s;
+        if( stat((path + ".hir").c_str(), &s) != 0 )
+            return false;
+#ifdef __APPLE__
+        out.mtime_ns = static_cast<int64_t>(s.st_mtimespec.tv_sec) * 1000000000 + s.st_mtimespec.tv_nsec;
+#else
+        out.mtime_ns = static_cast<int64_t>(s.st_mtim.tv_sec) * 1000000000 + s.st_mtim.tv_nsec;
+#endif
+        out.size = s.st_size;
+        return true;
+    }
+
+    bool write_all(int fd, const char* data, size_t len)
+    {
+        while( len > 0 )
+        {
+            auto n = write(fd, data, len);
+            if( n < 0 ) {
+                if( errno == EINTR )
+                    continue;
+                return false;
+            }
+            data += n;
+            len -= n;
+        }
+        return true;
+    }
+    void set_cloexec(int fd)
+    {
+        fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+    }
+
+    struct Request
+    {
+        int fd_stdout = -1;
+        int fd_stderr = -1;
+        ::std::string   cwd;
+        ::std::vector<::std::string>    env;
+        ::std::vector<::std::string>    args;
+    };
+
+    /// Read a request from a newly accepted connection
+    bool read_request(int conn_fd, Request& out)
+    {
+        ::std::string   data;
+        char    buf[4096];
+
+        // First chunk has the file descriptors attached
+        {
+            struct iovec iov = { buf, sizeof(buf) };
+            union {
+                struct cmsghdr  hdr;
+                char    space[CMSG_SPACE(2*sizeof(int))];
+            } cmsg_buf;
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = cmsg_buf.space;
+            msg.msg_controllen = sizeof(cmsg_buf.space);
+            auto n = recvmsg(conn_fd, &msg, 0);
+            if( n <= 0 )
+                return false;
+            data.append(buf, n);
+            for(auto* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+            {
+                if( c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS && c->cmsg_len == CMSG_LEN(2*sizeof(int)) )
+                {
+                    int fds[2];
+                    memcpy(fds, CMSG_DATA(c), sizeof(fds));
+                    out.fd_stdout = fds[0];
+                    out.fd_stderr = fds[1];
+                }
+            }
+        }
+        if( out.fd_stdout < 0 )
+            return false;
+        set_cloexec(out.fd_stdout);
+        set_cloexec(out.fd_stderr);
+        // Then the rest of the request, up until the client shuts down its side
+        for(;;)
+        {
+            auto n = read(conn_fd, buf, sizeof(buf));
+            if( n < 0 && errno == EINTR )
+                continue;
+            if( n < 0 )
+                return false;
+            if( n == 0 )
+                break;
+            data.append(buf, n);
+        }
+
+        // Split into strings
+        ::std::vector<::std::string>    strings;
+        size_t  pos = 0;
+        while( pos < data.size() )
+        {
+            auto end = data.find('\0', pos);
+            if( end == ::std::string::npos )
+                return false;
+            strings.push_back(data.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        size_t  i = 0;
+        auto get_list = [&](::std::vector<::std::string>& dst)->bool {
+            if( i >= strings.size() )
+                return false;
+            auto count = ::std::strtoul(strings[i++].c_str(), nullptr, 10);
+            if( strings.size() - i < count )
+                return false;
+            dst.assign(strings.begin() + i, strings.begin() + i + count);
+            i += count;
+            return true;
+            };
+        if( strings.empty() )
+            return false;
+        out.cwd = strings[i++];
+        if( !get_list(out.env) )
+            return false;
+        if( !get_list(out.args) )
+            return false;
+        return i == strings.size();
+    }
+
+    /// Run the compiler for a request (in the forked child)
+    [[noreturn]] void run_request(Request& req, int (*compile)(int argc, char* argv[]))
+    {
+        dup2(req.fd_stdout, 1);
+        dup2(req.fd_stderr, 2);
+        close(req.fd_stdout);
+        close(req.fd_stderr);
+
+        if( chdir(req.cwd.c_str()) != 0 ) {
+            ::std::cerr << "mrustc server: Unable to change to directory " << req.cwd << " - " << strerror(errno) << ::std::endl;
+            _exit(1);
+        }
+        // Replace the environment with the client's
+        {
+            ::std::vector<::std::string>    names;
+            for(auto p = environ; *p; p++)
+            {
+                const char* eq = strchr(*p, '=');
+                names.push_back(eq ? ::std::string(*p, eq - *p) : ::std::string(*p));
+            }
+            for(const auto& n : names)
+                unsetenv(n.c_str());
+        }
+        for(auto& e : req.env)
+        {
+            // NOTE: `putenv` keeps the pointer, but `req` lives until this process exits
+            putenv(&e[0]);
+        }
+
+        ::std::vector<char*>    argv;
+        argv.push_back(const_cast<char*>("mrustc"));
+        for(auto& a : req.args)
+            argv.push_back(&a[0]);
+        argv.push_back(nullptr);
+
+        int rv = compile(static_cast<int>(argv.size() - 1), argv.data());
+
+        ::std::cout.flush();
+        ::std::cerr.flush();
+        fflush(nullptr);
+        // Skip destructors (the compiler state doesn't need to be torn down)
+        _exit(rv);
+    }
+
+    /// Load crates that a compilation used, so the next compilation doesn't need to
+    void load_reported_crates(const ::std::string& report)
+    {
+        auto& cache = resident_crates();
+        size_t  pos = 0;
+        while( pos < report.size() )
+        {
+            auto end = report.find('\n', pos);
+            if( end == ::std::string::npos )
+                break;
+            auto path = report.substr(pos, end - pos);
+            pos = end + 1;
+
+            FileStamp   stamp;
+            if( !get_stamp(path, stamp) )
+                continue;
+            auto it = cache.find(path);
+            if( it != cache.end() && it->second.stamp == stamp )
+                continue;
+            DEBUG("Loading resident crate " << path);
+            auto crate = HIR_Deserialise(path);
+            if( it != cache.end() )
+            {
+                it->second.crate = mv$(crate);
+                it->second.stamp = stamp;
+            }
+            else
+            {
+                cache.insert(::std::make_pair(path, ResidentCrate { mv$(crate), stamp }));
+            }
+        }
+    }
+}
+#endif
+
+int CompileServer_Run(const char* socket_path, int (*compile)(int argc, char* argv[]))
+{
+#ifdef _WIN32
+    ::std::cerr << "--server is not supported on this platform" << ::std::endl;
+    return 1;
+#else
+    struct sockaddr_un  addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if( strlen(socket_path) >= sizeof(addr.sun_path) ) {
+        ::std::cerr << "Socket path too long - " << socket_path << ::std::endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( listen_fd < 0 ) {
+        ::std::cerr << "Unable to create socket - " << strerror(errno) << ::std::endl;
+        return 1;
+    }
+    set_cloexec(listen_fd);
+    // Remove the socket left by a previous server
+    unlink(socket_path);
+    if( bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd, 16) != 0 ) {
+        ::std::cerr << "Unable to listen on " << socket_path << " - " << strerror(errno) << ::std::endl;
+        return 1;
+    }
+    // Clients going away shouldn't kill the server
+    signal(SIGPIPE, SIG_IGN);
+    ::std::cerr << "mrustc: Compile server listening on " << socket_path << ::std::endl;
+
+    struct Job
+    {
+        pid_t   pid;
+        int conn_fd;
+        int report_fd;
+        ::std::string   report;
+    };
+    ::std::vector<Job>  jobs;
+    for(;;)
+    {
+        ::std::vector<struct pollfd>    fds;
+        fds.push_back({ listen_fd, POLLIN, 0 });
+        for(const auto& j : jobs)
+            fds.push_back({ j.report_fd, POLLIN, 0 });
+        if( poll(fds.data(), fds.size(), -1) < 0 ) {
+            if( errno == EINTR )
+                continue;
+            ::std::cerr << "poll failed - " << strerror(errno) << ::std::endl;
+            return 1;
+        }
+
+        // Check for completed compilations (the report pipe closes when the child exits)
+        for(size_t i = jobs.size(); i --; )
+        {
+            if( fds[1+i].revents == 0 )
+                continue;
+            auto& j = jobs[i];
+            char buf[4096];
+            auto n = read(j.report_fd, buf, sizeof(buf));
+            if( n > 0 ) {
+                j.report.append(buf, n);
+                continue;
+            }
+            if( n < 0 && errno == EINTR )
+                continue;
+            close(j.report_fd);
+            int status = -1;
+            while( waitpid(j.pid, &status, 0) < 0 && errno == EINTR )
+                ;
+            auto status_str = FMT(status);
+            write_all(j.conn_fd, status_str.data(), status_str.size());
+            close(j.conn_fd);
+
+            auto report = mv$(j.report);
+            jobs.erase(jobs.begin() + i);
+            load_reported_crates(report);
+        }
+
+        if( fds[0].revents & POLLIN )
+        {
+            int conn_fd = accept(listen_fd, nullptr, nullptr);
+            if( conn_fd < 0 )
+                continue;
+            set_cloexec(conn_fd);
+            Request req;
+            if( !read_request(conn_fd, req) ) {
+                ::std::cerr << "mrustc server: Malformed request" << ::std::endl;
+                if(req.fd_stdout >= 0)  close(req.fd_stdout);
+                if(req.fd_stderr >= 0)  close(req.fd_stderr);
+                close(conn_fd);
+                continue;
+            }
+
+            int report_pipe[2];
+            if( pipe(report_pipe) != 0 ) {
+                ::std::cerr << "mrustc server: Unable to create pipe - " << strerror(errno) << ::std::endl;
+                return 1;
+            }
+            // NOTE: Close-on-exec so processes spawned by the compiler (e.g. the C compiler) don't hold it open
+            set_cloexec(report_pipe[0]);
+            set_cloexec(report_pipe[1]);
+            auto pid = fork();
+            if( pid == 0 )
+            {
+                close(listen_fd);
+                close(conn_fd);
+                close(report_pipe[0]);
+                for(const auto& j : jobs) {
+                    close(j.conn_fd);
+                    close(j.report_fd);
+                }
+                s_report_fd = report_pipe[1];
+                // The compile (and the C compiler it runs) should see a broken pipe like a standalone mrustc would
+                signal(SIGPIPE, SIG_DFL);
+                run_request(req, compile);
+            }
+            close(report_pipe[1]);
+            close(req.fd_stdout);
+            close(req.fd_stderr);
+            if( pid < 0 ) {
+                ::std::cerr << "mrustc server: Unable to fork - " << strerror(errno) << ::std::endl;
+                close(report_pipe[0]);
+                close(conn_fd);
+                continue;
+            }
+            jobs.push_back(Job { pid, conn_fd, report_pipe[0], {} });
+        }
+    }
+#endif
+}
+
+::HIR::CratePtr CompileServer_LoadCrate(const ::std::string& path)
+{
+#ifndef _WIN32
+    if( s_report_fd >= 0 )
+    {
+        auto line = path + "\n";
+        write_all(s_report_fd, line.data(), line.size());
+    }
+    auto& cache = resident_crates();
+    auto it = cache.find(path);
+    if( it != cache.end() )
+    {
+        auto ent = mv$(it->second);
+        cache.erase(it);
+        FileStamp   stamp;
+        if( get_stamp(path, stamp) && stamp == ent.stamp )
+        {
+            DEBUG("Using resident copy of " << path);
+            return mv$(ent.crate);
+        }
+        DEBUG("Resident copy of " << path << " is out of date");
+    }
+#endif
+    return HIR_Deserialise(path);
+}
@@ -8,20 +8,100 @@
 #include <debug_inner.hpp>
 #include <debug.hpp>
 #include <set>
+#include <vector>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <common.hpp>   // FmtEscaped
 #include <cstring>	// strchr
+#include <cstdlib>  // strtoul
 
-// TODO: Inline debug filter/caching
-// - Cache messages for the current phase, clearing the cache (dropping) when various signatures match
-//  > Similar to the `log_get_last_function.py` script
+// Debug output is formatted into a per-thread line buffer, which is then:
+// - Printed (to `std::cout`, or the thread's sink while running parallel items) if the phase is enabled in `MRUSTC_DEBUG`
+// - Recorded in a per-thread ring buffer of recent lines if `MRUSTC_DEBUG_RING` is set, which is dumped when a fatal
+//   error is hit (see `debug_dump_trace`)
 
-int g_debug_indent_level = 0;
+thread_local int g_debug_indent_level = 0;
 bool g_debug_enabled = true;
 ::std::string g_cur_phase;
 ::std::set< ::std::string>    g_debug_disable_map;
 
+namespace {
+    /// Print debug lines for the current phase
+    bool s_debug_print = true;
+    /// Record debug lines for the current phase in the ring buffer
+    bool s_debug_record = false;
+
+    /// Number of lines kept in each thread's ring buffer (0 = disabled)
+    size_t  s_ring_size = 0;
+    /// Phases recorded in the ring buffer (empty = all)
+    ::std::set< ::std::string>  s_ring_phases;
+
+    struct TraceRing
+    {
+        ::std::vector<::std::string>    lines;
+        size_t  next = 0;
+
+        void push(::std::string line)
+        {
+            if( lines.size() < s_ring_size ) {
+                lines.push_back(::std::move(line));
+            }
+            else {
+                lines[next] = ::std::move(line);
+                next = (next + 1) % lines.size();
+            }
+        }
+    };
+    thread_local TraceRing  t_ring;
+    /// Destination for printed lines on this thread (null for `std::cout`)
+    thread_local ::std::ostream*    t_sink = nullptr;
+
+    /// Collects one line of debug output, and hands it off when the stream is flushed (by `std::endl`)
+    class DebugLineBuf:
+        public ::std::streambuf
+    {
+        ::std::string   m_line;
+    protected:
+        int_type overflow(int_type c) override {
+            if( c != traits_type::eof() )
+                m_line.push_back(static_cast<char>(c));
+            return traits_type::not_eof(c);
+        }
+        ::std::streamsize xsputn(const char* s, ::std::streamsize n) override {
+            m_line.append(s, n);
+            return n;
+        }
+        int sync() override {
+            if( m_line.empty() )
+                return 0;
+            if( s_debug_print )
+            {
+                if( t_sink ) {
+                    *t_sink << m_line;
+                }
+                else {
+                    ::std::cout << m_line;
+                    ::std::cout.flush();
+                }
+            }
+            if( s_debug_record )
+            {
+                t_ring.push(::std::move(m_line));
+            }
+            m_line.clear();
+            return 0;
+        }
+    };
+    struct DebugStream
+    {
+        DebugLineBuf    buf;
+        ::std::ostream  os;
+        DebugStream(): os(&buf) {}
+    };
+    thread_local DebugStream    t_debug_stream;
+}
+
 TraceLog::TraceLog(const char* tag, ::std::function<void(::std::ostream&)> info_cb, ::std::function<void(::std::ostream&)> ret):
     m_tag(tag),
     m_ret(ret)
@@ -69,12 +149,9 @@ TraceLog::~TraceLog() {
 
 
 bool debug_enabled_update() {
-    if( g_debug_disable_map.count(g_cur_phase) != 0 ) {
-        return false;
-    }
-    else {
-        return true;
-    }
+    s_debug_print = g_debug_disable_map.count(g_cur_phase) == 0;
+    s_debug_record = s_ring_size > 0 && (s_ring_phases.empty() || s_ring_phases.count(g_cur_phase) != 0);
+    return s_debug_print || s_debug_record;
 }
 bool debug_enabled()
 {
@@ -82,12 +159,36 @@ bool debug_enabled()
 }
 ::std::ostream& debug_output(int indent, const char* function)
 {
-    return ::std::cout << g_cur_phase << "- " << RepeatLitStr { " ", indent } << function << ": ";
+    return t_debug_stream.os << g_cur_phase << "- " << RepeatLitStr { " ", indent } << function << ": ";
+}
+::std::ostream& debug_stream()
+{
+    return t_debug_stream.os;
+}
+::std::ostream* debug_set_thread_sink(::std::ostream* os)
+{
+    t_debug_stream.os.flush();
+    auto* rv = t_sink;
+    t_sink = os;
+    return rv;
+}
+void debug_dump_trace(::std::ostream& os)
+{
+    const auto& ring = t_ring;
+    if( ring.lines.empty() )
+        return ;
+    os << "--- Last " << ring.lines.size() << " debug lines (MRUSTC_DEBUG_RING) ---" << ::std::endl;
+    for(size_t i = 0; i < ring.lines.size(); i ++)
+    {
+        os << ring.lines[(ring.next + i) % ring.lines.size()];
+    }
+    os << "---" << ::std::endl;
 }
 
 DebugTimedPhase::DebugTimedPhase(const char* name):
     m_name(name)
 {
+    t_debug_stream.os.flush();
     ::std::cout << m_name << ": V V V" << ::std::endl;
     g_cur_phase = m_name;
     g_debug_enabled = debug_enabled_update();
@@ -96,6 +197,7 @@ DebugTimedPhase::DebugTimedPhase(const char* name):
 DebugTimedPhase::~DebugTimedPhase()
 {
     auto end = clock();
+    t_debug_stream.os.flush();
     g_cur_phase = "";
     g_debug_enabled = debug_enabled_update();
 
@@ -139,6 +241,31 @@ extern void debug_init_phases(const char* env_var_name, std::initializer_list<co
             }
         }
     }
+
+    // Ring buffer of recent debug lines: `<lines>[:<phase>:<phase>...]` (all phases if none are listed)
+    auto ring_var = ::std::string(env_var_name) + "_RING";
+    const char* ring_string = ::std::getenv(ring_var.c_str());
+    if( ring_string && ring_string[0] )
+    {
+        char* end;
+        s_ring_size = ::std::strtoul(ring_string, &end, 10);
+        const char* pos = end;
+        while( *pos == ':' )
+        {
+            const char* start = pos + 1;
+            pos = strchr(start, ':');
+            if( !pos ) {
+                pos = start + strlen(start);
+            }
+            auto s = ::std::string { start, pos };
+            if( ::std::find(il.begin(), il.end(), s) == il.end() )
+            {
+                ::std::cerr << "WARN: Unknown compiler phase '" << s << "' in $" << ring_var << ::std::endl;
+            }
+            s_ring_phases.insert(::std::move(s));
+        }
+    }
+    g_debug_enabled = debug_enabled_update();
 }
 
 
@@ -774,6 +774,13 @@ namespace {
             rv.m_variadic = m_in.read_bool();
             rv.m_return = deserialise_type();
             rv.m_code = deserialise_exprptr();
+            size_t n_cached = m_in.read_count();
+            for(size_t i = 0; i < n_cached; i ++)
+            {
+                auto p = deserialise_path();
+                auto args = m_in.read_string();
+                rv.m_const_eval_cache.insert(::std::make_pair( ::std::make_pair(mv$(p), mv$(args)), m_in.read_string() ));
+            }
             return rv;
         }
         ::HIR::Function::Markings deserialise_function_markings()
@@ -810,6 +817,12 @@ namespace {
             else
             {
                 rv.m_value_state = ::HIR::Constant::ValueState::Generic;
+                size_t n_cached = m_in.read_count();
+                for(size_t i = 0; i < n_cached; i ++)
+                {
+                    auto p = deserialise_path();
+                    rv.m_monomorph_cache.insert(::std::make_pair( mv$(p), deserialise_encodedliteral() ));
+                }
             }
             return rv;
         }
@@ -194,6 +194,10 @@ public:
 
     ExprPtr m_code;
 
+    // Results of calls during constant evaluation, keyed on the monomorphised path and the argument bytes (only for
+    // arguments/results without pointers)
+    mutable ::std::map< ::std::pair<::HIR::Path, ::std::string>, ::std::string>  m_const_eval_cache;
+
     struct Markings {
         std::vector<unsigned> rustc_legacy_const_generics;
         bool track_caller = false;
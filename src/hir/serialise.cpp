@@ -1125,6 +1125,15 @@
             serialise(fcn.m_return);
 
             serialise(fcn.m_code, fcn.m_save_code || fcn.m_const);
+
+            // Results of constant evaluation calls (so downstream crates don't re-evaluate them)
+            m_out.write_count(fcn.m_const_eval_cache.size());
+            for(const auto& e : fcn.m_const_eval_cache)
+            {
+                serialise_path(e.first.first);
+                m_out.write_string(e.first.second);
+                m_out.write_string(e.second);
+            }
         }
         void serialise(const ::HIR::Function::Markings& m)
         {
@@ -1145,6 +1154,23 @@
             {
                 serialise(item.m_value_res);
             }
+            else
+            {
+                // Monomorphised values of a generic constant, except those that point to other items (which could be
+                // statics generated during evaluation that aren't saved)
+                ::std::vector<const ::std::pair<const ::HIR::Path, EncodedLiteral>*>   ents;
+                for(const auto& e : item.m_monomorph_cache)
+                {
+                    if( ::std::none_of(e.second.relocations.begin(), e.second.relocations.end(), [](const Reloc& r){ return static_cast<bool>(r.p); }) )
+                        ents.push_back(&e);
+                }
+                m_out.write_count(ents.size());
+                for(const auto* e : ents)
+                {
+                    serialise_path(e->first);
+                    serialise(e->second);
+                }
+            }
         }
         void serialise(const ::HIR::Static& item)
         {
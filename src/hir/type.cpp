@@ -929,6 +929,143 @@ const ::HIR::TraitMarkings* HIR::TypePathBinding::get_trait_markings() const
     return markings_ptr;
 }
 
+::std::atomic<uint64_t> HIR::TypeInner::s_flags_epoch { 1 };
+
+namespace {
+    unsigned get_flags_constgeneric(const ::HIR::ConstGeneric& v)
+    {
+        TU_MATCH_HDRA( (v), {)
+        TU_ARMA(Infer, e) {
+            return ::HIR::TypeRef::FLAG_INFER;
+            }
+        TU_ARMA(Generic, e) {
+            return ::HIR::TypeRef::FLAG_GENERIC;
+            }
+        TU_ARMA(Unevaluated, e) {
+            return ::HIR::TypeRef::FLAG_UNEVALUATED;
+            }
+        TU_ARMA(Evaluated, e) {
+            return 0;
+            }
+        }
+        throw "";
+    }
+    unsigned get_flags_pathparams(const ::HIR::PathParams& pp)
+    {
+        unsigned rv = 0;
+        for(const auto& ty : pp.m_types)
+            rv |= ty.flags();
+        for(const auto& v : pp.m_values)
+            rv |= get_flags_constgeneric(v);
+        return rv;
+    }
+    unsigned get_flags_path(const ::HIR::Path& p)
+    {
+        TU_MATCH_HDRA( (p.m_data), {)
+        TU_ARMA(Generic, e) {
+            return get_flags_pathparams(e.m_params);
+            }
+        TU_ARMA(UfcsInherent, e) {
+            return e.type.flags() | get_flags_pathparams(e.params) | get_flags_pathparams(e.impl_params);
+            }
+        TU_ARMA(UfcsKnown, e) {
+            return e.type.flags() | get_flags_pathparams(e.trait.m_params) | get_flags_pathparams(e.params);
+            }
+        TU_ARMA(UfcsUnknown, e) {
+            return e.type.flags() | get_flags_pathparams(e.params);
+            }
+        }
+        throw "";
+    }
+    unsigned get_flags_traitpath(const ::HIR::TraitPath& tp)
+    {
+        unsigned rv = get_flags_pathparams(tp.m_path.m_params);
+        for(const auto& assoc : tp.m_type_bounds)
+            rv |= get_flags_pathparams(assoc.second.source_trait.m_params) | assoc.second.type.flags();
+        for(const auto& assoc : tp.m_trait_bounds)
+        {
+            rv |= get_flags_pathparams(assoc.second.source_trait.m_params);
+            for(const auto& t : assoc.second.traits)
+                rv |= get_flags_traitpath(t);
+        }
+        return rv;
+    }
+}
+
+unsigned HIR::TypeRef::flags() const
+{
+    assert(m_ptr);
+    auto epoch = TypeInner::s_flags_epoch.load(::std::memory_order_relaxed);
+    auto cache = m_ptr->m_flags_cache.load(::std::memory_order_relaxed);
+    if( cache >> 8 == epoch ) {
+        return cache & 0xFF;
+    }
+
+    unsigned rv = 0;
+    TU_MATCH_HDRA( (this->data()), {)
+    TU_ARMA(Infer, e) {
+        rv = FLAG_INFER;
+        }
+    TU_ARMA(Diverge, e) {
+        }
+    TU_ARMA(Primitive, e) {
+        }
+    TU_ARMA(Generic, e) {
+        rv = FLAG_GENERIC;
+        }
+    TU_ARMA(Path, e) {
+        rv = get_flags_path(e.path);
+        if( !e.path.m_data.is_Generic() )
+            rv |= FLAG_UFCS;
+        if( e.binding.is_Opaque() )
+            rv |= FLAG_OPAQUE;
+        }
+    TU_ARMA(TraitObject, e) {
+        rv = get_flags_traitpath(e.m_trait);
+        for(const auto& m : e.m_markers)
+            rv |= get_flags_pathparams(m.m_params);
+        }
+    TU_ARMA(ErasedType, e) {
+        rv = FLAG_ERASED | get_flags_path(e.m_origin);
+        for(const auto& t : e.m_traits)
+            rv |= get_flags_traitpath(t);
+        }
+    TU_ARMA(Array, e) {
+        rv = e.inner.flags();
+        if( const auto* se = e.size.opt_Unevaluated() )
+            rv |= FLAG_UNEVALUATED | get_flags_constgeneric(*se);
+        }
+    TU_ARMA(Slice, e) {
+        rv = e.inner.flags();
+        }
+    TU_ARMA(Tuple, e) {
+        for(const auto& ty : e)
+            rv |= ty.flags();
+        }
+    TU_ARMA(Borrow, e) {
+        rv = e.inner.flags();
+        }
+    TU_ARMA(Pointer, e) {
+        rv = e.inner.flags();
+        }
+    TU_ARMA(Function, e) {
+        rv = e.m_rettype.flags();
+        for(const auto& ty : e.m_arg_types)
+            rv |= ty.flags();
+        }
+    TU_ARMA(Closure, e) {
+        rv = e.m_rettype.flags();
+        for(const auto& ty : e.m_arg_types)
+            rv |= ty.flags();
+        }
+    TU_ARMA(Generator, e) {
+        }
+    }
+    // NOTE: If the epoch changed during the walk, this stores a stale epoch (and will be recalculated next time)
+    m_ptr->m_flags_cache.store((epoch << 8) | rv, ::std::memory_order_relaxed);
+    return rv;
+}
+
 ::HIR::TypeRef HIR::TypeRef::clone() const
 {
     return HIR::TypeRef(*this);
@@ -9,6 +9,7 @@
 #define _HIR_TYPE_HPP_
 #pragma once
 
+#include <atomic>
 #include <tagged_union.hpp>
 #include <hir/path.hpp>
 #include <hir/expr_ptr.hpp>
@@ -211,12 +212,18 @@ public:
     // Existing TypeRef
 
 private:
-    unsigned    m_refcount;
+    // Atomic, as types are shared between threads in the parallel passes
+    ::std::atomic<unsigned> m_refcount;
+    /// Cached `TypeRef::flags` - `(epoch << 8) | flags`, only valid if the epoch matches `s_flags_epoch`
+    mutable ::std::atomic<uint64_t> m_flags_cache;
+    /// Bumped whenever a shared type is mutated in-place (as the types sharing it can't be found to invalidate them)
+    static ::std::atomic<uint64_t> s_flags_epoch;
 public:
     TypeData   m_data;
 private:
     TypeInner(TypeData d):
         m_refcount(1),
+        m_flags_cache(0),
         m_data(mv$(d))
     {
     }
@@ -233,14 +240,13 @@ inline TypeRef::TypeRef(TypeData d):
 inline TypeRef::TypeRef(const TypeRef& x):
     m_ptr(x.m_ptr)
 {
-    x.m_ptr->m_refcount += 1;
+    x.m_ptr->m_refcount.fetch_add(1, ::std::memory_order_relaxed);
 }
 inline TypeRef::~TypeRef()
 {
     if(m_ptr)
     {
-        m_ptr->m_refcount -= 1;
-        if(m_ptr->m_refcount == 0)
+        if(m_ptr->m_refcount.fetch_sub(1, ::std::memory_order_acq_rel) == 1)
         {
             delete m_ptr;
             m_ptr = nullptr;
@@ -248,8 +254,21 @@ inline TypeRef::~TypeRef()
     }
 }
 inline const TypeData& TypeRef::data() const { assert(m_ptr); return m_ptr->m_data; }
-inline TypeData& TypeRef::data_mut() { assert(m_ptr); return m_ptr->m_data; }
-inline TypeData& TypeRef::get_unique() { assert(m_ptr); if(m_ptr->m_refcount != 1) *this = this->clone_shallow(); return m_ptr->m_data; }
+inline TypeData& TypeRef::data_mut() {
+    assert(m_ptr);
+    // Mutation invalidates the cached flags, and if the data is shared then every cache could be affected
+    if(m_ptr->m_refcount.load(::std::memory_order_relaxed) != 1)
+        TypeInner::s_flags_epoch.fetch_add(1, ::std::memory_order_relaxed);
+    m_ptr->m_flags_cache.store(0, ::std::memory_order_relaxed);
+    return m_ptr->m_data;
+}
+inline TypeData& TypeRef::get_unique() {
+    assert(m_ptr);
+    if(m_ptr->m_refcount != 1)
+        *this = this->clone_shallow();
+    m_ptr->m_flags_cache.store(0, ::std::memory_order_relaxed);
+    return m_ptr->m_data;
+}
 
 
 inline TypeRef::TypeRef(::HIR::CoreType ct):
@@ -76,6 +76,23 @@ public:
     TypeData& data_mut();
     TypeData& get_unique();
 
+    /// Structural flags - set if the type (or anything within it) contains the item
+    /// - These are conservative (can be set when a more precise walk would say no), so only use them to skip work
+    enum Flag : unsigned {
+        FLAG_GENERIC = 1 << 0,  //!< Generic type or value
+        FLAG_INFER = 1 << 1,    //!< Inferrence variable (type or value)
+        FLAG_ERASED = 1 << 2,   //!< Erased type (`impl Trait`)
+        FLAG_UFCS = 1 << 3,     //!< UFCS path type (e.g. an associated type)
+        FLAG_OPAQUE = 1 << 4,   //!< Path type with an opaque binding
+        FLAG_UNEVALUATED = 1 << 5,  //!< Array size or const value not yet evaluated
+    };
+    /// Get the structural flags for this type (cached in the shared inner data)
+    unsigned flags() const;
+    bool contains_generics() const { return (flags() & FLAG_GENERIC) != 0; }
+    bool contains_ivars() const { return (flags() & FLAG_INFER) != 0; }
+    bool contains_erased() const { return (flags() & FLAG_ERASED) != 0; }
+    bool contains_ufcs() const { return (flags() & FLAG_UFCS) != 0; }
+
 
 
     TypeRef(::HIR::CoreType ct);
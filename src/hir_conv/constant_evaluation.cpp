@@ -10,6 +10,8 @@
 #include <hir/expr.hpp>
 #include <hir/visitor.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <mir/mir.hpp>
 #include <hir_typeck/common.hpp>    // Monomorph
 #include <mir/helpers.hpp>
@@ -24,6 +26,14 @@
 namespace {
     struct Defer {};
 
+    /// Hit/miss counts for the evaluation result caches (printed if `MRUSTC_CONSTEVAL_STATS` is set)
+    struct CacheStats {
+        ::std::atomic<unsigned> const_hits;
+        ::std::atomic<unsigned> const_misses;
+        ::std::atomic<unsigned> fn_hits;
+        ::std::atomic<unsigned> fn_misses;
+    } s_cache_stats;
+
     struct NewvalState
         : public HIR::Evaluator::Newval
     {
@@ -100,6 +110,7 @@ namespace MIR { namespace eval {
             }
         }
         RefCountPtr(RefCountPtr&& x): m_ptr(x.m_ptr) { x.m_ptr = nullptr; }
+        RefCountPtr& operator=(RefCountPtr&& x) { this->~RefCountPtr(); this->m_ptr = x.m_ptr; x.m_ptr = nullptr; return *this; }
 
         RefCountPtr(): m_ptr(nullptr) {}
 
@@ -873,6 +884,18 @@ namespace {
             TODO(sp, "Could not find function for " << path << " - " << rv.tag_str());
         }
     }
+
+    /// Maximum number of MIR statements executed when evaluating a single constant (`MRUSTC_CONSTEVAL_BUDGET`)
+    size_t get_step_budget()
+    {
+        static size_t s_budget = [](){
+            const char* e = getenv("MRUSTC_CONSTEVAL_BUDGET");
+            if( e && *e )
+                return static_cast<size_t>(::std::strtoull(e, nullptr, 10));
+            return static_cast<size_t>(20*1000*1000);
+            }();
+        return s_budget;
+    }
 }   // namespace <anon>
 
 namespace HIR {
@@ -899,6 +922,8 @@ namespace HIR {
             ::std::vector<AllocationPtr>&  args;
 
             ::std::vector<HIR::TypeRef>   local_types;
+            // NOTE: Allocated on first use (see `get_local`), most locals in a large function are only used by a few
+            // paths through it.
             ::std::vector<AllocationPtr>  locals;
 
             LocalState(::MIR::TypeResolve& state, const MonomorphState& ms, ::std::vector<AllocationPtr>& args):
@@ -909,17 +934,26 @@ namespace HIR {
                 args(args)
             {
                 local_types.reserve( state.m_fcn.locals.size() );
-                locals     .reserve( state.m_fcn.locals.size() );
-                for(size_t i = 0; i < state.m_fcn.locals.size(); i ++)
+                for(const auto& ty : state.m_fcn.locals)
                 {
-                    local_types.push_back( ms.monomorph_type(state.sp, state.m_fcn.locals[i]) );
-                    locals.push_back( AllocationPtr::allocate(state, local_types.back()) );
+                    local_types.push_back( monomorphise_type_needed(ty) ? ms.monomorph_type(state.sp, ty) : ty.clone() );
                 }
+                locals.resize( state.m_fcn.locals.size() );
 
                 state.m_monomorphed_rettype = &ret_type;
                 state.m_monomorphed_locals = &local_types;
             }
 
+            AllocationPtr& get_local(unsigned idx)
+            {
+                MIR_ASSERT(state, idx < locals.size(), "Local index out of range - " << idx << " >= " << locals.size());
+                auto& rv = locals[idx];
+                if( !rv ) {
+                    rv = AllocationPtr::allocate(state, local_types[idx]);
+                }
+                return rv;
+            }
+
             StaticRefPtr get_staticref_mono(const ::HIR::Path& p)
             {
                 // NOTE: Value won't need to be monomorphed, as it shouldn't be generic
@@ -981,9 +1015,8 @@ namespace HIR {
                     val = ValueRef(retval);
                     }
                 TU_ARMA(Local, e) {
-                    MIR_ASSERT(state, e < locals.size(), "Local index out of range - " << e << " >= " << locals.size());
+                    val = ValueRef(get_local(e));
                     typ = &local_types[e];
-                    val = ValueRef(locals[e]);
                     }
                 TU_ARMA(Argument, e) {
                     MIR_ASSERT(state, e < args.size(), "Argument index out of range - " << e << " >= " << args.size());
@@ -1070,8 +1103,7 @@ namespace HIR {
                         if( !Target_GetSizeAndAlignOf(state.sp, state.m_resolve, *typ,  sz, al) )
                             throw Defer();
                         MIR_ASSERT(state, sz < SIZE_MAX, "Unsized type on index output - " << *typ);
-                        MIR_ASSERT(state, e < locals.size(), "LValue::Index index local out of range");
-                        size_t  index = ValueRef(locals[e]).read_usize(state);
+                        size_t  index = ValueRef(get_local(e)).read_usize(state);
                         MIR_ASSERT(state, index < size, "LValue::Index index out of range - " << index << " >= " << size);
                         val = val.slice(index * sz, sz);
                         }
@@ -1130,8 +1162,13 @@ namespace HIR {
                 if( c.m_value_state == HIR::Constant::ValueState::Generic )
                 {
                     auto it = c.m_monomorph_cache.find(p);
-                    if( it == c.m_monomorph_cache.end() )
+                    if( it != c.m_monomorph_cache.end() )
+                    {
+                        s_cache_stats.const_hits ++;
+                    }
+                    else
                     {
+                        s_cache_stats.const_misses ++;
                         auto& item = const_cast<::HIR::Constant&>(c);
                         // Challenge: Adding items to the module might invalidate an iterator.
                         ::HIR::ItemPath mod_ip { item.m_value.m_state->m_mod_path };
@@ -1395,6 +1432,16 @@ namespace HIR {
         for(;;)
         {
             const auto& block = fcn.blocks[cur_block];
+            // Charge the whole block up-front (statements and the terminator), so an infinite loop is reported
+            // instead of hanging the compiler.
+            size_t block_steps = block.statements.size() + 1;
+            if( this->steps_remaining < block_steps )
+            {
+                state.set_cur_stmt_term(cur_block);
+                ERROR(state.sp, E0000, state << "Constant evaluation exceeded the step limit of " << get_step_budget() << " MIR statements"
+                    << " in " << ip << " (possible infinite loop, set MRUSTC_CONSTEVAL_BUDGET to raise the limit)");
+            }
+            this->steps_remaining -= block_steps;
             for(const auto& stmt : block.statements)
             {
                 state.set_cur_stmt(cur_block, &stmt - &block.statements.front());
@@ -1865,7 +1912,7 @@ namespace HIR {
             TU_ARMA(If, e) {
                 bool res = 0 != local_state.get_lval(e.cond).read_uint(state, 1);
                 DEBUG(state << " = " << res);
-                cur_block = res ? e.bb1 : e.bb0;
+                cur_block = res ? e.bb0 : e.bb1;
                 }
             TU_ARMA(Switch, e) {
                 HIR::TypeRef    tmp;
@@ -2101,7 +2148,54 @@ namespace HIR {
 
                     // TODO: Set m_const during parse and check here
 
+                    // Calls with plain data arguments (no pointers) are memoised on the function, keyed on the
+                    // monomorphised path and the argument bytes.
+                    ::std::string   cache_key;
+                    bool use_cache = !visit_path_tys_with(fcnp, [&](const auto& ty)->bool { return ty.data().is_Generic(); });
+                    for(auto& a : call_args)
+                    {
+                        if( !use_cache )
+                            break;
+                        if( !a->get_relocations().empty() ) {
+                            use_cache = false;
+                            break;
+                        }
+                        size_t size = a->size();
+                        cache_key += ::std::to_string(size);
+                        cache_key += ':';
+                        const auto* bytes = a->get_bytes(0, size, false);
+                        cache_key.append(reinterpret_cast<const char*>(bytes), size);
+                        ::std::vector<uint8_t>  mask((size + 7) / 8);
+                        a->read_mask(mask.data(), 0, 0, size);
+                        cache_key.append(mask.begin(), mask.end());
+                    }
+                    const size_t MAX_CACHED_SIZE = 0x10000;
+                    if( cache_key.size() > MAX_CACHED_SIZE )
+                        use_cache = false;
+                    const ::std::string*    cached_rv = nullptr;
+                    if( use_cache )
+                    {
+                        auto it = fcn.m_const_eval_cache.find(::std::make_pair(fcnp.clone(), cache_key));
+                        if( it != fcn.m_const_eval_cache.end() ) {
+                            s_cache_stats.fn_hits ++;
+                            cached_rv = &it->second;
+                        }
+                        else {
+                            s_cache_stats.fn_misses ++;
+                        }
+                    }
+
+                    if( cached_rv )
+                    {
+                        DEBUG("Call const fn " << fcnp << " - cached");
+                        auto ret_ty = fcn_ms.monomorph_type(this->root_span, fcn.m_return);
+                        auto rv = AllocationPtr::allocate(state, ret_ty);
+                        MIR_ASSERT(state, rv->size() == cached_rv->size(), "Cached result of " << fcnp << " is the wrong size");
+                        rv->write_bytes(0, cached_rv->data(), cached_rv->size());
+                        dst.copy_from( state, ValueRef(rv) );
+                    }
                     // Call by invoking evaluate_constant on the function
+                    else
                     {
                         TRACE_FUNCTION_F("Call const fn " << fcnp << " args={ " << call_args << " }");
                         auto fcn_ip = ::HIR::ItemPath(fcnp);
@@ -2110,6 +2204,17 @@ namespace HIR {
                         auto ret_ty = fcn_ms.monomorph_type(this->root_span, fcn.m_return);
                         auto rv = evaluate_constant_mir(fcn_ip, *mir, mv$(fcn_ms), mv$(ret_ty), arg_defs, mv$(call_args));
                         dst.copy_from( state, ValueRef(rv) );
+
+                        // Only fully-initialised results without pointers are cached (pointers would need the
+                        // pointed-to data re-creating)
+                        const auto* rv_bytes = rv->get_bytes(0, rv->size(), true);
+                        if( use_cache && rv->get_relocations().empty() && rv_bytes && rv->size() <= MAX_CACHED_SIZE )
+                        {
+                            fcn.m_const_eval_cache.insert(::std::make_pair(
+                                ::std::make_pair(mv$(fcnp), mv$(cache_key)),
+                                ::std::string(reinterpret_cast<const char*>(rv_bytes), rv->size())
+                                ));
+                        }
                     }
                 }
                 else
@@ -2169,6 +2274,7 @@ namespace HIR {
     EncodedLiteral Evaluator::evaluate_constant(const ::HIR::ItemPath& ip, const ::HIR::ExprPtr& expr, ::HIR::TypeRef exp, MonomorphState ms/*={}*/)
     {
         TRACE_FUNCTION_F(ip);
+        this->steps_remaining = get_step_budget();
         const auto* mir = this->resolve.m_crate.get_or_gen_mir(ip, expr, exp);
 
         if( mir ) {
@@ -2676,6 +2782,27 @@ void ConvertHIR_ConstantEvaluate(::HIR::Crate& crate)
         crate.m_root_module.m_mod_items.insert( mv$(new_ty_pair) );
     }
 }
+void ConvertHIR_ConstantEvaluate_PrintStats()
+{
+    if( getenv("MRUSTC_CONSTEVAL_STATS") )
+    {
+        ::std::cout << "Constant evaluation cache:"
+            << " constants " << s_cache_stats.const_hits << " hits / " << s_cache_stats.const_misses << " misses,"
+            << " const fn calls " << s_cache_stats.fn_hits << " hits / " << s_cache_stats.fn_misses << " misses"
+            << ::std::endl;
+    }
+}
+const EncodedLiteral* ConvertHIR_ConstantEvaluate_GetCached(const ::HIR::Constant& c, const ::HIR::Path& p)
+{
+    auto it = c.m_monomorph_cache.find(p);
+    if( it == c.m_monomorph_cache.end() )
+    {
+        s_cache_stats.const_misses ++;
+        return nullptr;
+    }
+    s_cache_stats.const_hits ++;
+    return &it->second;
+}
 void ConvertHIR_ConstantEvaluate_Expr(const ::HIR::Crate& crate, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& expr_ptr)
 {
     TRACE_FUNCTION_F(ip);
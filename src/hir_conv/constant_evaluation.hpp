@@ -22,11 +22,14 @@ struct Evaluator
     Span    root_span;
     StaticTraitResolve  resolve;
     Newval& nvs;
+    /// Number of MIR statements/terminators left before evaluation is abandoned (reset per top-level constant)
+    size_t  steps_remaining;
 
     Evaluator(const Span& sp, const ::HIR::Crate& crate, Newval& nvs):
         root_span(sp),
         resolve(crate),
-        nvs( nvs )
+        nvs( nvs ),
+        steps_remaining(0)
     {
     }
 
@@ -43,3 +46,6 @@ private:
 
 } // namespace HIR
 
+/// Look up a cached value of a monomorphised generic constant (counted in the cache statistics)
+extern const EncodedLiteral* ConvertHIR_ConstantEvaluate_GetCached(const ::HIR::Constant& c, const ::HIR::Path& p);
+
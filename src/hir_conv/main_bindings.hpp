@@ -26,6 +26,8 @@ extern void ConvertHIR_ResolveUFCS_Outer(::HIR::Crate& crate);
 extern void ConvertHIR_ResolveUFCS(::HIR::Crate& crate);
 extern void ConvertHIR_Markings(::HIR::Crate& crate);
 extern void ConvertHIR_ConstantEvaluate(::HIR::Crate& hir_crate);
+/// Print the constant evaluation cache statistics (if `MRUSTC_CONSTEVAL_STATS` is set)
+extern void ConvertHIR_ConstantEvaluate_PrintStats();
 
 extern void ConvertHIR_ConstantEvaluate_Expr(const ::HIR::Crate& crate, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& exp);
 extern void ConvertHIR_ConstantEvaluate_Enum(const ::HIR::Crate& crate, const ::HIR::ItemPath& ip, const ::HIR::Enum& enm);
@@ -1244,6 +1244,11 @@ void HIR_Expand_AnnotateUsage_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr& ex
     StaticTraitResolve   resolve { crate };
     if(exp.m_state->m_impl_generics)   resolve.set_impl_generics(*exp.m_state->m_impl_generics);
     if(exp.m_state->m_item_generics)   resolve.set_item_generics(*exp.m_state->m_item_generics);
+    HIR_Expand_AnnotateUsage_Body(resolve, exp);
+}
+void HIR_Expand_AnnotateUsage_Body(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp)
+{
+    assert(exp);
     ExprVisitor_Mark    ev { resolve, exp.m_bindings };
     ev.visit_root(exp);
 }
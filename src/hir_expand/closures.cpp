@@ -1362,12 +1362,15 @@ namespace {
     {
         StaticTraitResolve  m_resolve;
         OutState    m_out;
+        /// Extra per-body processing (from the fused pipeline)
+        t_expand_body_cb    m_body_cb;
 
         const ::HIR::SimplePath*  m_cur_mod_path;
         const ::HIR::TypeRef*   m_self_type = nullptr;
     public:
-        OuterVisitor(const ::HIR::Crate& crate):
+        OuterVisitor(const ::HIR::Crate& crate, t_expand_body_cb body_cb={}):
             m_resolve(crate),
+            m_body_cb( mv$(body_cb) ),
             m_cur_mod_path( nullptr )
         {}
 
@@ -1435,6 +1438,9 @@ namespace {
             {
                 this->visit_type( e->inner );
                 DEBUG("Array size " << ty);
+                if( m_body_cb && e->size.is_Unevaluated() && e->size.as_Unevaluated().is_Unevaluated() ) {
+                    m_body_cb(m_resolve, *e->size.as_Unevaluated().as_Unevaluated());
+                }
                 if( e->size.is_Unevaluated() ) {
                     //::std::vector< ::HIR::TypeRef>  tmp;
                     //ExprVisitor_Extract    ev(m_resolve, tmp, m_new_trait_impls);
@@ -1455,6 +1461,10 @@ namespace {
             {
                 assert( m_cur_mod_path );
                 DEBUG("Function code " << p);
+                if( m_body_cb )
+                {
+                    m_body_cb(m_resolve, item.m_code);
+                }
 
                 {
                     ExprVisitor_Extract    ev(m_resolve, m_self_type, item.m_code.m_bindings, m_out, p.name);
@@ -1473,6 +1483,10 @@ namespace {
             }
         }
         void visit_static(::HIR::ItemPath p, ::HIR::Static& item) override {
+            if( item.m_value && m_body_cb )
+            {
+                m_body_cb(m_resolve, item.m_value);
+            }
             if( item.m_value )
             {
                 //::std::vector< ::HIR::TypeRef>  tmp;
@@ -1481,6 +1495,10 @@ namespace {
             }
         }
         void visit_constant(::HIR::ItemPath p, ::HIR::Constant& item) override {
+            if( item.m_value && m_body_cb )
+            {
+                m_body_cb(m_resolve, item.m_value);
+            }
             if( item.m_value )
             {
                 //::std::vector< ::HIR::TypeRef>  tmp;
@@ -1490,6 +1508,20 @@ namespace {
         }
         void visit_enum(::HIR::ItemPath p, ::HIR::Enum& item) override {
             //auto _ = this->m_ms.set_item_generics(item.m_params);
+            if( m_body_cb )
+            {
+                if(auto* e = item.m_data.opt_Value())
+                {
+                    auto _ = this->m_resolve.set_item_generics(item.m_params);
+                    for(auto& var : e->variants)
+                    {
+                        if( var.expr )
+                        {
+                            m_body_cb(m_resolve, var.expr);
+                        }
+                    }
+                }
+            }
 
             /*
             if(const auto* e = item.m_data.opt_Value())
@@ -1611,4 +1643,9 @@ void HIR_Expand_Closures(::HIR::Crate& crate)
     OuterVisitor    ov(crate);
     ov.visit_crate( crate );
 }
+void HIR_Expand_Closures(::HIR::Crate& crate, t_expand_body_cb body_cb)
+{
+    OuterVisitor    ov(crate, mv$(body_cb));
+    ov.visit_crate( crate );
+}
 
@@ -139,12 +139,22 @@ namespace {
     };
 }
 
+void HIR_Expand_ErasedType_Body(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp)
+{
+    assert(exp);
+    ExprVisitor_Extract    ev(resolve);
+    ev.visit_root( exp );
+}
+void HIR_Expand_ErasedType_Fixup(::HIR::Crate& crate)
+{
+    OuterVisitor_Fixup  ov_fix(crate);
+    ov_fix.visit_crate(crate);
+}
 void HIR_Expand_ErasedType(::HIR::Crate& crate)
 {
     OuterVisitor    ov(crate);
     ov.visit_crate( crate );
 
-    OuterVisitor_Fixup  ov_fix(crate);
-    ov_fix.visit_crate(crate);
+    HIR_Expand_ErasedType_Fixup(crate);
 }
 
@@ -0,0 +1,71 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir_expand/fused.cpp
+ * - Fused HIR expansion pipeline (runs the per-body passes on one body at a time)
+ *
+ * The separate passes each walk every body in the crate, this instead chains the per-body parts so each body is only
+ * brought in once per phase. There are still two body walks, as some passes depend on the results of another pass
+ * having been applied to the entire crate:
+ * - Closure extraction creates new types/impls (which the later passes need to see), and erased type expansion needs
+ *   closures extracted from the source function's body.
+ * - VTables need the closure impls
+ */
+#include "main_bindings.hpp"
+#include <hir/hir.hpp>
+#include <hir/expr_state.hpp>
+#include <hir_typeck/static.hpp>
+#include <hir_typeck/common.hpp>    // Typecheck_Expressions_ValidateOne
+#include <mir/visit_crate_mir.hpp>
+
+namespace {
+    /// Body visitor for the second phase (also updates constant types, as validation does)
+    class OuterVisitor_Late:
+        public ::MIR::OuterVisitor
+    {
+    public:
+        OuterVisitor_Late(const ::HIR::Crate& crate, cb_t cb):
+            ::MIR::OuterVisitor(crate, mv$(cb))
+        {}
+
+        void visit_constant(::HIR::ItemPath p, ::HIR::Constant& item) override {
+            ::MIR::OuterVisitor::visit_constant(p, item);
+            m_resolve.expand_associated_types(Span(), item.m_type);
+        }
+    };
+}
+
+void HIR_Expand_Fused(::HIR::Crate& crate)
+{
+    // NOTE: Static borrow and erased type expansion don't use the item generics
+    StaticTraitResolve  resolve_nogen { crate };
+
+    // Phase 1: Annotate usage, lift borrowed constants to statics, and extract closures
+    {
+        TRACE_FUNCTION_F("Phase 1");
+        t_lifted_statics    new_statics;
+        HIR_Expand_Closures(crate, [&](const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp) {
+            HIR_Expand_AnnotateUsage_Body(resolve, exp);
+            HIR_Expand_StaticBorrowConstants_Body(resolve_nogen, exp, new_statics);
+            });
+        HIR_Expand_StaticBorrowConstants_Push(crate, new_statics);
+    }
+
+    HIR_Expand_VTables(crate);
+    // Function signatures only depend on the (now closure-free) erased type lists
+    HIR_Expand_ErasedType_Fixup(crate);
+
+    // Phase 2: UFCS calls, reborrows, erased types, then validate
+    {
+        TRACE_FUNCTION_F("Phase 2");
+        OuterVisitor_Late   ov(crate, [&](const StaticTraitResolve& resolve, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& exp, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type) {
+            DEBUG(ip);
+            HIR_Expand_UfcsEverything_Expr(crate, exp);
+            HIR_Expand_Reborrows_Expr(crate, exp);
+            HIR_Expand_ErasedType_Body(resolve_nogen, exp);
+            Typecheck_Expressions_ValidateOne(resolve, args, ret_type, exp, /*expand_erased_types=*/true);
+            });
+        ov.visit_crate(crate);
+    }
+}
@@ -6,10 +6,17 @@
  * - Functions defined in this folder that are called by main
  */
 #pragma once
+#include <functional>
+#include <map>
+#include <vector>
 
+class StaticTraitResolve;
 namespace HIR {
     class Crate;
     class ExprPtr;
+    class Module;
+    class SimplePath;
+    class Static;
 };
 
 extern void HIR_Expand_AnnotateUsage(::HIR::Crate& crate);
@@ -25,3 +32,19 @@ extern void HIR_Expand_Closures_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr&
 extern void HIR_Expand_UfcsEverything_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr& exp);
 extern void HIR_Expand_Reborrows_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr& exp);
 //extern void HIR_Expand_StaticBorrowConstants_Expr(const ::HIR::Crate& crate, ::HIR::ExprPtr& exp);
+
+/// Run all of the above (and expression validation) one body at a time, see hir_expand/fused.cpp
+extern void HIR_Expand_Fused(::HIR::Crate& crate);
+
+// - Per-body entry points used by the fused pipeline
+/// Callback for each body visited by closure expansion, called before the closures are extracted
+typedef ::std::function<void(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp)>  t_expand_body_cb;
+/// Statics lifted by static borrow expansion, added to the module tree by `HIR_Expand_StaticBorrowConstants_Push`
+typedef ::std::map< const ::HIR::Module*, ::std::vector< ::std::pair< ::HIR::SimplePath, ::HIR::Static> > > t_lifted_statics;
+
+extern void HIR_Expand_AnnotateUsage_Body(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp);
+extern void HIR_Expand_StaticBorrowConstants_Body(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp, t_lifted_statics& new_statics);
+extern void HIR_Expand_StaticBorrowConstants_Push(::HIR::Crate& crate, t_lifted_statics& new_statics);
+extern void HIR_Expand_Closures(::HIR::Crate& crate, t_expand_body_cb body_cb);
+extern void HIR_Expand_ErasedType_Body(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp);
+extern void HIR_Expand_ErasedType_Fixup(::HIR::Crate& crate);
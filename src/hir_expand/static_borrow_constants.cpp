@@ -157,6 +157,24 @@ namespace {
             }
         }
     };
+    /// Add a new static to the list for `mod` (assigning a path based on the current list)
+    HIR::SimplePath add_lifted_static(t_lifted_statics& new_statics, const HIR::Module& mod, const HIR::SimplePath& mod_path, HIR::TypeRef ty, HIR::ExprPtr val_expr)
+    {
+        auto& list = new_statics[&mod];
+        auto idx = list.size();
+        auto name = RcString::new_interned( FMT("lifted#" << idx) );
+        auto path = mod_path + name;
+        auto new_static = HIR::Static(
+            HIR::Linkage(),
+            /*is_mut=*/false,
+            mv$(ty),
+            /*m_value=*/mv$(val_expr)
+            );
+        DEBUG(path << " = " << new_static.m_value_res);
+        list.push_back(std::make_pair( path, mv$(new_static) ));
+        return path;
+    }
+
     class OuterVisitor:
         public ::HIR::Visitor
     {
@@ -165,7 +183,7 @@ namespace {
         const HIR::ItemPath*  m_current_module_path;
         const HIR::Module*  m_current_module;
 
-        std::map<const HIR::Module*, std::vector< std::pair<HIR::SimplePath, HIR::Static> > >  m_new_statics;
+        t_lifted_statics    m_new_statics;
 
     public:
         OuterVisitor(const ::HIR::Crate& crate):
@@ -178,20 +196,7 @@ namespace {
         {
             return [this](Span sp, HIR::TypeRef ty, HIR::ExprPtr val_expr)->HIR::SimplePath {
                 ASSERT_BUG(sp, m_current_module, "");
-                // Assign a path (based on the current list)
-                auto& list = m_new_statics[m_current_module];
-                auto idx = list.size();
-                auto name = RcString::new_interned( FMT("lifted#" << idx) );
-                auto path = (*m_current_module_path + name).get_simple_path();
-                auto new_static = HIR::Static(
-                    HIR::Linkage(),
-                    /*is_mut=*/false,
-                    mv$(ty),
-                    /*m_value=*/mv$(val_expr)
-                    );
-                DEBUG(path << " = " << new_static.m_value_res);
-                list.push_back(std::make_pair( path, mv$(new_static) ));
-                return path;
+                return add_lifted_static(m_new_statics, *m_current_module, m_current_module_path->get_simple_path(), mv$(ty), mv$(val_expr));
                 };
         }
 
@@ -199,26 +204,7 @@ namespace {
             ::HIR::Visitor::visit_crate(crate);
 
             // Once the crate is complete, add the newly created statics to the module tree
-            for(auto& mod_list : m_new_statics)
-            {
-                auto& mod = *const_cast<HIR::Module*>(mod_list.first);
-
-                for(auto& new_static_pair : mod_list.second)
-                {
-                    struct NullNvs: ::HIR::Evaluator::Newval {
-                        ::HIR::Path new_static(::HIR::TypeRef type, EncodedLiteral value) override { BUG(Span(), "Unexpected attempt to create a new value in extracted constant"); }
-                    } null_nvs;
-                    Span    sp;
-                    auto& new_static = new_static_pair.second;
-                    new_static.m_value_res = ::HIR::Evaluator(sp, m_crate, null_nvs).evaluate_constant( new_static_pair.first, new_static.m_value, new_static.m_type.clone());
-                    new_static.m_value_generated = true;
-
-                    mod.m_value_items.insert(std::make_pair( mv$(new_static_pair.first.m_components.back()), box$(HIR::VisEnt<HIR::ValueItem> {
-                        HIR::Publicity::new_none(), // Should really be private, but we're well after checking
-                        HIR::ValueItem(mv$(new_static_pair.second))
-                        })) );
-                }
-            }
+            HIR_Expand_StaticBorrowConstants_Push(crate, m_new_statics);
         }
 
         void visit_module(::HIR::ItemPath p, ::HIR::Module& mod) override {
@@ -335,6 +321,41 @@ void HIR_Expand_StaticBorrowConstants_Expr(const ::HIR::Crate& crate, ::HIR::Exp
         }, exp);
     ev.visit_node_ptr( exp );
 }
+void HIR_Expand_StaticBorrowConstants_Body(const StaticTraitResolve& resolve, ::HIR::ExprPtr& exp, t_lifted_statics& new_statics)
+{
+    assert(exp);
+    assert(exp.m_state);
+    // New statics go in the module that contains the body
+    const auto& state = *exp.m_state;
+    ExprVisitor_Mutate  ev(resolve, [&](Span sp, HIR::TypeRef ty, HIR::ExprPtr val)->HIR::SimplePath {
+        return add_lifted_static(new_statics, state.m_module, state.m_mod_path, mv$(ty), mv$(val));
+        }, exp);
+    ev.visit_node_ptr( exp );
+}
+void HIR_Expand_StaticBorrowConstants_Push(::HIR::Crate& crate, t_lifted_statics& new_statics)
+{
+    for(auto& mod_list : new_statics)
+    {
+        auto& mod = *const_cast<HIR::Module*>(mod_list.first);
+
+        for(auto& new_static_pair : mod_list.second)
+        {
+            struct NullNvs: ::HIR::Evaluator::Newval {
+                ::HIR::Path new_static(::HIR::TypeRef type, EncodedLiteral value) override { BUG(Span(), "Unexpected attempt to create a new value in extracted constant"); }
+            } null_nvs;
+            Span    sp;
+            auto& new_static = new_static_pair.second;
+            new_static.m_value_res = ::HIR::Evaluator(sp, crate, null_nvs).evaluate_constant( new_static_pair.first, new_static.m_value, new_static.m_type.clone());
+            new_static.m_value_generated = true;
+
+            mod.m_value_items.insert(std::make_pair( mv$(new_static_pair.first.m_components.back()), box$(HIR::VisEnt<HIR::ValueItem> {
+                HIR::Publicity::new_none(), // Should really be private, but we're well after checking
+                HIR::ValueItem(mv$(new_static_pair.second))
+                })) );
+        }
+    }
+    new_statics.clear();
+}
 void HIR_Expand_StaticBorrowConstants(::HIR::Crate& crate)
 {
     OuterVisitor    ov(crate);
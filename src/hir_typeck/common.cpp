@@ -232,6 +232,8 @@ struct TyVisitorMonomorphNeeded: TyVisitor<WConst>
     }
     bool visit_type(const ::HIR::TypeRef& ty) override
     {
+        if( (ty.flags() & (::HIR::TypeRef::FLAG_GENERIC|::HIR::TypeRef::FLAG_UNEVALUATED)) == 0 )
+            return false;
         if( ty.data().is_Generic() )
             return true;
         if( ty.data().is_Array() && ty.data().as_Array().size.is_Unevaluated() /*&& ty.data().as_Array().size.as_Unevaluated().*/ )
@@ -263,6 +265,15 @@ bool monomorphise_type_needed(const ::HIR::TypeRef& tpl)
 
 ::HIR::TypeRef Monomorphiser::monomorph_type(const Span& sp, const ::HIR::TypeRef& tpl, bool allow_infer/*=true*/) const
 {
+    // Fast path: Nothing to replace, so share the input
+    // - Excludes types that could be updated in-place (associated types, erased types, ivars, unevaluated sizes) to avoid
+    //   the result aliasing the template when that happens.
+    const unsigned needs_clone_flags = ::HIR::TypeRef::FLAG_GENERIC|::HIR::TypeRef::FLAG_INFER|::HIR::TypeRef::FLAG_ERASED
+        |::HIR::TypeRef::FLAG_UFCS|::HIR::TypeRef::FLAG_OPAQUE|::HIR::TypeRef::FLAG_UNEVALUATED;
+    if( (tpl.flags() & needs_clone_flags) == 0 )
+    {
+        return tpl.clone();
+    }
     TU_MATCH_HDRA( (tpl.data()), {)
     TU_ARMA(Infer, e) {
         ASSERT_BUG(sp, allow_infer, "Unexpected ivar seen - " << tpl);
@@ -31,6 +31,8 @@ extern ::HIR::PathParams clone_path_params_with(const Span& sp, const ::HIR::Pat
 extern void check_type_class_primitive(const Span& sp, const ::HIR::TypeRef& type, ::HIR::InferClass ic, ::HIR::CoreType ct);
 
 class StaticTraitResolve;
-extern void Typecheck_Expressions_ValidateOne(const StaticTraitResolve& resolve, const ::std::vector<::std::pair< ::HIR::Pattern, ::HIR::TypeRef>>& args, const ::HIR::TypeRef& ret_ty, const ::HIR::ExprPtr& code);
+/// Validate a single body
+/// - `expand_erased_types` should only be set once erased types have been expanded (we don't want to do this too early)
+extern void Typecheck_Expressions_ValidateOne(const StaticTraitResolve& resolve, const ::std::vector<::std::pair< ::HIR::Pattern, ::HIR::TypeRef>>& args, const ::HIR::TypeRef& ret_ty, const ::HIR::ExprPtr& code, bool expand_erased_types=false);
 
 
@@ -1438,10 +1438,10 @@ namespace {
     };
 }
 
-void Typecheck_Expressions_ValidateOne(const StaticTraitResolve& resolve, const ::std::vector<::std::pair< ::HIR::Pattern, ::HIR::TypeRef>>& args, const ::HIR::TypeRef& ret_ty, const ::HIR::ExprPtr& code)
+void Typecheck_Expressions_ValidateOne(const StaticTraitResolve& resolve, const ::std::vector<::std::pair< ::HIR::Pattern, ::HIR::TypeRef>>& args, const ::HIR::TypeRef& ret_ty, const ::HIR::ExprPtr& code, bool expand_erased_types/*=false*/)
 {
     ExprVisitor_Validate    ev(resolve, args, ret_ty);
-    ev.expand_erased_types = false; // TODO: Make this an argument, we don't want to do this too early
+    ev.expand_erased_types = expand_erased_types;
     ev.visit_root( const_cast<::HIR::ExprPtr&>(code) );
 }
 
@@ -1740,6 +1740,41 @@ void Context::dump() const {
     DEBUG("---");
 }
 
+bool Context::rule_deps_changed(const RuleDeps& deps) const
+{
+    if( !deps.valid )
+        return true;
+    // NOTE: Value ivars are rare, so any change to one invalidates every rule
+    if( m_ivars.values_changed_since(deps.checked_at) )
+        return true;
+    for(auto ivar : deps.ivars)
+    {
+        if( m_ivars.ivar_changed_since(ivar, deps.checked_at) )
+            return true;
+    }
+    return false;
+}
+void Context::set_rule_deps(RuleDeps& deps, unsigned int stamp, const Coercion& rule) const
+{
+    deps.valid = true;
+    deps.checked_at = stamp;
+    deps.ivars.clear();
+    m_ivars.collect_ivars(rule.left_ty, deps.ivars);
+    m_ivars.collect_ivars((*rule.right_node_ptr)->m_res_type, deps.ivars);
+    deps.node = &**rule.right_node_ptr;
+}
+void Context::set_rule_deps(RuleDeps& deps, unsigned int stamp, const Associated& rule) const
+{
+    deps.valid = true;
+    deps.checked_at = stamp;
+    deps.ivars.clear();
+    if( rule.left_ty != ::HIR::TypeRef() )
+        m_ivars.collect_ivars(rule.left_ty, deps.ivars);
+    m_ivars.collect_ivars(rule.impl_ty, deps.ivars);
+    for(const auto& ty : rule.params.m_types)
+        m_ivars.collect_ivars(ty, deps.ivars);
+}
+
 void Context::equate_types(const Span& sp, const ::HIR::TypeRef& li, const ::HIR::TypeRef& ri) {
 
     if( li == ri || this->m_ivars.get_type(li) == this->m_ivars.get_type(ri) ) {
@@ -7045,12 +7080,22 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         // 1. Check coercions for ones that cannot coerce due to RHS type (e.g. `str` which doesn't coerce to anything)
         // 2. (???) Locate coercions that cannot coerce (due to being the only way to know a type)
         // - Keep a list in the ivar of what types that ivar could be equated to.
-        if( ! context.m_ivars.peek_changed() )
-        {
+        // NOTE: Rules are only re-checked if an ivar they mention has changed since their last check (`only_changed`).
+        // The ivar possibilities (needed once nothing changes) come from every rule, so a quiet pass re-checks them all.
+        auto check_rules = [&](bool only_changed)->bool {
+            bool skipped = false;
             DEBUG("--- Coercion checking");
             for(size_t i = 0; i < context.link_coerce.size(); )
             {
+                if( only_changed && !context.rule_deps_changed(context.link_coerce[i]->deps)
+                    && context.link_coerce[i]->deps.node == &**context.link_coerce[i]->right_node_ptr )
+                {
+                    skipped = true;
+                    ++ i;
+                    continue ;
+                }
                 auto ent = mv$(context.link_coerce[i]);
+                auto stamp = context.m_ivars.change_stamp();
                 const auto& span = (*ent->right_node_ptr)->span();
                 auto& src_ty = (*ent->right_node_ptr)->m_res_type;
                 src_ty = context.m_resolve.expand_associated_types( span, mv$(src_ty) );    // TODO: This was commented, why?
@@ -7063,6 +7108,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
                 }
                 else
                 {
+                    context.set_rule_deps(ent->deps, stamp, *ent);
                     context.link_coerce[i] = mv$(ent);
                     ++ i;
                 }
@@ -7071,34 +7117,44 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
             DEBUG("--- Associated types");
             unsigned int link_assoc_iter_limit = context.link_assoc.size() * 4;
             for(unsigned int i = 0; i < context.link_assoc.size(); ) {
-                // - Move out (and back in later) to avoid holding a bad pointer if the list is updated
-                auto rule = mv$(context.link_assoc[i]);
-
-                DEBUG("- " << rule);
-                for( auto& ty : rule.params.m_types ) {
-                    ty = context.m_resolve.expand_associated_types(rule.span, mv$(ty));
-                }
-                if( rule.name != "" ) {
-                    rule.left_ty = context.m_resolve.expand_associated_types(rule.span, mv$(rule.left_ty));
-                    // HACK: If the left type is `!`, remove the type bound
-                    //if( rule.left_ty.data().is_Diverge() ) {
-                    //    rule.name = "";
-                    //}
+                if( only_changed && !context.rule_deps_changed(context.link_assoc[i].deps) )
+                {
+                    skipped = true;
+                    i ++;
                 }
-                rule.impl_ty = context.m_resolve.expand_associated_types(rule.span, mv$(rule.impl_ty));
+                else
+                {
+                    // - Move out (and back in later) to avoid holding a bad pointer if the list is updated
+                    auto rule = mv$(context.link_assoc[i]);
+                    auto stamp = context.m_ivars.change_stamp();
 
-                if( check_associated(context, rule) ) {
-                    DEBUG("- Consumed associated type rule " << i << "/" << context.link_assoc.size() << " - " << rule);
-                    if( i != context.link_assoc.size()-1 )
-                    {
-                        //assert( context.link_assoc[i] != context.link_assoc.back() );
-                        context.link_assoc[i] = mv$( context.link_assoc.back() );
+                    DEBUG("- " << rule);
+                    for( auto& ty : rule.params.m_types ) {
+                        ty = context.m_resolve.expand_associated_types(rule.span, mv$(ty));
+                    }
+                    if( rule.name != "" ) {
+                        rule.left_ty = context.m_resolve.expand_associated_types(rule.span, mv$(rule.left_ty));
+                        // HACK: If the left type is `!`, remove the type bound
+                        //if( rule.left_ty.data().is_Diverge() ) {
+                        //    rule.name = "";
+                        //}
+                    }
+                    rule.impl_ty = context.m_resolve.expand_associated_types(rule.span, mv$(rule.impl_ty));
+
+                    if( check_associated(context, rule) ) {
+                        DEBUG("- Consumed associated type rule " << i << "/" << context.link_assoc.size() << " - " << rule);
+                        if( i != context.link_assoc.size()-1 )
+                        {
+                            //assert( context.link_assoc[i] != context.link_assoc.back() );
+                            context.link_assoc[i] = mv$( context.link_assoc.back() );
+                        }
+                        context.link_assoc.pop_back();
+                    }
+                    else {
+                        context.set_rule_deps(rule.deps, stamp, rule);
+                        context.link_assoc[i] = mv$(rule);
+                        i ++;
                     }
-                    context.link_assoc.pop_back();
-                }
-                else {
-                    context.link_assoc[i] = mv$(rule);
-                    i ++;
                 }
 
                 if( link_assoc_iter_limit -- == 0 )
@@ -7107,6 +7163,19 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
                     break;
                 }
             }
+            return skipped;
+            };
+        if( ! context.m_ivars.peek_changed() )
+        {
+            if( check_rules(/*only_changed=*/true) && ! context.m_ivars.peek_changed() )
+            {
+                DEBUG("--- No changes, re-checking all rules");
+                for(auto& ivar_ent : context.possible_ivar_vals)
+                {
+                    ivar_ent.reset();
+                }
+                check_rules(/*only_changed=*/false);
+            }
         }
         // 4. Revisit nodes that require revisiting
         if( ! context.m_ivars.peek_changed() )
@@ -32,12 +32,25 @@ struct Context
         //unsigned int ivar;
     };
 
+    /// What a rule looked at when it was last checked (so it's only re-checked once one of those has changed)
+    struct RuleDeps
+    {
+        bool    valid = false;
+        /// `HMTypeInferrence::change_stamp` just before the check
+        unsigned int    checked_at = 0;
+        /// Ivars mentioned by the rule's types
+        ::std::vector<unsigned int> ivars;
+        /// For coercions, the source node (revisits can replace it)
+        const ::HIR::ExprNode*  node = nullptr;
+    };
+
     /// Inferrence variable equalities
     struct Coercion
     {
         unsigned rule_idx;
         ::HIR::TypeRef  left_ty;
         ::HIR::ExprNodeP* right_node_ptr;
+        RuleDeps    deps;
 
         friend ::std::ostream& operator<<(::std::ostream& os, const Coercion& v) {
             os << "R" << v.rule_idx << " " << v.left_ty << " := " << v.right_node_ptr << " " << &**v.right_node_ptr << " (" << (*v.right_node_ptr)->m_res_type << ")";
@@ -58,6 +71,8 @@ struct Context
                             // HACK: operators are special - the result when both types are primitives is ALWAYS the lefthand side
         bool    is_operator;
 
+        RuleDeps    deps;
+
         friend ::std::ostream& operator<<(::std::ostream& os, const Associated& v) {
             os << "R" << v.rule_idx << " ";
             if( v.name == "" ) {
@@ -166,6 +181,12 @@ struct Context
 
     void dump() const;
 
+    /// Check if anything a rule depends on has changed since it was last checked
+    bool rule_deps_changed(const RuleDeps& deps) const;
+    /// Record the dependencies of a rule after checking it (`stamp` is the ivar change stamp from before the check)
+    void set_rule_deps(RuleDeps& deps, unsigned int stamp, const Coercion& rule) const;
+    void set_rule_deps(RuleDeps& deps, unsigned int stamp, const Associated& rule) const;
+
     bool take_changed() { return m_ivars.take_changed(); }
     bool has_rules() const {
         return !(link_coerce.empty() && link_assoc.empty() && to_visit.empty() && adv_revisits.empty());
@@ -69,8 +69,8 @@ void HMTypeInferrence::check_for_loops()
                 if( const auto* ep = t.data().opt_Infer() ) {
                     const auto& e = *ep;
                     for(auto idx : m_indexes)
-                        ASSERT_BUG(Span(), e.index != idx, "Recursion in ivar #" << m_indexes.front() << " " << *ivars.m_ivars[m_indexes.front()].type
-                            << " - loop with " << idx << " " << *ivars.m_ivars[idx].type);
+                        ASSERT_BUG(Span(), e.index != idx, "Recursion in ivar #" << m_indexes.front() << " " << ivars.get_type(m_indexes.front())
+                            << " - loop with " << idx << " " << ivars.get_type(idx));
                     const auto& ivd = ivars.get_pointed_ivar(e.index);
                     assert( !ivd.is_alias() );
                     if( !ivd.type->data().is_Infer() ) {
@@ -204,20 +204,7 @@ void HMTypeInferrence::compact_ivars()
             *v.type = mv$(nt);
         }
         else {
-
-            auto index = v.alias;
-            unsigned int count = 0;
-            assert(index < m_ivars.size());
-            while( m_ivars.at(index).is_alias() ) {
-                index = m_ivars.at(index).alias;
-
-                if( count >= m_ivars.size() ) {
-                    this->dump();
-                    BUG(Span(), "Loop detected in ivar list when starting at " << v.alias << ", current is " << index);
-                }
-                count ++;
-            }
-            v.alias = index;
+            v.alias = this->get_root_ivar(v.alias);
         }
         i ++;
     }
@@ -239,11 +226,13 @@ bool HMTypeInferrence::apply_defaults()
                     rv = true;
                     DEBUG("- IVar " << e->index << " = i32");
                     *v.type = ::HIR::TypeRef( ::HIR::CoreType::I32 );
+                    v.change_stamp = ++m_change_stamp;
                     break;
                 case ::HIR::InferClass::Float:
                     rv = true;
                     DEBUG("- IVar " << e->index << " = f64");
                     *v.type = ::HIR::TypeRef( ::HIR::CoreType::F64 );
+                    v.change_stamp = ++m_change_stamp;
                     break;
                 }
             }
@@ -450,6 +439,9 @@ void HMTypeInferrence::expand_ivars(::HIR::TypeRef& type)
             )
         }
     };
+    // Nothing to expand (and avoids the `data_mut` below)
+    if( !type.contains_ivars() )
+        return ;
     TU_MATCH_HDRA( (type.data_mut()), {)
     TU_ARMA(Infer, e) {
         const auto& t = this->get_type(type);
@@ -647,6 +639,7 @@ void HMTypeInferrence::set_ivar_val_to(unsigned int slot, ::HIR::ConstGeneric va
         ASSERT_BUG(Span(), m_values[slot].val->is_Infer(), "slot " << slot << " - " << *m_values[slot].val);
         ASSERT_BUG(Span(), m_values[slot].val->as_Infer().index == slot, "slot " << slot << " - " << *m_values[slot].val);
         *m_values[slot].val = std::move(val);
+        m_values_stamp = ++m_change_stamp;
     }
 }
 void HMTypeInferrence::ivar_val_unify(unsigned int left_slot, unsigned int right_slot)
@@ -662,6 +655,7 @@ void HMTypeInferrence::ivar_val_unify(unsigned int left_slot, unsigned int right
         DEBUG("Set ValIVar " << right_slot << " = @" << left_slot);
         m_values[right_slot].alias = left_slot;
         m_values[right_slot].val.reset();
+        m_values_stamp = ++m_change_stamp;
 
         this->mark_change();
     }
@@ -733,9 +727,12 @@ void HMTypeInferrence::set_ivar_to(unsigned int slot, ::HIR::TypeRef type)
         #if 1
         // Alias `l_e.index` to this slot
         DEBUG("Set IVar " << l_e->index << " = @" << slot);
-        auto& r_ivar = this->get_pointed_ivar(l_e->index);
-        r_ivar.alias = slot;
-        r_ivar.type.reset();
+        auto r_root = this->get_root_ivar(l_e->index);
+        auto l_root = this->get_root_ivar(slot);
+        if( r_root == l_root ) {
+            return ;
+        }
+        this->link_ivars(l_root, r_root);
         #else
         DEBUG("Set IVar " << slot << " = @" << l_e->index);
         root_ivar.alias = l_e->index;
@@ -779,6 +776,7 @@ void HMTypeInferrence::set_ivar_to(unsigned int slot, ::HIR::TypeRef type)
         }
 
         root_ivar.type = box$( type );
+        root_ivar.change_stamp = ++m_change_stamp;
     }
 
     this->mark_change();
@@ -787,12 +785,12 @@ void HMTypeInferrence::set_ivar_to(unsigned int slot, ::HIR::TypeRef type)
 void HMTypeInferrence::ivar_unify(unsigned int left_slot, unsigned int right_slot)
 {
     auto sp = Span();
-    if( left_slot != right_slot )
+    auto left_root = this->get_root_ivar(left_slot);
+    auto right_root = this->get_root_ivar(right_slot);
+    if( left_root != right_root )
     {
-        auto& left_ivar = this->get_pointed_ivar(left_slot);
-
-        // TODO: Assert that setting this won't cause a loop.
-        auto& root_ivar = this->get_pointed_ivar(right_slot);
+        auto& left_ivar = m_ivars[left_root];
+        auto& root_ivar = m_ivars[right_root];
 
         if( const auto* re = root_ivar.type->data().opt_Infer() )
         {
@@ -828,8 +826,7 @@ void HMTypeInferrence::ivar_unify(unsigned int left_slot, unsigned int right_slo
         }
 
         DEBUG("IVar " << root_ivar.type->data().as_Infer().index << " = @" << left_slot);
-        root_ivar.alias = left_slot;
-        root_ivar.type.reset();
+        this->link_ivars(left_root, right_root);
 
         this->mark_change();
     }
@@ -866,21 +863,91 @@ const ::HIR::ConstGeneric& HMTypeInferrence::get_value(unsigned slot) const
 }
 
 
-HMTypeInferrence::IVar& HMTypeInferrence::get_pointed_ivar(unsigned int slot) const
+unsigned int HMTypeInferrence::get_root_ivar(unsigned int slot) const
 {
-    auto index = slot;
+    ASSERT_BUG(Span(), slot < m_ivars.size(), "IVar " << slot << " out of range (" << m_ivars.size() << ")");
+    // Fast path: already a root, or a direct child of one
+    const auto* ivars = m_ivars.data();
+    if( !ivars[slot].is_alias() )
+        return slot;
+    auto root = ivars[slot].alias;
+    if( !ivars[root].is_alias() )
+        return root;
+
+    // Find the root (bounded by the union-by-rank height, but checked anyway in case a bug created a loop)
     unsigned int count = 0;
-    assert(index < m_ivars.size());
-    while( m_ivars.at(index).is_alias() ) {
-        index = m_ivars.at(index).alias;
+    while( ivars[root].is_alias() ) {
+        root = ivars[root].alias;
 
         if( count >= m_ivars.size() ) {
             this->dump();
-            BUG(Span(), "Loop detected in ivar list when starting at " << slot << ", current is " << index);
+            BUG(Span(), "Loop detected in ivar list when starting at " << slot << ", current is " << root);
         }
         count ++;
     }
-    return const_cast<IVar&>(m_ivars.at(index));
+    // Compress the path, so later lookups are a single hop
+    for(auto index = slot; index != root; )
+    {
+        auto next = ivars[index].alias;
+        ivars[index].alias = root;
+        index = next;
+    }
+    return root;
+}
+HMTypeInferrence::IVar& HMTypeInferrence::get_pointed_ivar(unsigned int slot) const
+{
+    return const_cast<IVar&>(m_ivars[this->get_root_ivar(slot)]);
+}
+/// Merge the set rooted at `other_root` into the set rooted at `keep_root`, keeping the type (and thus identity) of `keep_root`
+void HMTypeInferrence::link_ivars(unsigned int keep_root, unsigned int other_root)
+{
+    assert(keep_root != other_root);
+    auto& keep = m_ivars[keep_root];
+    auto& other = m_ivars[other_root];
+    assert(!keep.is_alias() && !other.is_alias());
+    if( keep.rank < other.rank )
+    {
+        // The other tree is taller, so it becomes the root (with this set's type moved over)
+        keep.alias = other_root;
+        other.type = mv$(keep.type);
+        other.change_stamp = ++m_change_stamp;
+    }
+    else
+    {
+        other.alias = keep_root;
+        other.type.reset();
+        if( keep.rank == other.rank )
+            keep.rank += 1;
+        keep.change_stamp = ++m_change_stamp;
+    }
+}
+
+bool HMTypeInferrence::ivar_changed_since(unsigned int slot, unsigned int stamp) const
+{
+    return m_ivars[this->get_root_ivar(slot)].change_stamp > stamp;
+}
+void HMTypeInferrence::mark_ivar_changed(unsigned int slot)
+{
+    this->get_pointed_ivar(slot).change_stamp = ++m_change_stamp;
+}
+void HMTypeInferrence::collect_ivars(const ::HIR::TypeRef& ty, ::std::vector<unsigned int>& out) const
+{
+    if( !ty.contains_ivars() )
+        return ;
+    visit_ty_with(ty, [&](const ::HIR::TypeRef& t) {
+        if( const auto* e = t.data().opt_Infer() )
+        {
+            if( e->index == ~0u )
+                return false;
+            out.push_back(e->index);
+            const auto& rt = this->get_type(e->index);
+            if( !rt.data().is_Infer() )
+            {
+                this->collect_ivars(rt, out);
+            }
+        }
+        return false;
+        });
 }
 
 bool HMTypeInferrence::pathparams_contain_ivars(const ::HIR::PathParams& pps) const {
@@ -891,6 +958,8 @@ bool HMTypeInferrence::pathparams_contain_ivars(const ::HIR::PathParams& pps) co
     return false;
 }
 bool HMTypeInferrence::type_contains_ivars(const ::HIR::TypeRef& ty) const {
+    if( !ty.contains_ivars() )
+        return false;
     TRACE_FUNCTION_F("ty = " << ty);
     //TU_MATCH(::HIR::TypeData, (this->get_type(ty).m_data), (e),
     TU_MATCH(::HIR::TypeData, (ty.data()), (e),
@@ -1748,24 +1817,15 @@ void TraitResolution::compact_ivars(HMTypeInferrence& m_ivars)
                 // TODO: cloning is expensive, BUT printing below is nice
                 auto nt = this->expand_associated_types(Span(), v.type->clone());
                 DEBUG("- " << i << " " << *v.type << " -> " << nt);
+                if( nt != *v.type ) {
+                    m_ivars.mark_ivar_changed(i);
+                }
                 *v.type = mv$(nt);
             }
         }
         else {
-
-            auto index = v.alias;
-            unsigned int count = 0;
-            assert(index < m_ivars.m_ivars.size());
-            while( m_ivars.m_ivars.at(index).is_alias() ) {
-                index = m_ivars.m_ivars.at(index).alias;
-
-                if( count >= m_ivars.m_ivars.size() ) {
-                    this->m_ivars.dump();
-                    BUG(Span(), "Loop detected in ivar list when starting at " << v.alias << ", current is " << index);
-                }
-                count ++;
-            }
-            v.alias = index;
+            // Lookup compresses the path
+            m_ivars.get_type(i);
         }
         i ++;
     }
@@ -1810,6 +1870,9 @@ bool TraitResolution::has_associated_type(const ::HIR::TypeRef& input) const
         }
     };
     //TRACE_FUNCTION_F(input);
+    // Quick check: Only UFCS paths (or ivars that might be UFCS paths) can be associated types
+    if( (input.flags() & (::HIR::TypeRef::FLAG_UFCS|::HIR::TypeRef::FLAG_INFER)) == 0 )
+        return false;
     TU_MATCH_HDRA( (input.data()), {)
     TU_ARMA(Infer, e) {
         const auto& ty = this->m_ivars.get_type(input);
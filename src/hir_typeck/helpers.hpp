@@ -55,14 +55,20 @@ public:
     };
 
 public: // ?? - Needed once, anymore?
+    // NOTE: The ivars form a union-find forest. The `alias` links are compressed on lookup, and sets are joined by rank.
+    // The root of a set isn't necessarily the ivar named by its type (the `Infer` index in `type` is the set's identity).
     struct IVar
     {
         //bool could_be_diverge;
-        unsigned int alias; // If not ~0, this points to another ivar
+        mutable unsigned int alias; // If not ~0, this points to another ivar
+        uint8_t rank;   // Upper bound on the height of the tree under this ivar (only meaningful if not an alias)
+        unsigned int change_stamp;  // Value of `m_change_stamp` when this set was last changed (only meaningful if not an alias)
         ::std::unique_ptr< ::HIR::TypeRef> type;    // Type (only nullptr if alias!=0)
 
         IVar():
             alias(~0u),
+            rank(0),
+            change_stamp(0),
             type(new ::HIR::TypeRef())
         {}
         bool is_alias() const { return alias != ~0u; }
@@ -81,10 +87,16 @@ public: // ?? - Needed once, anymore?
     ::std::vector< IVarValue>    m_values;
 
     bool    m_has_changed;
+    /// Counter bumped on every ivar change (used to tell if an ivar has changed since a rule last looked at it)
+    unsigned int    m_change_stamp;
+    /// Stamp of the last change to any value ivar
+    unsigned int    m_values_stamp;
 
 public:
     HMTypeInferrence():
         m_has_changed(false)
+        ,m_change_stamp(0)
+        ,m_values_stamp(0)
     {}
 
     bool peek_changed() const {
@@ -155,6 +167,16 @@ public:
     const ::HIR::ConstGeneric& get_value(const ::HIR::ConstGeneric& val) const;
     const ::HIR::ConstGeneric& get_value(unsigned idx) const;
 
+    // Change tracking
+    unsigned int change_stamp() const { return m_change_stamp; }
+    /// Returns true if the ivar (or anything unified with it) has been changed since `stamp` was obtained
+    bool ivar_changed_since(unsigned int slot, unsigned int stamp) const;
+    bool values_changed_since(unsigned int stamp) const { return m_values_stamp > stamp; }
+    /// Record an in-place change to an ivar's type (e.g. expansion of associated types)
+    void mark_ivar_changed(unsigned int slot);
+    /// Append the indexes of all ivars referenced by `ty` (looking through known ivars) to `out`
+    void collect_ivars(const ::HIR::TypeRef& ty, ::std::vector<unsigned int>& out) const;
+
     void check_for_loops();
     void expand_ivars(::HIR::TypeRef& type);
     void expand_ivars_params(::HIR::PathParams& params);
@@ -165,7 +187,9 @@ public:
     bool pathparams_equal(const ::HIR::PathParams& pps_l, const ::HIR::PathParams& pps_r) const;
     bool types_equal(const ::HIR::TypeRef& l, const ::HIR::TypeRef& r) const;
 private:
+    unsigned int get_root_ivar(unsigned int slot) const;
     IVar& get_pointed_ivar(unsigned int slot) const;
+    void link_ivars(unsigned int keep_root, unsigned int other_root);
 };
 
 class TraitResolution:
@@ -75,7 +75,7 @@ bool StaticTraitResolve::find_impl(
             }
             else {
             }
-            static ::HIR::TraitPath::assoc_list_t   assoc_unit;
+            thread_local static ::HIR::TraitPath::assoc_list_t   assoc_unit;
             if(assoc_unit.empty()) {
                 assoc_unit.insert(std::make_pair( RcString::new_interned("Discriminant"), HIR::TraitPath::AtyEqual {
                     m_lang_DiscriminantKind,
@@ -85,9 +85,9 @@ bool StaticTraitResolve::find_impl(
             return found_cb( ImplRef(&type, trait_params, &assoc_unit), false );
         }
         else if( TARGETVER_LEAST_1_54 && trait_path == m_lang_Pointee ) {
-            static ::HIR::TraitPath::assoc_list_t   assoc_unit;
-            static ::HIR::TraitPath::assoc_list_t   assoc_slice;
-            static RcString name_Metadata;
+            thread_local static ::HIR::TraitPath::assoc_list_t   assoc_unit;
+            thread_local static ::HIR::TraitPath::assoc_list_t   assoc_slice;
+            thread_local static RcString name_Metadata;
             if(assoc_unit.empty()) {
                 name_Metadata = RcString::new_interned("Metadata");
                 assoc_unit.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
@@ -498,7 +498,7 @@ bool StaticTraitResolve::find_impl(
             return rv;
 
         // Detect recursion and return true if detected
-        static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
+        thread_local static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
         for(const auto& ent : stack ) {
             if( *::std::get<0>(ent) != trait_path )
                 continue ;
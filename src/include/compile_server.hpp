@@ -0,0 +1,22 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/compile_server.hpp
+ * - Persistent compile server (keeps loaded crates resident between compilations)
+ */
+#pragma once
+#include <string>
+
+namespace HIR {
+    class CratePtr;
+}
+
+/// Run the compile server (`mrustc --server <socket>`), calling `compile` in a forked child for each request
+///
+/// Each request is an argument list (plus the client's working directory, environment, and stdout/stderr). Crates
+/// loaded by a compilation are then loaded by the server, so later compilations get them without deserialising.
+extern int CompileServer_Run(const char* socket_path, int (*compile)(int argc, char* argv[]));
+
+/// Load the crate metadata for `path` (a copy already resident in the server, or from disk)
+extern ::HIR::CratePtr CompileServer_LoadCrate(const ::std::string& path);
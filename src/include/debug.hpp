@@ -12,7 +12,7 @@
 #include <cassert>
 #include <functional>
 
-extern int g_debug_indent_level;
+extern thread_local int g_debug_indent_level;
 
 #ifndef DEBUG_EXTRA_ENABLE
 # define DEBUG_EXTRA_ENABLE  // Files can override this with their own flag if needed (e.g. `&& g_my_debug_on`)
@@ -37,6 +37,12 @@ extern int g_debug_indent_level;
 
 extern bool debug_enabled();
 extern ::std::ostream& debug_output(int indent, const char* function);
+/// Unprefixed debug output for this thread (e.g. for dumping a whole function), handed off when flushed
+extern ::std::ostream& debug_stream();
+/// Send this thread's printed debug output to `os` instead of `std::cout` (null to restore), returns the previous sink
+extern ::std::ostream* debug_set_thread_sink(::std::ostream* os);
+/// Print this thread's recent debug history (if the ring buffer is enabled by `MRUSTC_DEBUG_RING`)
+extern void debug_dump_trace(::std::ostream& os);
 
 template<class T>
 inline const char* typeid_name(const T & t) { return typeid(t).name(); }
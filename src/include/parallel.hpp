@@ -0,0 +1,34 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/parallel.hpp
+ * - Running independent per-item work on multiple threads
+ */
+#pragma once
+#include <functional>
+#include <ostream>
+
+namespace parallel {
+
+/// Set the number of worker threads used by `for_each` (1 disables threading)
+extern void set_num_jobs(unsigned n);
+extern unsigned num_jobs();
+
+/// Returns true if the current thread is running a job from `for_each` on a worker thread
+extern bool in_worker();
+
+/// Run `cb(i)` for every `i` in `0 .. count`
+///
+/// With more than one job the items are run by a set of worker threads. Diagnostics and debug output from each item
+/// are buffered and printed in item order once all items are done, and if an item hits a fatal error the output (and
+/// the error) is the same as a serial run would produce.
+extern void for_each(size_t count, ::std::function<void(size_t)> cb);
+
+/// Stream that diagnostics should be printed to (the current item's buffer, or `std::cerr`)
+extern ::std::ostream& diag_stream();
+/// Called after a fatal diagnostic has been printed to `diag_stream` (prints the recent debug trace, then aborts or
+/// unwinds the current item)
+[[noreturn]] extern void fatal_error();
+
+}   // namespace parallel
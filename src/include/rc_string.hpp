@@ -9,12 +9,13 @@
 
 #include <cstring>
 #include <ostream>
+#include <atomic>
 #include "../common.hpp"
 
 class RcString
 {
     struct Inner {
-        unsigned int    refcount;
+        ::std::atomic<unsigned int> refcount;
         unsigned int    size;
         unsigned int    ordering;   // Populated only for interned strings, 0 otherwise
         unsigned int    data[1];    // Actually arbitary
@@ -34,6 +35,9 @@ public:
     }
 
     static RcString new_interned(const char* s, size_t len);
+    /// Mark that other threads may be using (and interning) strings, which stops the interned ordering cache from
+    /// being re-built (as other threads could be reading it)
+    static void set_threaded(bool is_threaded);
     static RcString new_interned(const ::std::string& s) {
         return new_interned(s.data(), s.size());
     }
@@ -44,7 +48,7 @@ public:
     RcString(const RcString& x):
         m_ptr(x.m_ptr)
     {
-        if( m_ptr ) m_ptr->refcount += 1;
+        if( m_ptr ) m_ptr->refcount.fetch_add(1, ::std::memory_order_relaxed);
     }
     RcString(RcString&& x):
         m_ptr(x.m_ptr)
@@ -60,7 +64,7 @@ public:
         {
             this->~RcString();
             m_ptr = x.m_ptr;
-            if( m_ptr ) m_ptr->refcount += 1;
+            if( m_ptr ) m_ptr->refcount.fetch_add(1, ::std::memory_order_relaxed);
         }
         return *this;
     }
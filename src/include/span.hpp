@@ -10,6 +10,7 @@
 #include <rc_string.hpp>
 #include <functional>
 #include <memory>
+#include <atomic>
 
 enum ErrorType
 {
@@ -80,7 +81,7 @@ struct SpanInner
 {
     friend struct Span;
 private:
-    size_t  reference_count;
+    ::std::atomic<size_t>   reference_count;
 public:
     Span    parent_span;
     RcString    filename;
@@ -17,6 +17,7 @@
 #include "ast/ast.hpp"
 #include "ast/crate.hpp"
 #include <cstring>
+#include <cstdlib>  // strtoul
 #include <main_bindings.hpp>
 #include "resolve/main_bindings.hpp"
 #include "hir/main_bindings.hpp"
@@ -30,6 +31,8 @@
 #include "expand/cfg.hpp"
 #include <target_detect.h>	// tools/common/target_detect.h
 #include <debug_inner.hpp>
+#include <parallel.hpp>
+#include <compile_server.hpp>
 
 #ifdef _WIN32
 # define NOGDI
@@ -57,6 +60,9 @@ struct ProgramParams
     ::std::string   target = DEFAULT_TARGET_NAME;
 
     ::std::string   emit_depfile;
+    // Created once the crate metadata (.hir) has been written, so a build system can start dependent crates while
+    // the C compiler is still running
+    ::std::string   emit_metadata_ready;
 
     AST::Edition      edition = AST::Edition::Rust2015;
     ::AST::Crate::Type  crate_type = ::AST::Crate::Type::Unknown;
@@ -68,6 +74,9 @@ struct ProgramParams
 
     bool test_harness = false;
 
+    // Worker threads for the per-body passes (see `parallel::for_each`)
+    unsigned num_jobs = 1;
+
     // NOTE: If populated, nothing happens except for loading the target
     ::std::string   target_saveback;
     // NOTE: if true, no parse/compilation performed (target is loaded though)
@@ -83,6 +92,7 @@ struct ProgramParams
         bool disable_mir_optimisations = false;
         bool full_validate = false;
         bool full_validate_early = false;
+        bool fused_expand = false;
 
         bool dump_ast = false;
         bool dump_hir = false;
@@ -92,6 +102,7 @@ struct ProgramParams
         ::std::string   codegen_type;
         ::std::string   emit_build_command;
         ::std::string   panic_type;
+        bool structured_c = false;
     } codegen;
 
     ProgramParams(int argc, char *argv[]);
@@ -146,6 +157,7 @@ void init_debug_list()
         "Expand HIR Reborrows",
         "Expand HIR ErasedType",
         "Typecheck Expressions (validate)",
+        "Expand HIR",
 
         "Dump HIR",
         "Lower MIR",
@@ -166,6 +178,8 @@ void init_debug_list()
         "Trans Monomorph PM",
         "MIR Optimise Inline PM",
         "MIR Optimise Inline",
+        "Trans Fold Identical PM",
+        "Trans Fold Identical",
         "Trans Enumerate Cleanup",
         "Trans Codegen"
         });
@@ -228,11 +242,28 @@ void memory_dump(const char* phase) {
     }
 }
 
+static int main_compile(int argc, char *argv[]);
+
 /// main!
 int main(int argc, char *argv[])
+{
+    // Persistent compile server (runs `main_compile` for each request)
+    if( argc >= 2 && ::std::strcmp(argv[1], "--server") == 0 )
+    {
+        if( argc != 3 ) {
+            ::std::cerr << "Usage: " << argv[0] << " --server <socket path>" << ::std::endl;
+            return 1;
+        }
+        return CompileServer_Run(argv[2], main_compile);
+    }
+    return main_compile(argc, argv);
+}
+
+static int main_compile(int argc, char *argv[])
 {
     init_debug_list();
     ProgramParams   params(argc, argv);
+    parallel::set_num_jobs(params.num_jobs);
 
     // Set up cfg values
     CompilePhaseV("Setup", [&]() {
@@ -613,6 +644,7 @@ int main(int argc, char *argv[])
         // Basic constant evalulation (intergers/floats only)
         CompilePhaseV("Constant Evaluate", [&]() {
             ConvertHIR_ConstantEvaluate(*hir_crate);
+            ConvertHIR_ConstantEvaluate_PrintStats();
             });
 
         if( params.debug.dump_hir )
@@ -637,46 +669,63 @@ int main(int argc, char *argv[])
             Typecheck_Expressions(*hir_crate);
             });
         // === HIR Expansion ===
-        // Annotate how each node's result is used
-        CompilePhaseV("Expand HIR Annotate", [&]() {
-            HIR_Expand_AnnotateUsage(*hir_crate);
-            });
-        CompilePhaseV("Expand HIR Static Borrow", [&]() {
-            HIR_Expand_StaticBorrowConstants(*hir_crate);
-            });
-        // - Now that all types are known, closures can be desugared
-        CompilePhaseV("Expand HIR Closures", [&]() {
-            HIR_Expand_Closures(*hir_crate);
-            });
-        // - Construct VTables for all traits and impls.
-        //  TODO: How early can this be done?
-        //  > Requires consteval completed for types to be fully valid?
-        //  TODO: Would prefer to have this done before consteval, as consteval might reference a vtable
-        CompilePhaseV("Expand HIR VTables", [&]() {
-            HIR_Expand_VTables(*hir_crate);
-            });
-        // - And calls can be turned into UFCS
-        CompilePhaseV("Expand HIR Calls", [&]() {
-            HIR_Expand_UfcsEverything(*hir_crate);
-            });
-        CompilePhaseV("Expand HIR Reborrows", [&]() {
-            HIR_Expand_Reborrows(*hir_crate);
-            });
-        CompilePhaseV("Expand HIR ErasedType", [&]() {
-            HIR_Expand_ErasedType(*hir_crate);
-            });
-        if( params.debug.dump_hir )
+        if( params.debug.fused_expand )
         {
-            // DUMP after typecheck (before validation)
-            CompilePhaseV("Dump HIR", [&]() {
-                ::std::ofstream os (FMT(params.outfile << "_2_hir.rs"));
-                HIR_Dump( os, *hir_crate );
+            // All of the below, run on one body at a time
+            CompilePhaseV("Expand HIR", [&]() {
+                HIR_Expand_Fused(*hir_crate);
+                });
+            if( params.debug.dump_hir )
+            {
+                CompilePhaseV("Dump HIR", [&]() {
+                    ::std::ofstream os (FMT(params.outfile << "_2_hir.rs"));
+                    HIR_Dump( os, *hir_crate );
+                    });
+            }
+        }
+        else
+        {
+            // Annotate how each node's result is used
+            CompilePhaseV("Expand HIR Annotate", [&]() {
+                HIR_Expand_AnnotateUsage(*hir_crate);
+                });
+            CompilePhaseV("Expand HIR Static Borrow", [&]() {
+                HIR_Expand_StaticBorrowConstants(*hir_crate);
+                });
+            // - Now that all types are known, closures can be desugared
+            CompilePhaseV("Expand HIR Closures", [&]() {
+                HIR_Expand_Closures(*hir_crate);
+                });
+            // - Construct VTables for all traits and impls.
+            //  TODO: How early can this be done?
+            //  > Requires consteval completed for types to be fully valid?
+            //  TODO: Would prefer to have this done before consteval, as consteval might reference a vtable
+            CompilePhaseV("Expand HIR VTables", [&]() {
+                HIR_Expand_VTables(*hir_crate);
+                });
+            // - And calls can be turned into UFCS
+            CompilePhaseV("Expand HIR Calls", [&]() {
+                HIR_Expand_UfcsEverything(*hir_crate);
+                });
+            CompilePhaseV("Expand HIR Reborrows", [&]() {
+                HIR_Expand_Reborrows(*hir_crate);
+                });
+            CompilePhaseV("Expand HIR ErasedType", [&]() {
+                HIR_Expand_ErasedType(*hir_crate);
+                });
+            if( params.debug.dump_hir )
+            {
+                // DUMP after typecheck (before validation)
+                CompilePhaseV("Dump HIR", [&]() {
+                    ::std::ofstream os (FMT(params.outfile << "_2_hir.rs"));
+                    HIR_Dump( os, *hir_crate );
+                    });
+            }
+            // - Ensure that typeck worked (including Fn trait call insertion etc)
+            CompilePhaseV("Typecheck Expressions (validate)", [&]() {
+                Typecheck_Expressions_Validate(*hir_crate);
                 });
         }
-        // - Ensure that typeck worked (including Fn trait call insertion etc)
-        CompilePhaseV("Typecheck Expressions (validate)", [&]() {
-            Typecheck_Expressions_Validate(*hir_crate);
-            });
 
         if( params.last_stage == ProgramParams::STAGE_TYPECK ) {
             return 0;
@@ -750,6 +799,7 @@ int main(int argc, char *argv[])
         trans_opt.mode = params.codegen.codegen_type == "" ? "c" : params.codegen.codegen_type;
         trans_opt.build_command_file = params.codegen.emit_build_command;
         trans_opt.opt_level = params.opt_level;
+        trans_opt.structured_c = params.codegen.structured_c;
         trans_opt.panic_crate = params.codegen.panic_type == "" ? "panic_abort" : "panic_"+params.codegen.panic_type;
         for(const char* libdir : params.lib_search_dirs ) {
             // Store these paths for use in final linking.
@@ -780,12 +830,12 @@ int main(int argc, char *argv[])
             case ::AST::Crate::Type::RustLib:
             case ::AST::Crate::Type::RustDylib:
             case ::AST::Crate::Type::CDylib:
-                return Trans_Enumerate_Public(*hir_crate);
+                return Trans_Enumerate_Public(*hir_crate, !params.debug.disable_mir_optimisations);
             case ::AST::Crate::Type::ProcMacro:
                 // TODO: proc macros enumerate twice, once as a library (why?) and again as an executable
-                return Trans_Enumerate_Public(*hir_crate);
+                return Trans_Enumerate_Public(*hir_crate, !params.debug.disable_mir_optimisations);
             case ::AST::Crate::Type::Executable:
-                return Trans_Enumerate_Main(*hir_crate);
+                return Trans_Enumerate_Main(*hir_crate, !params.debug.disable_mir_optimisations);
             }
             throw ::std::runtime_error("Invalid crate_type value");
             });
@@ -795,14 +845,36 @@ int main(int argc, char *argv[])
             Trans_AutoImpls(*hir_crate, items);
             });
         // - Generate monomorphised versions of all functions
-        CompilePhaseV("Trans Monomorph", [&]() { Trans_Monomorphise_List(*hir_crate, items); });
+        CompilePhaseV("Trans Monomorph", [&]() {
+            Trans_Monomorphise_List(*hir_crate, items);
+            ConvertHIR_ConstantEvaluate_PrintStats();
+            });
         // - Do post-monomorph inlining
         CompilePhaseV("MIR Optimise Inline", [&]() { MIR_OptimiseCrate_Inlining(*hir_crate, items); });
+        // - Replace duplicated monomorphised functions with calls to a single copy
+        if( !params.debug.disable_mir_optimisations ) {
+            CompilePhaseV("Trans Fold Identical", [&]() { Trans_FoldIdentical(*hir_crate, items); });
+        }
         // - Clean up no-unused functions
         CompilePhaseV("Trans Enumerate Cleanup", [&]() { Trans_Enumerate_Cleanup(*hir_crate, items); });
 
         memory_dump("Trans");
 
+        // Tell the build system that the metadata is complete (the rest of the build doesn't change it)
+        // - The output file is (re-)created too, as dependents open it to find the metadata (and check its timestamp)
+        auto signal_metadata_ready = [&]() {
+            if( params.emit_metadata_ready != "" )
+            {
+                ::std::ofstream { params.outfile };
+                ::std::ofstream of { params.emit_metadata_ready };
+                if( !of.good() )
+                {
+                    ::std::cerr << "Unable to create " << params.emit_metadata_ready << ::std::endl;
+                    exit(1);
+                }
+            }
+            };
+
         switch(crate_type)
         {
         case ::AST::Crate::Type::Unknown:
@@ -810,6 +882,7 @@ int main(int argc, char *argv[])
         case ::AST::Crate::Type::RustLib:
             // Save a loadable HIR dump
             CompilePhaseV("HIR Serialise", [&]() { HIR_Serialise(params.outfile + ".hir", *hir_crate); });
+            signal_metadata_ready();
             // Generate a loadable .o
             CompilePhaseV("Trans Codegen", [&]() { Trans_Codegen(params.outfile, CodegenOutput::StaticLibrary, trans_opt, *hir_crate, items, params.outfile + ".hir"); });
             break;
@@ -820,6 +893,7 @@ int main(int argc, char *argv[])
                 HIR_Serialise(params.outfile + ".hir", *hir_crate);
                 //hir_crate->m_ext_crates = ::std::move(saved_ext_crates);
                 });
+            signal_metadata_ready();
             // Generate a .so
             CompilePhaseV("Trans Codegen", [&]() { Trans_Codegen(params.outfile, CodegenOutput::DynamicLibrary, trans_opt, *hir_crate, items, params.outfile + ".hir"); });
             break;
@@ -831,10 +905,13 @@ int main(int argc, char *argv[])
             // Needs: An executable (the actual macro handler), metadata (for `extern crate foo;`)
 
             // 1. Generate code for the plugin itself
-            TransList items = CompilePhase<TransList>("Trans Enumerate PM", [&]() { return Trans_Enumerate_Main(*hir_crate); });
+            TransList items = CompilePhase<TransList>("Trans Enumerate PM", [&]() { return Trans_Enumerate_Main(*hir_crate, !params.debug.disable_mir_optimisations); });
             CompilePhaseV("Trans Auto Impls PM", [&]() { Trans_AutoImpls(*hir_crate, items); });
             CompilePhaseV("Trans Monomorph PM", [&]() { Trans_Monomorphise_List(*hir_crate, items); });
             CompilePhaseV("MIR Optimise Inline PM", [&]() { MIR_OptimiseCrate_Inlining(*hir_crate, items); });
+            if( !params.debug.disable_mir_optimisations ) {
+                CompilePhaseV("Trans Fold Identical PM", [&]() { Trans_FoldIdentical(*hir_crate, items); });
+            }
             // - Save a very basic HIR dump, making sure that there's no lang items in it (e.g. `mrustc-main`)
             CompilePhaseV("HIR Serialise", [&]() {
                 auto saved_lang_items = ::std::move(hir_crate->m_lang_items); hir_crate->m_lang_items.clear();
@@ -870,6 +947,11 @@ int main(int argc, char *argv[])
 
 ProgramParams::ProgramParams(int argc, char *argv[])
 {
+    // Default for `-C structured-c` (so it can be set for a whole build)
+    if( const auto* a = getenv("MRUSTC_STRUCTURED_C") )
+    {
+        this->codegen.structured_c = (strcmp(a, "1") == 0);
+    }
     if( const auto* a = getenv("MRUSTC_TARGET_VER") )
     {
         if( strcmp(a, "1.19") == 0 ) {
@@ -1006,10 +1088,26 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                     get_optval();
                     this->emit_depfile = optval;
                 }
+                else if( optname == "emit-metadata-ready" ) {
+                    get_optval();
+                    this->emit_metadata_ready = optval;
+                }
                 else if( optname == "panic" ) {
                     get_optval();
                     this->codegen.panic_type = optval;
                 }
+                else if( optname == "structured-c" ) {
+                    if( eq_pos == ::std::string::npos || optval == "yes" ) {
+                        this->codegen.structured_c = true;
+                    }
+                    else if( optval == "no" ) {
+                        this->codegen.structured_c = false;
+                    }
+                    else {
+                        ::std::cerr << "Flag -C structured-c takes `yes` or `no`" << ::std::endl;
+                        exit(1);
+                    }
+                }
                 else {
                     ::std::cerr << "Unknown codegen option: '" << optname << "'" << ::std::endl;
                     exit(1);
@@ -1058,6 +1156,10 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                     no_optval();
                     this->debug.full_validate_early = true;
                 }
+                else if( optname == "fused-expand" ) {
+                    no_optval();
+                    this->debug.fused_expand = true;
+                }
                 else if( optname == "dump-ast" ) {
                     no_optval();
                     this->debug.dump_ast = true;
@@ -1087,6 +1189,14 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                         exit(1);
                     }
                 }
+                else if( optname == "jobs" ) {
+                    get_optval();
+                    this->num_jobs = ::std::strtoul(optval.c_str(), nullptr, 10);
+                    if( this->num_jobs == 0 ) {
+                        ::std::cerr << "Invalid argument to -Z jobs - '" << optval << "'" << ::std::endl;
+                        exit(1);
+                    }
+                }
                 else if( optname == "print-cfgs") {
                     no_optval();
                     this->print_cfgs = true;
@@ -1345,5 +1455,8 @@ void ProgramParams::show_help() const
         "--test             : Generate a unit test executable\n"
         "-C <option>        : Code-generation options\n"
         "-Z <option>        : Debugging/experimental options\n"
+        "\n"
+        "USAGE: mrustc --server <socket>\n"
+        "Run as a compile server, compiling each request (e.g. from `minicargo --compile-server`) in a forked process\n"
         ;
 }
@@ -616,7 +616,7 @@ void MIR_Validate(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
     ::MIR::TypeResolve   state { sp, resolve, FMT_CB(ss, ss << path;), ret_type, args, fcn };
     // Validation rules:
 
-    if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+    if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
     
     {
         for(const auto& ty : fcn.locals)
@@ -1242,10 +1242,9 @@ void MIR_Validate(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
 
 void MIR_CheckCrate(/*const*/ ::HIR::Crate& crate)
 {
-    ::MIR::OuterVisitor    ov(crate, [](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
+    ::MIR::visit_crate_bodies(crate, [](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
         {
             MIR_Validate(res, p, *expr.m_mir, args, ty);
         }
         );
-    ov.visit_crate( crate );
 }
@@ -11,6 +11,7 @@
 #include <hir_typeck/static.hpp>
 #include <mir/helpers.hpp>
 #include <mir/visit_crate_mir.hpp>
+#include <set>
 
 // DISABLED: Unsizing intentionally leaks
 #define ENABLE_LEAK_DETECTOR    0
@@ -21,6 +22,7 @@ namespace
     {
         // 0 = invalid
         // -1 = valid
+        // -2 = maybe valid (valid on some paths into a block, invalid on others)
         // other = 1-based index into `inner_states`
         unsigned int    index;
 
@@ -35,12 +37,20 @@ namespace
             index(idx+1)
         {
         }
+        static State maybe() {
+            State   rv;
+            rv.index = ~1u;
+            return rv;
+        }
 
         bool is_composite() const {
-            return index != 0 && index != ~0u;
+            return index != 0 && index != ~0u && index != ~1u;
         }
         bool is_valid() const {
-            return index != 0;
+            return index != 0 && index != ~1u;
+        }
+        bool is_maybe() const {
+            return index == ~1u;
         }
 
         bool operator==(const State& x) const {
@@ -96,63 +106,97 @@ namespace
             for(const auto& isl : this->inner_states)
                 rv.inner_states.push_back( H::clone_state_list(isl) );
             rv.bb_path = this->bb_path;
-            return *this;
+            return rv;
         }
 
-        bool is_equivalent_to(const ValueStates& x) const
+        /// Merge `x` (which has the same drop flags) into this state, returning true if anything changed
+        ///
+        /// A value that's valid on one path and invalid on another becomes "maybe valid", and using, dropping, or
+        /// leaking it is an error (picking either state would hide that error on the other path).
+        bool merge(const ValueStates& x)
         {
-            struct H {
-                static bool equal(const ValueStates& vss_a, const State& a,  const ValueStates& vss_b, const State& b)
-                {
-                    if( a.index == 0 )
-                    {
-                        return b.index == 0;
-                    }
-                    if( a.index == ~0u )
-                    {
-                        return b.index == ~0u;
-                    }
-                    if( b.index == 0 || b.index == ~0u )
-                    {
-                        return false;
-                    }
-
-                    const auto& states_a = vss_a.inner_states.at( a.index - 1 );
-                    const auto& states_b = vss_b.inner_states.at( b.index - 1 );
-                    // NOTE: If there's two differen variants, this can happen.
-                    if( states_a.size() != states_b.size() )
-                        return false;
-
-                    for(size_t i = 0; i < states_a.size(); i ++)
-                    {
-                        if( ! H::equal(vss_a, states_a[i],  vss_b, states_b[i]) )
-                            return false;
-                    }
-                    // If the above loop didn't early exit, the two states are equal
-                    return true;
-                }
-            };
-
-            if( this->drop_flags != x.drop_flags )
-                return false;
-            if( ! H::equal(*this, return_value,  x, x.return_value) )
-                return false;
-
+            assert(this->drop_flags == x.drop_flags);
+            bool changed = merge_state(this->return_value, x, x.return_value);
             assert(args.size() == x.args.size());
             for(size_t i = 0; i < args.size(); i ++)
+                changed |= merge_state(this->args[i], x, x.args[i]);
+            assert(locals.size() == x.locals.size());
+            for(size_t i = 0; i < locals.size(); i ++)
+                changed |= merge_state(this->locals[i], x, x.locals[i]);
+            return changed;
+        }
+    private:
+        bool merge_state(State& a, const ValueStates& x, const State& b)
+        {
+            if( a.is_maybe() )
+                return false;
+            if( b.is_maybe() )
+            {
+                release_composite(a);
+                a = State::maybe();
+                return true;
+            }
+            if( !a.is_composite() && !b.is_composite() )
             {
-                if( ! H::equal(*this, args[i],  x, x.args[i]) )
+                if( a == b )
                     return false;
+                a = State::maybe();
+                return true;
             }
-
-            assert(locals.size() == x.locals.size());
-            for(size_t i = 0; i < locals.size(); i ++)
+            if( !a.is_composite() )
             {
-                if( ! H::equal(*this, locals[i],  x, x.locals[i]) )
+                // A whole value is the same as a composite with every field in that state
+                if( x.all_fields_are(b, a) )
                     return false;
+                a = this->allocate_composite(x.inner_states.at(b.index - 1).size(), a);
+            }
+            size_t n_fields = this->inner_states.at(a.index - 1).size();
+            if( b.is_composite() && x.inner_states.at(b.index - 1).size() != n_fields )
+            {
+                release_composite(a);
+                a = State::maybe();
+                return true;
+            }
+            bool changed = false;
+            for(size_t i = 0; i < n_fields; i ++)
+            {
+                // NOTE: Looked up each time, as merging a field can allocate a new composite
+                auto& sub = this->inner_states.at(a.index - 1)[i];
+                changed |= merge_state(sub, x, b.is_composite() ? x.inner_states.at(b.index - 1)[i] : b);
             }
+            return changed;
+        }
+        bool all_fields_are(const State& s, const State& v) const
+        {
+            if( !s.is_composite() )
+                return s == v;
+            for(const auto& sub : this->inner_states.at(s.index - 1))
+                if( !all_fields_are(sub, v) )
+                    return false;
             return true;
         }
+        void release_composite(State& s)
+        {
+            if( s.is_composite() )
+            {
+                auto& sub_states = this->inner_states.at(s.index - 1);
+                for(auto& ss : sub_states)
+                    release_composite(ss);
+                sub_states.clear();
+            }
+        }
+    public:
+        /// Check if any part of the value is only valid on some paths
+        bool any_maybe(const State& s) const
+        {
+            if( s.is_maybe() )
+                return true;
+            if( s.is_composite() )
+                for(const auto& sub : this->inner_states.at(s.index - 1))
+                    if( any_maybe(sub) )
+                        return true;
+            return false;
+        }
 
         StateFmt fmt_state(const ::MIR::TypeResolve& mir_res, const ::MIR::LValue& lv) const {
             return StateFmt(*this, get_lvalue_state(mir_res, lv));
@@ -342,6 +386,10 @@ namespace
                 }
                 path.pop_back();
             }
+            else if( vs.is_maybe() )
+            {
+                MIR_BUG(mir_res, "Accessing maybe-invalidated lvalue (only valid on some paths) - " << root_lv << " - field path=[" << path << "], BBs=[" << this->bb_path << "]");
+            }
             else if( !vs.is_valid() )
             {
                 // Locate where it was invalidated.
@@ -628,22 +676,26 @@ namespace
     };
 
 
-    struct StateSet
+    /// Merged states on entry to a block, one per distinct set of drop flags
+    ///
+    /// Value states are joined (see `ValueStates::merge`), while drop flags are kept exact as they decide which drops
+    /// happen.
+    struct BlockEntryStates
     {
-        ::std::vector<ValueStates>   known_state_sets;
+        ::std::vector<ValueStates>  entries;
 
-        bool add_state(const ValueStates& state_set)
+        /// Merge in a new incoming state, returning the index of the entry if it's new or changed (or `~0u` if not)
+        size_t add_state(ValueStates state)
         {
-            for(const auto& s : this->known_state_sets)
+            for(size_t i = 0; i < this->entries.size(); i ++)
             {
-                if( s.is_equivalent_to(state_set) )
+                if( this->entries[i].drop_flags == state.drop_flags )
                 {
-                    return false;
+                    return this->entries[i].merge(state) ? i : ~0u;
                 }
             }
-            this->known_state_sets.push_back( state_set.clone() );
-            this->known_state_sets.back().bb_path = ::std::vector<unsigned int>();
-            return true;
+            this->entries.push_back(mv$(state));
+            return this->entries.size() - 1;
         }
     };
 }
@@ -656,6 +708,9 @@ namespace
     else if( x.s.index == ~0u ) {
         os << "X";
     }
+    else if( x.s.index == ~1u ) {
+        os << "?";
+    }
     else {
         assert(x.s.index-1 < x.vss.inner_states.size());
         const auto& is = x.vss.inner_states[x.s.index-1];
@@ -677,6 +732,9 @@ namespace std {
             else if( s.is_valid() ) {
                 os << tag;
             }
+            else if( s.is_maybe() ) {
+                os << tag << "?";
+            }
             else {
             }
             };
@@ -696,14 +754,28 @@ namespace std {
 }
 
 
+/// Maximum number of block visits for one function (`$MRUSTC_FULL_VALIDATE_BUDGET`)
+/// - Counted in visits rather than time, so the result doesn't depend on the machine
+static unsigned full_validate_budget() {
+    static const unsigned value = []()->unsigned {
+        if( const auto* n = getenv("MRUSTC_FULL_VALIDATE_BUDGET") )
+        {
+            char* end;
+            auto v = strtoul(n, &end, 10);
+            if( *end == '\0' && v > 0 )
+                return static_cast<unsigned>(v);
+            WARNING(Span(), W0000, "Invalid value for $MRUSTC_FULL_VALIDATE_BUDGET - '" << n << "'");
+        }
+        return 200000;
+        }();
+    return value;
+}
+
 // "Executes" the function, keeping track of drop flags and variable validities
+// - Block entry states are merged (per set of drop flags) and the blocks re-visited until nothing changes
 void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Function& fcn)
 {
-    // TODO: Use a timer to check elapsed CPU time in this function, and check on each iteration
-    // - If more than `n` (10?) seconds passes on one function, warn and abort
-    //ElapsedTimeCounter    timer;
-    ::std::vector<unsigned> block_ref_counts( fcn.blocks.size() );
-    ::std::vector<StateSet> block_entry_states( fcn.blocks.size() );
+    ::std::vector<BlockEntryStates> block_entry_states( fcn.blocks.size() );
 
     // Determine value lifetimes (BBs in which Copy values are valid)
     // - Used to mask out Copy value (prevents combinatorial explosion)
@@ -724,22 +796,9 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
     state.locals = H::make_list(fcn.locals.size(), false);
     state.drop_flags = fcn.drop_flags;
 
-    block_ref_counts[0] = 1;
-    for(const auto& blk : fcn.blocks)
-    {
-        MIR::visit::visit_terminator_target(blk.terminator, [&](const ::MIR::BasicBlockId& e) {
-            block_ref_counts.at(e) += 1;
-            });
-    }
-
-    ::std::vector< ::std::pair<unsigned int, ValueStates> > todo_queue;
-    todo_queue.push_back( ::std::make_pair(0, mv$(state)) );
-    while( ! todo_queue.empty() )
-    {
-        auto cur_block = todo_queue.back().first;
-        auto state = mv$(todo_queue.back().second);
-        todo_queue.pop_back();
-
+    // Ordered by block index, so a block's entries are usually merged from all predecessors before it's visited
+    ::std::set< ::std::pair<unsigned int, size_t> > todo_queue;
+    auto push_state = [&](unsigned int bb, ValueStates state) {
         // Mask off any values which aren't valid in the first statement of this block
         {
             for(unsigned i = 0; i < state.locals.size(); i ++)
@@ -748,30 +807,49 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
                 {
                     // Not Copy, don't apply masking
                 }
-                else*/ if( ! state.locals[i].is_valid() )
+                else*/ if( state.locals[i] == State(false) )
                 {
                     // Already invalid
                 }
-                else if( lifetimes.slot_valid(i, cur_block, 0) )
+                else if( lifetimes.slot_valid(i, bb, 0) )
                 {
                     // Expected to be valid in this block, leave as-is
                 }
                 else
                 {
                     // Copy value not used at/after this block, mask to false
-                    DEBUG("BB" << cur_block << " - _" << i << " - Outside lifetime, discard");
+                    DEBUG("BB" << bb << " - _" << i << " - Outside lifetime, discard");
                     state.locals[i] = State(false);
                 }
             }
         }
 
-        // If this state already exists in the map, skip
-        // - Note: The `block_ref_counts` check saves a tiny bit of time, but not a huge amount
-        if( block_ref_counts[cur_block] > 1 && ! block_entry_states[cur_block].add_state(state) )
+        auto& entry_states = block_entry_states.at(bb);
+        auto idx = entry_states.add_state(mv$(state));
+        if( idx == ~0u )
         {
-            DEBUG("BB" << cur_block << " - Nothing new");
-            continue ;
+            DEBUG("BB" << bb << " - Nothing new");
+            return ;
         }
+        todo_queue.insert( ::std::make_pair(bb, idx) );
+        };
+    push_state(0, mv$(state));
+
+    const unsigned budget = full_validate_budget();
+    unsigned n_visits = 0;
+    while( ! todo_queue.empty() )
+    {
+        auto cur_block = todo_queue.begin()->first;
+        auto state = block_entry_states[cur_block].entries[todo_queue.begin()->second].clone();
+        todo_queue.erase(todo_queue.begin());
+
+        if( ++n_visits > budget )
+        {
+            WARNING(mir_res.sp, W0000, FMT_CB(ss, mir_res.fmt_pos(ss, true);) << "Full validation stopped after " << budget << " block visits"
+                << " (set $MRUSTC_FULL_VALIDATE_BUDGET to raise the limit)");
+            return ;
+        }
+
         DEBUG("BB" << cur_block << " - " << state);
         state.bb_path.push_back( cur_block );
 
@@ -898,12 +976,15 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
                         const auto& vs = state.get_lvalue_state(mir_res, se.slot);
 
                         MIR_ASSERT(mir_res, vs.index != ~0u, "Shallow drop on fully-valid value - " << se.slot);
+                        MIR_ASSERT(mir_res, !vs.is_maybe(), "Shallow drop on maybe-valid value - " << se.slot);
 
                         // Box<T> - Wrapper around Unique<T>
                         MIR_ASSERT(mir_res, vs.is_composite(), "Shallow drop on non-composite state - " << se.slot << " (state=" << StateFmt(state,vs) << ")");
                         const auto& sub_states = state.get_composite(mir_res, vs);
                         MIR_ASSERT(mir_res, sub_states.size() == 2, "Shallow drop of slot with incorrect state shape (state=" << StateFmt(state,vs) << ")");
                         MIR_ASSERT(mir_res, sub_states[0].is_valid(), "Shallow drop on deallocated Box - " << se.slot << " (state=" << StateFmt(state,vs) << ")");
+                        // The contents must have been moved out (or not) on every path, otherwise this leaks on some
+                        MIR_ASSERT(mir_res, !state.any_maybe(sub_states[1]), "Shallow drop on maybe-populated Box - " << se.slot << " (state=" << StateFmt(state,vs) << ")");
                         // TODO: This is leak protection, enable it once the rest works
                         if( ENABLE_LEAK_DETECTOR )
                         {
@@ -939,7 +1020,7 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
             if( ENABLE_LEAK_DETECTOR )
             {
                 auto ensure_dropped = [&](const State& s, const ::MIR::LValue& lv) {
-                    if( s.is_valid() ) {
+                    if( s.is_valid() || state.any_maybe(s) ) {
                         // Check if !Copy
                         if( mir_res.lvalue_is_copy(lv) ) {
                         }
@@ -959,30 +1040,30 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
         (Diverge,
             ),
         (Goto,   // Jump to another block
-            todo_queue.push_back( ::std::make_pair(te, mv$(state)) );
+            push_state(te, mv$(state));
             ),
         (Panic,
-            todo_queue.push_back( ::std::make_pair(te.dst, mv$(state)) );
+            push_state(te.dst, mv$(state));
             ),
         (If,
             state.ensure_lvalue_valid(mir_res, te.cond);
-            todo_queue.push_back( ::std::make_pair(te.bb0, state.clone()) );
-            todo_queue.push_back( ::std::make_pair(te.bb1, mv$(state)) );
+            push_state(te.bb0, state.clone());
+            push_state(te.bb1, mv$(state));
             ),
         (Switch,
             state.ensure_lvalue_valid(mir_res, te.val);
             for(size_t i = 0; i < te.targets.size(); i ++)
             {
-                todo_queue.push_back( ::std::make_pair(te.targets[i], i == te.targets.size()-1 ? mv$(state) : state.clone()) );
+                push_state(te.targets[i], i == te.targets.size()-1 ? mv$(state) : state.clone());
             }
             ),
         (SwitchValue,
             state.ensure_lvalue_valid(mir_res, te.val);
             for(size_t i = 0; i < te.targets.size(); i ++)
             {
-                todo_queue.push_back( ::std::make_pair(te.targets[i], state.clone()) );
+                push_state(te.targets[i], state.clone());
             }
-            todo_queue.push_back( ::std::make_pair(te.def_target, mv$(state)) );
+            push_state(te.def_target, mv$(state));
             ),
         (Call,
             if(const auto* e = te.fcn.opt_Value())
@@ -1000,13 +1081,14 @@ void MIR_Validate_FullValState(::MIR::TypeResolve& mir_res, const ::MIR::Functio
                 // Don't bother, it's just an empty block
             }
             else {
-                todo_queue.push_back( ::std::make_pair(te.panic_block, state.clone()) );
+                push_state(te.panic_block, state.clone());
             }
             state.mark_lvalue_valid(mir_res, te.ret_val);
-            todo_queue.push_back( ::std::make_pair(te.ret_block, mv$(state)) );
+            push_state(te.ret_block, mv$(state));
             )
         )
     }
+    DEBUG(n_visits << " block visits");
 }
 
 void MIR_Validate_Full(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path, const ::MIR::Function& fcn, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type)
@@ -1023,11 +1105,10 @@ void MIR_Validate_Full(const StaticTraitResolve& resolve, const ::HIR::ItemPath&
 
 void MIR_CheckCrate_Full(/*const*/ ::HIR::Crate& crate)
 {
-    ::MIR::OuterVisitor    ov(crate, [](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
+    ::MIR::visit_crate_bodies(crate, [](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
         {
             MIR_Validate_Full(res, p, *expr.m_mir, args, ty);
         }
         );
-    ov.visit_crate( crate );
 }
 
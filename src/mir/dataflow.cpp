@@ -0,0 +1,303 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/dataflow.cpp
+ * - Block-level dataflow analysis over MIR (liveness of locals, dominators)
+ */
+#include "dataflow.hpp"
+#include <mir/helpers.hpp>
+#include <algorithm>
+
+using namespace MIR::visit;
+
+namespace {
+    /// Collect the locals fully written and read by a statement/terminator
+    struct UseDefs {
+        ::std::vector<unsigned> defs;
+        ::std::vector<unsigned> uses;
+
+        bool cb(const ::MIR::LValue& lv, ValUsage vu, bool allow_defs) {
+            // NOTE: `Index` wrappers are visited as separate reads by the visitor
+            if( lv.m_root.is_Local() )
+            {
+                if( vu == ValUsage::Write && lv.m_wrappers.empty() ) {
+                    if( allow_defs )
+                        defs.push_back(lv.m_root.as_Local());
+                }
+                else {
+                    // Reads, moves, borrows, and writes to parts of (or through) the local
+                    uses.push_back(lv.m_root.as_Local());
+                }
+            }
+            return false;
+        }
+        void apply(::MIR::LocalBitSet& live) const {
+            for(auto v : defs)
+                live.reset(v);
+            for(auto v : uses)
+                live.set(v);
+        }
+    };
+}
+
+namespace MIR {
+
+void LocalLiveness::step_statement(LocalBitSet& live, const Statement& stmt)
+{
+    UseDefs ud;
+    visit_mir_lvalues(stmt, [&](const LValue& lv, ValUsage vu){ return ud.cb(lv, vu, true); });
+    ud.apply(live);
+}
+void LocalLiveness::step_terminator(LocalBitSet& live, const Terminator& term)
+{
+    UseDefs ud;
+    // The return value of a call is only written on the success edge, so it's not a definition.
+    visit_mir_lvalues(term, [&](const LValue& lv, ValUsage vu){ return ud.cb(lv, vu, false); });
+    ud.apply(live);
+}
+
+LocalLiveness::LocalLiveness(const Function& fcn):
+    m_fcn(fcn),
+    m_borrowed(fcn.locals.size())
+{
+    TRACE_FUNCTION;
+    m_blocks.resize(fcn.blocks.size());
+    for(auto& bi : m_blocks)
+    {
+        bi.live_in = LocalBitSet(fcn.locals.size());
+        bi.live_out = LocalBitSet(fcn.locals.size());
+    }
+
+    auto borrow_cb = [&](const LValue& lv, ValUsage vu) {
+        if( vu == ValUsage::Borrow && lv.m_root.is_Local() )
+            m_borrowed.set(lv.m_root.as_Local());
+        return false;
+        };
+    for(BasicBlockId bb = 0; bb < fcn.blocks.size(); bb ++)
+    {
+        const auto& blk = fcn.blocks[bb];
+        if( blk.terminator.tag() == Terminator::TAGDEAD )
+            continue ;
+        for(const auto& stmt : blk.statements)
+            visit_mir_lvalues(stmt, borrow_cb);
+        visit_mir_lvalues(blk.terminator, borrow_cb);
+        visit_terminator_target(blk.terminator, [&](const BasicBlockId& tgt) {
+            auto& preds = m_blocks.at(tgt).preds;
+            if( preds.empty() || preds.back() != bb )
+                preds.push_back(bb);
+            });
+        this->compute_summary(bb);
+    }
+
+    ::std::vector<BasicBlockId> worklist;
+    worklist.reserve(fcn.blocks.size());
+    for(BasicBlockId bb = 0; bb < fcn.blocks.size(); bb ++)
+        worklist.push_back(bb);
+    this->solve(mv$(worklist));
+}
+
+LocalBitSet LocalLiveness::live_after(BasicBlockId bb, size_t stmt_idx) const
+{
+    const auto& blk = m_fcn.blocks.at(bb);
+    auto live = m_blocks.at(bb).live_out;
+    step_terminator(live, blk.terminator);
+    for(size_t i = blk.statements.size(); i -- > stmt_idx + 1; )
+        step_statement(live, blk.statements[i]);
+    return live;
+}
+
+void LocalLiveness::invalidate_block(BasicBlockId bb)
+{
+    this->compute_summary(bb);
+    this->solve({ bb });
+}
+
+void LocalLiveness::compute_summary(BasicBlockId bb)
+{
+    const auto& blk = m_fcn.blocks[bb];
+    auto& bi = m_blocks[bb];
+    bi.uses = LocalBitSet(m_fcn.locals.size());
+    bi.defs = LocalBitSet(m_fcn.locals.size());
+    if( blk.terminator.tag() == Terminator::TAGDEAD )
+        return ;
+
+    auto apply = [&](const UseDefs& ud) {
+        for(auto v : ud.defs) {
+            bi.uses.reset(v);
+            bi.defs.set(v);
+        }
+        for(auto v : ud.uses) {
+            bi.uses.set(v);
+        }
+        };
+    // Walk backwards, so `uses` ends up as the set read before any full write
+    {
+        UseDefs ud;
+        visit_mir_lvalues(blk.terminator, [&](const LValue& lv, ValUsage vu){ return ud.cb(lv, vu, false); });
+        apply(ud);
+    }
+    for(size_t i = blk.statements.size(); i --; )
+    {
+        UseDefs ud;
+        visit_mir_lvalues(blk.statements[i], [&](const LValue& lv, ValUsage vu){ return ud.cb(lv, vu, true); });
+        apply(ud);
+    }
+}
+
+void LocalLiveness::solve(::std::vector<BasicBlockId> worklist)
+{
+    // NOTE: Re-computes the sets from the successors each time (instead of only adding) so that a re-solve after an
+    // edit can shrink them. Starting from an existing solution this may not reach the minimal solution around loops,
+    // but the result is always a conservative one.
+    ::std::vector<bool> queued(m_blocks.size());
+    for(auto bb : worklist)
+        queued[bb] = true;
+    unsigned n_iterations = 0;
+    while( !worklist.empty() )
+    {
+        auto bb = worklist.back();
+        worklist.pop_back();
+        queued[bb] = false;
+        n_iterations ++;
+
+        auto& bi = m_blocks[bb];
+        LocalBitSet out(m_fcn.locals.size());
+        if( m_fcn.blocks[bb].terminator.tag() != Terminator::TAGDEAD )
+        {
+            visit_terminator_target(m_fcn.blocks[bb].terminator, [&](const BasicBlockId& tgt) {
+                out.union_with(m_blocks[tgt].live_in);
+                });
+        }
+        bi.live_out = mv$(out);
+
+        auto in = bi.live_out;
+        in.subtract(bi.defs);
+        in.union_with(bi.uses);
+        if( in != bi.live_in )
+        {
+            bi.live_in = mv$(in);
+            for(auto p : bi.preds)
+            {
+                if( !queued[p] ) {
+                    queued[p] = true;
+                    worklist.push_back(p);
+                }
+            }
+        }
+    }
+    DEBUG(n_iterations << " block visits");
+}
+
+// --------------------------------------------------------------------
+// Dominators (Cooper, Harvey, Kennedy - "A Simple, Fast Dominance Algorithm")
+// --------------------------------------------------------------------
+const BasicBlockId BlockDominators::NONE;
+BlockDominators::BlockDominators(const Function& fcn):
+    m_idom(fcn.blocks.size(), NONE),
+    m_children(fcn.blocks.size())
+{
+    TRACE_FUNCTION;
+    if( fcn.blocks.empty() )
+        return ;
+
+    // Post-order traversal from the entry block
+    ::std::vector<BasicBlockId> postorder;
+    {
+        ::std::vector<bool> visited(fcn.blocks.size());
+        ::std::vector<::std::pair<BasicBlockId, ::std::vector<BasicBlockId>>>  stack;
+        auto push = [&](BasicBlockId bb) {
+            visited[bb] = true;
+            ::std::vector<BasicBlockId> succs;
+            visit_terminator_target(fcn.blocks[bb].terminator, [&](const BasicBlockId& t){ succs.push_back(t); });
+            // Reversed, so the successors are popped in order
+            ::std::reverse(succs.begin(), succs.end());
+            stack.push_back(::std::make_pair(bb, mv$(succs)));
+            };
+        push(0);
+        while( !stack.empty() )
+        {
+            auto& top = stack.back();
+            if( top.second.empty() )
+            {
+                postorder.push_back(top.first);
+                stack.pop_back();
+            }
+            else
+            {
+                auto next = top.second.back();
+                top.second.pop_back();
+                if( !visited[next] )
+                    push(next);
+            }
+        }
+    }
+    m_rpo.assign(postorder.rbegin(), postorder.rend());
+
+    ::std::vector<unsigned> po_index(fcn.blocks.size(), NONE);
+    for(size_t i = 0; i < postorder.size(); i ++)
+        po_index[postorder[i]] = i;
+
+    ::std::vector<::std::vector<BasicBlockId>>  preds(fcn.blocks.size());
+    for(auto bb : m_rpo)
+    {
+        visit_terminator_target(fcn.blocks[bb].terminator, [&](const BasicBlockId& t){ preds[t].push_back(bb); });
+    }
+
+    auto intersect = [&](BasicBlockId a, BasicBlockId b) {
+        while( a != b )
+        {
+            while( po_index[a] < po_index[b] )
+                a = m_idom[a];
+            while( po_index[b] < po_index[a] )
+                b = m_idom[b];
+        }
+        return a;
+        };
+
+    m_idom[0] = 0;
+    bool changed;
+    do
+    {
+        changed = false;
+        for(auto bb : m_rpo)
+        {
+            if( bb == 0 )
+                continue ;
+            BasicBlockId new_idom = NONE;
+            for(auto p : preds[bb])
+            {
+                if( m_idom[p] == NONE )
+                    continue ;
+                new_idom = (new_idom == NONE ? p : intersect(p, new_idom));
+            }
+            if( new_idom != m_idom[bb] )
+            {
+                m_idom[bb] = new_idom;
+                changed = true;
+            }
+        }
+    } while(changed);
+
+    for(auto bb : m_rpo)
+    {
+        if( bb != 0 )
+            m_children[m_idom[bb]].push_back(bb);
+    }
+}
+
+bool BlockDominators::dominates(BasicBlockId a, BasicBlockId b) const
+{
+    if( !is_reachable(a) || !is_reachable(b) )
+        return false;
+    for(;;)
+    {
+        if( a == b )
+            return true;
+        if( b == 0 )
+            return false;
+        b = m_idom[b];
+    }
+}
+
+}   // namespace MIR
@@ -0,0 +1,134 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/dataflow.hpp
+ * - Block-level dataflow analysis over MIR (liveness of locals, dominators)
+ */
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <mir/mir.hpp>
+
+namespace MIR {
+
+typedef unsigned int    BasicBlockId;
+
+/// Dense fixed-size bitset (one bit per local)
+class LocalBitSet
+{
+    ::std::vector<uint64_t> m_words;
+    size_t  m_size;
+public:
+    LocalBitSet(size_t size=0):
+        m_words( (size + 63) / 64 ),
+        m_size(size)
+    {}
+
+    size_t size() const { return m_size; }
+
+    bool get(size_t i) const {
+        assert(i < m_size);
+        return (m_words[i / 64] >> (i % 64)) & 1;
+    }
+    void set(size_t i) {
+        assert(i < m_size);
+        m_words[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    void reset(size_t i) {
+        assert(i < m_size);
+        m_words[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+
+    /// Add all bits from `x`, returns true if any were new
+    bool union_with(const LocalBitSet& x) {
+        assert(m_size == x.m_size);
+        bool changed = false;
+        for(size_t i = 0; i < m_words.size(); i ++)
+        {
+            auto v = m_words[i] | x.m_words[i];
+            changed |= (v != m_words[i]);
+            m_words[i] = v;
+        }
+        return changed;
+    }
+    /// Remove all bits set in `x`
+    void subtract(const LocalBitSet& x) {
+        assert(m_size == x.m_size);
+        for(size_t i = 0; i < m_words.size(); i ++)
+            m_words[i] &= ~x.m_words[i];
+    }
+
+    bool operator==(const LocalBitSet& x) const { return m_words == x.m_words; }
+    bool operator!=(const LocalBitSet& x) const { return !(*this == x); }
+};
+
+/// Liveness of locals at block boundaries, solved using a worklist
+///
+/// Accesses through a borrow are not tracked, so users must check `is_borrowed` before acting on a local being dead.
+/// Writes to part of a local (or through it) count as uses of the local.
+class LocalLiveness
+{
+    const Function& m_fcn;
+
+    struct BlockInfo {
+        /// Locals read before being fully written within the block
+        LocalBitSet uses;
+        /// Locals fully written within the block
+        LocalBitSet defs;
+        LocalBitSet live_in;
+        LocalBitSet live_out;
+        ::std::vector<BasicBlockId> preds;
+    };
+    ::std::vector<BlockInfo>    m_blocks;
+    LocalBitSet m_borrowed;
+
+public:
+    LocalLiveness(const Function& fcn);
+
+    /// Locals that are live on entry to the block
+    const LocalBitSet& live_in(BasicBlockId bb) const { return m_blocks.at(bb).live_in; }
+    /// Locals that are live on exit from the block (i.e. read by a successor before being written)
+    const LocalBitSet& live_out(BasicBlockId bb) const { return m_blocks.at(bb).live_out; }
+    /// Returns true if the local has its address taken anywhere in the function
+    bool is_borrowed(unsigned local) const { return m_borrowed.get(local); }
+
+    /// Locals that are live just after the given statement
+    LocalBitSet live_after(BasicBlockId bb, size_t stmt_idx) const;
+
+    /// Re-compute the summary of an edited block and propagate any changes to its predecessors
+    ///
+    /// NOTE: The block list must not have changed shape (blocks added/removed, or terminator targets changed)
+    void invalidate_block(BasicBlockId bb);
+
+    /// Apply the effect of a statement (backwards) to a live set
+    static void step_statement(LocalBitSet& live, const Statement& stmt);
+    static void step_terminator(LocalBitSet& live, const Terminator& term);
+
+private:
+    void compute_summary(BasicBlockId bb);
+    void solve(::std::vector<BasicBlockId> worklist);
+};
+
+/// Dominator tree of the blocks reachable from the entry block
+class BlockDominators
+{
+    static const BasicBlockId NONE = ~0u;
+    ::std::vector<BasicBlockId> m_idom;
+    ::std::vector<::std::vector<BasicBlockId>>  m_children;
+    /// Reachable blocks in reverse post-order
+    ::std::vector<BasicBlockId> m_rpo;
+public:
+    BlockDominators(const Function& fcn);
+
+    bool is_reachable(BasicBlockId bb) const { return m_idom.at(bb) != NONE; }
+    /// Immediate dominator (the entry block is its own)
+    BasicBlockId idom(BasicBlockId bb) const { return m_idom.at(bb); }
+    /// Blocks immediately dominated by this block
+    const ::std::vector<BasicBlockId>& children(BasicBlockId bb) const { return m_children.at(bb); }
+    const ::std::vector<BasicBlockId>& reverse_postorder() const { return m_rpo; }
+    /// Returns true if every path from the entry to `b` passes through `a`
+    bool dominates(BasicBlockId a, BasicBlockId b) const;
+};
+
+}   // namespace MIR
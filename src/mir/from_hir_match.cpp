@@ -394,10 +394,6 @@ void MIR_LowerHIR_Match( MirBuilder& builder, MirConverter& conv, ::HIR::ExprNod
             ac.has_condition = true;
 
             // NOTE: Paused so that later code (which knows what the false branch will be) can end it correctly
-
-            // TODO: What to do with contidionals in the fast model?
-            // > Could split the match on each conditional - separating such that if a conditional fails it can fall into the other compatible branches.
-            fall_back_on_simple = true;
         }
         else
         {
@@ -512,9 +508,22 @@ void MIR_LowerHIR_Match( MirBuilder& builder, MirConverter& conv, ::HIR::ExprNod
         }
     }
 
-    // TODO: Combine identical-pattern arms, allowing potential use of condtionals
-    // - 
-    // If there's a conditional that isn't grouped with an unconditional pattern - then force fallback
+    // The grouped generator reaches each ruleset from exactly one place, and a failed condition jumps to the rules
+    // after it. If a conditional pattern expanded into multiple rulesets (nested or-patterns), then there would be
+    // several places for its `cond_false` block to go to - so use the simple generator.
+    for(size_t i = 1; i < arm_rules.size() && !fall_back_on_simple; i ++)
+    {
+        for(size_t j = 0; j < i; j ++)
+        {
+            if( arm_code[arm_rules[i].arm_idx].has_condition
+                && arm_rules[j].arm_idx == arm_rules[i].arm_idx && arm_rules[j].pat_idx == arm_rules[i].pat_idx )
+            {
+                DEBUG("Conditional pattern (" << arm_rules[i].arm_idx << "," << arm_rules[i].pat_idx << ") has multiple rulesets, using simple");
+                fall_back_on_simple = true;
+                break;
+            }
+        }
+    }
 
     // TODO: SplitSlice is buggy, make it fall back to simple?
 
@@ -2762,6 +2771,20 @@ public:
         }
         return rv;
     }
+    /// Copy of rules `ofs..` that pass `keep`
+    t_rules_subset sub_filter(size_t ofs, ::std::function<bool(const ::std::vector<PatternRule>&)> keep) const
+    {
+        t_rules_subset  rv { this->size() - ofs, this->is_arm_indexes };
+        for(size_t i = ofs; i < this->size(); i++)
+        {
+            if( keep(*this->rule_sets[i]) )
+            {
+                rv.rule_sets.push_back( this->rule_sets[i] );
+                rv.arm_idxes.push_back( this->arm_idxes[i] );
+            }
+        }
+        return rv;
+    }
     void push_arm(const ::std::vector<PatternRule>& x, size_t arm_idx, size_t pat_idx)
     {
         assert(is_arm_indexes);
@@ -2808,6 +2831,11 @@ class MatchGenGrouped
     const ::std::vector<ArmCode>& m_arms_code;
 
     size_t m_field_path_ofs;
+
+    /// Values known to be equal to a rule on the current path (from a dispatch that generated a specialised fallback)
+    ::std::vector<const PatternRule*>   m_known_values;
+    /// Number of rules that can still be copied into specialised fallbacks (limits code growth)
+    size_t  m_specialise_budget;
 public:
     MatchGenGrouped(MirBuilder& builder, const Span& sp, const ::HIR::TypeRef& top_ty, const ::MIR::LValue& top_val, const ::std::vector<ArmCode>& arms_code, size_t field_path_ofs):
         sp(sp),
@@ -2815,11 +2843,16 @@ public:
         m_top_ty(top_ty),
         m_top_val(top_val),
         m_arms_code(arms_code),
-        m_field_path_ofs(field_path_ofs)
+        m_field_path_ofs(field_path_ofs),
+        m_specialise_budget(0)
     {
     }
 
+    void set_specialise_budget(size_t n) { m_specialise_budget = n; }
+
     void gen_for_slice(t_rules_subset rules, size_t ofs, ::MIR::BasicBlockId default_arm);
+    ::MIR::BasicBlockId gen_fallback(const t_rules_subset& rules, size_t first, size_t ofs, const PatternRule* known, const ::std::vector<t_rules_subset>* excluded, ::MIR::BasicBlockId shared_next, ::MIR::BasicBlockId default_arm);
+    bool is_known_value(const PatternRule& rule) const;
     void gen_dispatch(const ::std::vector<t_rules_subset>& rules, size_t ofs, const ::std::vector<::MIR::BasicBlockId>& arm_targets, ::MIR::BasicBlockId def_blk);
     void gen_dispatch__primitive(::HIR::TypeRef ty, ::MIR::LValue val, const ::std::vector<t_rules_subset>& rules, size_t ofs, const ::std::vector<::MIR::BasicBlockId>& arm_targets, ::MIR::BasicBlockId def_blk);
     void gen_dispatch__enum(::HIR::TypeRef ty, ::MIR::LValue val, const ::std::vector<t_rules_subset>& rules, size_t ofs, const ::std::vector<::MIR::BasicBlockId>& arm_targets, ::MIR::BasicBlockId def_blk);
@@ -2917,6 +2950,7 @@ void MIR_LowerHIR_Match_Grouped(
     }
 
     auto inst = MatchGenGrouped { builder, sp, match_ty, match_val, arms_code, 0 };
+    inst.set_specialise_budget( 4 * arm_rules.size() + 16 );
 
     // NOTE: This block should never be used
     auto default_arm = builder.new_bb_unlinked();
@@ -2974,29 +3008,14 @@ void MatchGenGrouped::gen_for_slice(t_rules_subset arm_rules, size_t ofs, ::MIR:
 
                 if( ac.has_condition )
                 {
-                    TODO(sp, "Handle conditionals in Grouped");
-                    // TODO: If the condition fails, this should re-try the match on other rules that could have worked.
-                    // - For now, conditionals are disabled.
+                    // If the condition fails, continue on to the following rules (which could also match)
+                    // - Each pattern has its own copy of the condition, and is only reached from here (conditional
+                    //   patterns that expand into multiple rulesets use the simple generator)
+                    ASSERT_BUG(sp, ap.cond_fail_tgt == 0, "Condition fail target already set, set to bb" << ap.cond_fail_tgt << " cur is bb" << next);
+                    ap.cond_fail_tgt = next;
 
-                    // TODO: What if there's multiple patterns on this condition?
-                    // - For now, only the first pattern gets edited.
-                    // - Maybe clone the blocks used for the condition?
-
-                    // Check for marking in `ac` that the block has already been terminated, assert that target is `next`
-                    if( ai.second == 0 )
-                    {
-                        if( ap.cond_fail_tgt != 0 )
-                        {
-                            ASSERT_BUG(sp, ap.cond_fail_tgt == next, "Condition fail target already set with mismatching arm, set to bb" << ap.cond_fail_tgt << " cur is bb" << next);
-                        }
-                        else
-                        {
-                            ap.cond_fail_tgt = next;
-
-                            m_builder.set_cur_block( ap.cond_false );
-                            m_builder.end_block( ::MIR::Terminator::make_Goto(next) );
-                        }
-                    }
+                    m_builder.set_cur_block( ap.cond_false );
+                    m_builder.end_block( ::MIR::Terminator::make_Goto(next) );
 
                     if( next != default_arm )
                         m_builder.set_cur_block(next);
@@ -3075,7 +3094,6 @@ void MatchGenGrouped::gen_for_slice(t_rules_subset arm_rules, size_t ofs, ::MIR:
             for(size_t i = 0; i < slices.size(); i ++)
             {
                 auto cur_block = m_builder.new_bb_unlinked();
-                m_builder.set_cur_block(cur_block);
 
                 for(size_t j = 0; j < slices[i].size(); j ++)
                 {
@@ -3084,13 +3102,33 @@ void MatchGenGrouped::gen_for_slice(t_rules_subset arm_rules, size_t ofs, ::MIR:
                     arm_blocks.push_back(cur_block);
                 }
 
-                this->gen_for_slice(slices[i], ofs+1, next);
-            }
+                // If this value's rules fail, the following rules can be matched knowing this value
+                auto fallback = next;
+                if( has_default )
+                    fallback = this->gen_fallback(arm_rules, first_any, ofs, &slices[i][0][ofs], nullptr, next, default_arm);
 
-            m_builder.set_cur_block(cur_blk);
+                m_builder.set_cur_block(cur_block);
+                this->gen_for_slice(slices[i], ofs+1, fallback);
+            }
 
             // Generate decision code
-            this->gen_dispatch(slices, ofs, arm_blocks, next);
+            if( slices.size() == 1 && this->is_known_value(slices[0][0][ofs]) )
+            {
+                // Already tested on this path, go directly to the rules
+                DEBUG("Known value " << slices[0][0][ofs]);
+                m_builder.set_cur_block(cur_blk);
+                m_builder.end_block( ::MIR::Terminator::make_Goto(arm_blocks[0]) );
+            }
+            else
+            {
+                // If none of the values match, the following rules can skip them
+                auto def_blk = next;
+                if( has_default )
+                    def_blk = this->gen_fallback(arm_rules, first_any, ofs, nullptr, &slices, next, default_arm);
+
+                m_builder.set_cur_block(cur_blk);
+                this->gen_dispatch(slices, ofs, arm_blocks, def_blk);
+            }
 
             if(has_default)
             {
@@ -3140,6 +3178,109 @@ void MatchGenGrouped::gen_for_slice(t_rules_subset arm_rules, size_t ofs, ::MIR:
     ASSERT_BUG(sp, ! m_builder.block_active(), "Block left active after match group");
 }
 
+namespace {
+    /// Rules that select exactly one value (so a failed/successful test tells the value)
+    bool rule_is_exact(const PatternRule& rule)
+    {
+        if( rule.is_Value() )
+            return !rule.as_Value().is_Const();
+        return rule.is_Variant() || rule.is_Bool() || rule.is_Slice();
+    }
+    /// Returns true if `rule` can't match a value that matched `known`
+    bool rule_excluded_by(const PatternRule& rule, const PatternRule& known)
+    {
+        if( !(rule.field_path == known.field_path) || !rule_is_exact(known) )
+            return false;
+        if( rule.tag() == known.tag() && rule_is_exact(rule) )
+            return !rule_compatible(rule, known);
+        if( (rule.is_ValueRange() && known.is_Value()) || (rule.is_SplitSlice() && known.is_Slice()) )
+            return !rules_overlap(rule, known);
+        return false;
+    }
+    /// Returns true if `rule` tests the same value as `known` (i.e. the test can be skipped)
+    bool rule_same_test(const PatternRule& rule, const PatternRule& known)
+    {
+        return rule.field_path == known.field_path && rule.tag() == known.tag()
+            && rule_is_exact(rule) && rule_is_exact(known) && rule_compatible(rule, known);
+    }
+}
+
+/// Get the block to use when rules `first..` of `rules` are to be tried after a failed dispatch (or one of its inner
+/// rules failed).
+///
+/// If the dispatch is known to have selected `known` (or none of `excluded`), then rules that can't match are
+/// removed and the remaining rules are generated in a new block - so the following dispatches don't re-test the
+/// value. Otherwise (or if there's nothing to gain, or the code size budget is used up) `shared_next` is returned.
+::MIR::BasicBlockId MatchGenGrouped::gen_fallback(const t_rules_subset& rules, size_t first, size_t ofs, const PatternRule* known, const ::std::vector<t_rules_subset>* excluded, ::MIR::BasicBlockId shared_next, ::MIR::BasicBlockId default_arm)
+{
+    assert(first < rules.size());
+    // A conditional pattern's failure target can only be set once, so it can't be generated multiple times
+    if( rules.is_arm() )
+    {
+        for(size_t i = first; i < rules.size(); i ++)
+        {
+            if( m_arms_code[rules.arm_idx(i).first].has_condition )
+                return shared_next;
+        }
+    }
+
+    bool is_useful = false;
+    auto filtered = rules.sub_filter(first, [&](const ::std::vector<PatternRule>& r)->bool {
+        if( r.size() <= ofs )
+            return true;
+        const auto& rule = r[ofs];
+        if( known )
+        {
+            if( rule_excluded_by(rule, *known) )
+                return false;
+            // The test for this rule can be skipped
+            if( rule_same_test(rule, *known) )
+                is_useful = true;
+        }
+        if( excluded )
+        {
+            for(const auto& e : *excluded)
+            {
+                if( rule_same_test(rule, e[0][ofs]) )
+                    return false;
+            }
+        }
+        return true;
+        });
+    if( filtered.size() == 0 )
+    {
+        DEBUG("Fallback from ofs=" << ofs << " - No rules can match");
+        return default_arm;
+    }
+    if( filtered.size() == rules.size() - first && !is_useful )
+        return shared_next;
+    if( filtered.size() > m_specialise_budget )
+    {
+        DEBUG("Fallback from ofs=" << ofs << " - Over budget (" << filtered.size() << " > " << m_specialise_budget << ")");
+        return shared_next;
+    }
+    m_specialise_budget -= filtered.size();
+
+    TRACE_FUNCTION_F("ofs=" << ofs << ", known=" << FMT_CB(os, if(known) os << *known; else os << "-") << ", " << (rules.size() - first) << " -> " << filtered.size() << " rules");
+    auto rv = m_builder.new_bb_unlinked();
+    m_builder.set_cur_block(rv);
+    if( known )
+        m_known_values.push_back(known);
+    this->gen_for_slice(mv$(filtered), ofs, default_arm);
+    if( known )
+        m_known_values.pop_back();
+    return rv;
+}
+bool MatchGenGrouped::is_known_value(const PatternRule& rule) const
+{
+    for(const auto* k : m_known_values)
+    {
+        if( rule_same_test(rule, *k) )
+            return true;
+    }
+    return false;
+}
+
 /// <summary>
 /// Generate dispatch code for the provided pattern list
 /// </summary>
@@ -11,6 +11,7 @@
 #include <hir/type.hpp>
 #include <mir/mir.hpp>
 #include <algorithm>    // ::std::find
+#include <parallel.hpp>
 
 void ::MIR::TypeResolve::fmt_pos(::std::ostream& os, bool include_path/*=false*/) const
 {
@@ -28,12 +29,12 @@ void ::MIR::TypeResolve::fmt_pos(::std::ostream& os, bool include_path/*=false*/
 }
 void ::MIR::TypeResolve::print_msg(const char* tag, ::std::function<void(::std::ostream& os)> cb) const
 {
-    auto& os = ::std::cerr;
+    auto& os = parallel::diag_stream();
     os << "MIR " << tag << ": ";
     fmt_pos(os, true);
     cb(os);
     os << ::std::endl;
-    abort();
+    parallel::fatal_error();
     //throw CheckFailure {};
 }
 
@@ -1213,7 +1214,7 @@ void MIR_Helper_GetLifetimes_DetermineValueLifetime(
             return this->end == Position { ~0u, ~0u };
         }
     };
-    static unsigned NEXT_INDEX = 0;
+    thread_local static unsigned NEXT_INDEX = 0;
     struct State
     {
         unsigned int index = 0;
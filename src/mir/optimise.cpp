@@ -11,11 +11,13 @@
 #include <hir/visitor.hpp>
 #include <hir_typeck/static.hpp>
 #include <mir/helpers.hpp>
+#include <mir/dataflow.hpp>
 #include <mir/operations.hpp>
 #include <mir/visit_crate_mir.hpp>
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
+#include <unordered_map>
 #include <trans/target.hpp>
 #include <trans/trans_list.hpp> // Note: This is included for inlining after enumeration and monomorph
 
@@ -38,6 +40,7 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
 bool MIR_Optimise_SplitAggregates(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_PropagateKnownValues(::MIR::TypeResolve& state, ::MIR::Function& fcn);
+bool MIR_Optimise_ValueNumbering(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_DeTemporary(::MIR::TypeResolve& state, ::MIR::Function& fcn); // Eliminate useless temporaries
 bool MIR_Optimise_UnifyTemporaries(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_CommonStatements(::MIR::TypeResolve& state, ::MIR::Function& fcn);
@@ -93,6 +96,43 @@ static int check_mode() {
 static bool check_after_all() {
     return check_mode() >= CHECKMODE_ALL;
 }
+/// Statement budget for inlining a callee (`$MRUSTC_INLINE_THRESHOLD`, default 10)
+static unsigned inline_threshold() {
+    static unsigned value = 0;
+    if( value == 0 ) {
+        value = 10;
+        if( const auto* n = getenv("MRUSTC_INLINE_THRESHOLD") )
+        {
+            char* end;
+            auto v = strtoul(n, &end, 10);
+            if( *end != '\0' || v == 0 ) {
+                WARNING(Span(), W0000, "Invalid value for $MRUSTC_INLINE_THRESHOLD - '" << n << "'");
+            }
+            else {
+                value = static_cast<unsigned>(v);
+            }
+        }
+    }
+    return value;
+}
+
+/// Statistics on inlining decisions, reported by `MIR_OptimiseCrate_Inlining` if `$MRUSTC_INLINE_STATS` is set
+static struct {
+    bool    enabled;
+    unsigned    n_considered;
+    unsigned    n_inlined;
+    unsigned    n_rejected_cost;
+    unsigned    n_rejected_recursion;
+    ::std::map<::HIR::Path, unsigned>   inlined_paths;
+
+    void clear() {
+        n_considered = 0;
+        n_inlined = 0;
+        n_rejected_cost = 0;
+        n_rejected_recursion = 0;
+        inlined_paths.clear();
+    }
+} s_inline_stats;
 
 /// A minimum set of optimisations:
 /// - Inlines `#[inline(always)]` functions
@@ -178,7 +218,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_BlockSimplify(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -191,7 +231,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_ConstPropagate(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -207,7 +247,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
             {
             }
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -220,7 +260,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_SplitAggregates(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -234,7 +274,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_PropagateKnownValues(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -243,6 +283,18 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         }
         //else { MIR_Validate(resolve, path, fcn, args, ret_type); }
 
+        // >> Remove redundant computations/copies of single-assignment locals
+        if( MIR_Optimise_ValueNumbering(state, fcn) )
+        {
+#if DUMP_AFTER_ALL
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
+#endif
+            if( check_after_all() ) {
+                MIR_Validate(resolve, path, fcn, args, ret_type);
+            }
+            change_happened = true;
+        }
+
         // TODO: Convert `&mut *mut_foo` into `mut_foo` if the source is movable and not used afterwards
 
         // >> Propagate/remove dead assignments
@@ -253,7 +305,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
             {
             }
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -275,7 +327,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_UnifyBlocks(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -286,7 +338,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_DeadDropFlags(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -297,7 +349,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_DeadAssignments(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -308,7 +360,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_NoopRemoval(state, fcn) )
         {
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -320,7 +372,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_UselessReborrows(state, fcn) )
         {
             #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
             #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -332,7 +384,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         if( MIR_Optimise_GotoAssign(state, fcn) )
         {
             #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
             #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -349,7 +401,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
                 MIR_Cleanup(resolve, path, fcn, args, ret_type);
                 //MIR_Dump_Fcn(::std::cout, fcn);
 #if DUMP_AFTER_ALL
-                if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+                if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
                 if( check_after_all() ) {
                     MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -362,7 +414,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         {
             #if DUMP_AFTER_PASS
             if( debug_enabled() ) {
-                MIR_Dump_Fcn(::std::cout, fcn);
+                MIR_Dump_Fcn(debug_stream(), fcn);
             }
             #endif
             if( check_mode() == CHECKMODE_PASS ) {  // NOTE: Skipped if CHECKMODE_ALL
@@ -375,7 +427,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         {
             change_happened = true;
 #if DUMP_AFTER_ALL
-            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+            if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
             if( check_after_all() ) {
                 MIR_Validate(resolve, path, fcn, args, ret_type);
@@ -409,7 +461,7 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
 
     #if DUMP_AFTER_DONE
     if( debug_enabled() ) {
-        MIR_Dump_Fcn(::std::cout, fcn);
+        MIR_Dump_Fcn(debug_stream(), fcn);
     }
     #endif
     if( check_mode() >= CHECKMODE_FINAL )
@@ -1135,18 +1187,25 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
                 return false;
             }
 
+            // Statement budget: constant arguments are likely to fold away after inlining, so count towards the benefit
+            size_t budget = inline_threshold();
+            for(const auto& p : params)
+            {
+                if( p.is_Constant() )
+                    budget += 1;
+            }
 
             // TODO: Allow functions that are just a switch on an input.
             if( fcn.blocks.size() == 1 )
             {
-                return fcn.blocks[0].statements.size() < 10 && ! fcn.blocks[0].terminator.is_Goto();
+                return fcn.blocks[0].statements.size() < budget && ! fcn.blocks[0].terminator.is_Goto();
             }
             else if( fcn.blocks.size() == 2 && fcn.blocks[0].terminator.is_Call() )
             {
                 const auto& blk0_te = fcn.blocks[0].terminator.as_Call();
                 if( !fcn.blocks[1].terminator.is_Diverge() )
                     return false;
-                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() > 10 )
+                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() > budget )
                     return false;
                 // Detect and avoid simple recursion.
                 // - This won't detect mutual recursion - that also needs prevention.
@@ -1162,7 +1221,7 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
                     return false;
                 if( !(fcn.blocks[2].terminator.is_Diverge() || fcn.blocks[2].terminator.is_Return()) )
                     return false;
-                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() + fcn.blocks[2].statements.size() > 10 )
+                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() + fcn.blocks[2].statements.size() > budget )
                     return false;
                 // Detect and avoid simple recursion.
                 // - This won't detect mutual recursion - that also needs prevention.
@@ -1711,9 +1770,11 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
             const auto* called_mir = get_called_mir(state, list, path,  cloner.params);
             if( !called_mir )
                 continue ;
+            s_inline_stats.n_considered ++;
             if( called_mir == &fcn )
             {
                 DEBUG("Can't inline - recursion");
+                s_inline_stats.n_rejected_recursion ++;
                 continue ;
             }
 
@@ -1724,9 +1785,20 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
             if( ! H::can_inline(path, *called_mir, te->args, minimal) )
             {
                 DEBUG("Can't inline " << path);
+                // NOTE: `minimal` passes don't inline anything yet, so aren't a budget decision
+                if( !minimal )
+                    s_inline_stats.n_rejected_cost ++;
                 continue ;
             }
             TRACE_FUNCTION_F("Inline " << path);
+            s_inline_stats.n_inlined ++;
+            if( s_inline_stats.enabled )
+            {
+                auto it = s_inline_stats.inlined_paths.find(path);
+                if( it == s_inline_stats.inlined_paths.end() )
+                    it = s_inline_stats.inlined_paths.insert(::std::make_pair(path.clone(), 0u)).first;
+                it->second ++;
+            }
 
             // Allocate a temporary for the return value
             {
@@ -3250,7 +3322,7 @@ bool MIR_Optimise_PropagateKnownValues(::MIR::TypeResolve& state, ::MIR::Functio
 bool MIR_Optimise_ConstPropagate(::MIR::TypeResolve& state, ::MIR::Function& fcn)
 {
 #if DUMP_BEFORE_ALL || DUMP_BEFORE_CONSTPROPAGATE
-    if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+    if( debug_enabled() ) MIR_Dump_Fcn(debug_stream(), fcn);
 #endif
     bool changed = false;
     TRACE_FUNCTION_FR("", changed);
@@ -4560,6 +4632,305 @@ bool MIR_Optimise_SplitAggregates(::MIR::TypeResolve& state, ::MIR::Function& fc
     return true;
 }
 
+// --------------------------------------------------------------------
+// Value numbering over single-assignment scalar locals
+// - Locals that are assigned exactly once and never borrowed are already in SSA form, so their values can be
+//   numbered in one walk of the dominator tree (no phi nodes are needed, as no such local is assigned on two paths)
+// - `a = b` (both single-assignment) is removed and `a` replaced by `b` (copy propagation)
+// - `a = OP(..)` where a dominating `b = OP(..)` exists with the same operands becomes `a = b` (and is then removed)
+// --------------------------------------------------------------------
+bool MIR_Optimise_ValueNumbering(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
+
+    if( fcn.blocks.empty() )
+        return false;
+
+    // 1. Locate single-assignment (SSA) locals
+    struct LocalInfo {
+        unsigned    n_writes = 0;
+        bool    invalid = false;    // Borrowed, or partially written
+    };
+    ::std::vector<LocalInfo>    local_info( fcn.locals.size() );
+    // Arguments are defined on entry, so are usable if never written or borrowed
+    ::std::vector<bool> arg_invalid;
+    visit_mir_lvalues(state, fcn, [&](const ::MIR::LValue& lv, ValUsage vu) {
+        if( lv.m_root.is_Argument() )
+        {
+            auto idx = lv.m_root.as_Argument();
+            if( idx >= arg_invalid.size() )
+                arg_invalid.resize(idx + 1);
+            if( vu == ValUsage::Borrow || vu == ValUsage::Write )
+                arg_invalid[idx] = true;
+        }
+        else if( lv.m_root.is_Local() )
+        {
+            auto& li = local_info[lv.m_root.as_Local()];
+            if( vu == ValUsage::Borrow ) {
+                li.invalid = true;
+            }
+            else if( vu == ValUsage::Write ) {
+                if( lv.m_wrappers.empty() )
+                    li.n_writes ++;
+                else
+                    li.invalid = true;
+            }
+        }
+        return false;
+        });
+    ::std::vector<bool> is_ssa( fcn.locals.size() );
+    for(size_t i = 0; i < fcn.locals.size(); i ++)
+    {
+        const auto& ty = fcn.locals[i];
+        bool is_scalar = ty.data().is_Primitive() || ty.data().is_Pointer()
+            || (ty.data().is_Borrow() && ty.data().as_Borrow().type == ::HIR::BorrowType::Shared);
+        is_ssa[i] = is_scalar && local_info[i].n_writes == 1 && !local_info[i].invalid;
+    }
+
+    // Replacements for SSA locals (always pointing to another SSA local that dominates all uses)
+    ::std::vector<unsigned> replacements( fcn.locals.size(), ~0u );
+    auto get_replacement = [&](unsigned idx)->unsigned {
+        while( replacements[idx] != ~0u )
+            idx = replacements[idx];
+        return idx;
+        };
+    // Only SSA locals and constants have a value that can't change between two evaluations
+    auto lvalue_is_stable = [&](const ::MIR::LValue& lv) {
+        if( !lv.m_wrappers.empty() )
+            return false;
+        if( lv.m_root.is_Argument() )
+            return !arg_invalid.at(lv.m_root.as_Argument());
+        return lv.m_root.is_Local() && is_ssa[lv.m_root.as_Local()];
+        };
+    auto lvalue_is_ssa_local = [&](const ::MIR::LValue& lv) {
+        return lv.is_Local() && is_ssa[lv.as_Local()];
+        };
+    auto param_is_stable = [&](const ::MIR::Param& p) {
+        if( p.is_Constant() )
+            return true;
+        return p.is_LValue() && lvalue_is_stable(p.as_LValue());
+        };
+    auto replace_lvalue = [&](::MIR::LValue& lv) {
+        if( lvalue_is_ssa_local(lv) ) {
+            lv = ::MIR::LValue::new_Local(get_replacement(lv.as_Local()));
+        }
+        };
+    auto replace_param = [&](::MIR::Param& p) {
+        if( p.is_LValue() )
+            replace_lvalue(p.as_LValue());
+        };
+
+    // 2. Walk the dominator tree, numbering pure operations on stable values
+    struct Entry {
+        const ::MIR::RValue*    rval;
+        unsigned    local;
+    };
+    ::std::unordered_multimap<size_t, Entry>    table;
+    auto hash_lvalue = [](const ::MIR::LValue& lv)->size_t {
+        if( lv.m_root.is_Argument() )
+            return ~static_cast<size_t>(lv.m_root.as_Argument());
+        return lv.m_root.is_Local() ? lv.m_root.as_Local() : 0;
+        };
+    auto hash_param = [&](const ::MIR::Param& p)->size_t {
+        if( p.is_LValue() )
+            return hash_lvalue(p.as_LValue());
+        if( p.is_Constant() ) {
+            const auto& c = p.as_Constant();
+            if( c.is_Int() )    return static_cast<size_t>(c.as_Int().v);
+            if( c.is_Uint() )   return static_cast<size_t>(c.as_Uint().v);
+            if( c.is_Bool() )   return c.as_Bool().v;
+        }
+        return 0;
+        };
+    auto hash_rvalue = [&](const ::MIR::RValue& rv)->size_t {
+        size_t h = static_cast<size_t>(rv.tag()) * 0x9E3779B9u;
+        TU_MATCH_HDRA( (rv), {)
+        default:
+            break;
+        TU_ARMA(BinOp, se) {
+            h ^= static_cast<size_t>(se.op) + (hash_param(se.val_l) << 8) + (hash_param(se.val_r) << 20);
+            }
+        TU_ARMA(UniOp, se) {
+            h ^= static_cast<size_t>(se.op) + (hash_lvalue(se.val) << 8);
+            }
+        TU_ARMA(Cast, se) {
+            // Include the target type, so casts of one value to different types don't share a bucket
+            size_t th = static_cast<size_t>(se.type.data().tag());
+            if( se.type.data().is_Primitive() )
+                th = (th << 8) + static_cast<size_t>(se.type.data().as_Primitive());
+            h ^= hash_lvalue(se.val) + (th << 20);
+            }
+        TU_ARMA(DstMeta, se) {
+            h ^= hash_lvalue(se.val);
+            }
+        TU_ARMA(DstPtr, se) {
+            h ^= hash_lvalue(se.val);
+            }
+        }
+        return h;
+        };
+
+    ::MIR::BlockDominators  doms(fcn);
+    // Pre-order walk of the dominator tree, with the entries added by each block (removed on exit)
+    // - Entries are recorded as (hash, rvalue) instead of iterators, as iterators don't survive a rehash
+    typedef ::std::pair<size_t, const ::MIR::RValue*>   ScopeEntry;
+    ::std::vector<::MIR::BasicBlockId>  stack;
+    ::std::vector<::std::vector<ScopeEntry>>    scope_entries;
+    stack.push_back(0);
+    scope_entries.push_back({});
+    ::std::vector<size_t>   child_pos;
+    child_pos.push_back(0);
+    auto process_block = [&](::MIR::BasicBlockId bb_idx, ::std::vector<ScopeEntry>& added) {
+        auto& bb = fcn.blocks[bb_idx];
+        for(size_t stmt_idx = 0; stmt_idx < bb.statements.size(); stmt_idx ++)
+        {
+            auto& stmt = bb.statements[stmt_idx];
+            if( !stmt.is_Assign() )
+                continue ;
+            auto& se = stmt.as_Assign();
+            if( !lvalue_is_ssa_local(se.dst) )
+                continue ;
+            auto dst = se.dst.as_Local();
+            state.set_cur_stmt(bb_idx, stmt_idx);
+
+            // Substitute already-known replacements into the operands
+            bool is_pure = false;
+            TU_MATCH_HDRA( (se.src), {)
+            default:
+                break;
+            TU_ARMA(Use, e) {
+                if( lvalue_is_ssa_local(e) ) {
+                    auto src = get_replacement(e.as_Local());
+                    if( fcn.locals[src] == fcn.locals[dst] ) {
+                        DEBUG(state << "Copy " << se.dst << " => Local(" << src << ")");
+                        replacements[dst] = src;
+                    }
+                }
+                }
+            TU_ARMA(BinOp, e) {
+                is_pure = param_is_stable(e.val_l) && param_is_stable(e.val_r);
+                if( is_pure ) {
+                    replace_param(e.val_l);
+                    replace_param(e.val_r);
+                }
+                }
+            TU_ARMA(UniOp, e) {
+                is_pure = lvalue_is_stable(e.val);
+                if( is_pure )
+                    replace_lvalue(e.val);
+                }
+            TU_ARMA(Cast, e) {
+                is_pure = lvalue_is_stable(e.val);
+                if( is_pure )
+                    replace_lvalue(e.val);
+                }
+            TU_ARMA(DstMeta, e) {
+                is_pure = lvalue_is_stable(e.val);
+                if( is_pure )
+                    replace_lvalue(e.val);
+                }
+            TU_ARMA(DstPtr, e) {
+                is_pure = lvalue_is_stable(e.val);
+                if( is_pure )
+                    replace_lvalue(e.val);
+                }
+            }
+            if( !is_pure )
+                continue ;
+
+            auto h = hash_rvalue(se.src);
+            auto range = table.equal_range(h);
+            bool found = false;
+            for(auto it = range.first; it != range.second; ++it)
+            {
+                if( *it->second.rval == se.src && fcn.locals[it->second.local] == fcn.locals[dst] )
+                {
+                    DEBUG(state << "Redundant " << se.src << " - already in Local(" << it->second.local << ")");
+                    replacements[dst] = it->second.local;
+                    found = true;
+                    break;
+                }
+            }
+            if( !found )
+            {
+                table.insert(::std::make_pair(h, Entry { &se.src, dst }));
+                added.push_back(::std::make_pair(h, &se.src));
+            }
+        }
+        };
+    auto pop_scope = [&](const ::std::vector<ScopeEntry>& added) {
+        // Erase exactly the entries this scope inserted (the order of equal-hash entries is unspecified)
+        for(const auto& ent : added)
+        {
+            auto range = table.equal_range(ent.first);
+            for(auto e = range.first; e != range.second; ++e)
+            {
+                if( e->second.rval == ent.second ) {
+                    table.erase(e);
+                    break;
+                }
+            }
+        }
+        };
+    process_block(0, scope_entries.back());
+    while( !stack.empty() )
+    {
+        auto bb = stack.back();
+        const auto& children = doms.children(bb);
+        if( child_pos.back() < children.size() )
+        {
+            auto c = children[child_pos.back()++];
+            stack.push_back(c);
+            child_pos.push_back(0);
+            scope_entries.push_back({});
+            process_block(c, scope_entries.back());
+        }
+        else
+        {
+            pop_scope(scope_entries.back());
+            stack.pop_back();
+            child_pos.pop_back();
+            scope_entries.pop_back();
+        }
+    }
+
+    // 3. Remove the assignments of replaced locals, and rewrite all uses
+    bool any_replaced = false;
+    for(auto r : replacements)
+        any_replaced |= (r != ~0u);
+    if( !any_replaced )
+        return false;
+
+    for(auto& bb : fcn.blocks)
+    {
+        for(auto it = bb.statements.begin(); it != bb.statements.end(); )
+        {
+            if( it->is_Assign() && it->as_Assign().dst.is_Local() && replacements[it->as_Assign().dst.as_Local()] != ~0u ) {
+                it = bb.statements.erase(it);
+            }
+            else {
+                ++ it;
+            }
+        }
+    }
+    auto replace_idx = [&](unsigned idx)->unsigned {
+        return is_ssa[idx] ? get_replacement(idx) : idx;
+        };
+    visit_mir_lvalues_mut(state, fcn, [&](auto& lv, auto ) {
+        if( lv.m_root.is_Local() ) {
+            lv.m_root = ::MIR::LValue::Storage::new_Local(replace_idx(lv.m_root.as_Local()));
+        }
+        for(auto& w : lv.m_wrappers) {
+            if( w.is_Index() )
+                w = ::MIR::LValue::Wrapper::new_Index(replace_idx(w.as_Index()));
+        }
+        return false;
+        });
+    changed = true;
+    return changed;
+}
+
 // --------------------------------------------------------------------
 // Replace `tmp = RValue::Use()` where the temp is only used once
 // --------------------------------------------------------------------
@@ -5220,7 +5591,42 @@ bool MIR_Optimise_DeadAssignments(::MIR::TypeResolve& state, ::MIR::Function& fc
         }
     }
 
-    // Locate assignments of locals then find the next assignment or read.
+    // Remove assignments of locals that are overwritten (or never read) before the next read
+    {
+        ::MIR::LocalLiveness    liveness(fcn);
+        // Visit blocks in reverse, so edits can propagate to the predecessors (mostly) before they're visited.
+        for(size_t bb_idx = fcn.blocks.size(); bb_idx --; )
+        {
+            auto& bb = fcn.blocks[bb_idx];
+            if( bb.terminator.tag() == ::MIR::Terminator::TAGDEAD )
+                continue ;
+            auto live = liveness.live_out(bb_idx);
+            ::MIR::LocalLiveness::step_terminator(live, bb.terminator);
+            bool block_changed = false;
+            for(size_t stmt_idx = bb.statements.size(); stmt_idx --; )
+            {
+                const auto& stmt = bb.statements[stmt_idx];
+                if( const auto* se = stmt.opt_Assign() )
+                {
+                    if( se->dst.is_Local() && !live.get(se->dst.as_Local()) && !liveness.is_borrowed(se->dst.as_Local()) )
+                    {
+                        state.set_cur_stmt(bb_idx, stmt_idx);
+                        DEBUG(state << "Dead assignment, remove - " << stmt);
+                        bb.statements.erase(bb.statements.begin() + stmt_idx);
+                        block_changed = true;
+                        continue ;
+                    }
+                }
+                ::MIR::LocalLiveness::step_statement(live, stmt);
+            }
+            if( block_changed )
+            {
+                liveness.invalidate_block(bb_idx);
+                changed = true;
+            }
+        }
+    }
+
     return changed;
 }
 
@@ -6098,36 +6504,129 @@ void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list)
 {
     ::StaticTraitResolve    resolve { crate };
 
+    s_inline_stats.clear();
+    s_inline_stats.enabled = getenv("MRUSTC_INLINE_STATS") != nullptr;
+
+    // Call graph over the enumerated functions, used to process callees before their callers (so callers see
+    // already-optimised callees, and don't need to be re-visited)
+    struct Node {
+        ::std::pair<const ::HIR::Path, ::std::unique_ptr<TransList_Function>>*  ent;
+        ::std::vector<size_t>   callees;
+        // Step numbers of the last visit, and the last visit that changed the function (0 = never)
+        unsigned    processed_at = 0;
+        unsigned    changed_at = 0;
+    };
+    ::std::vector<Node> nodes;
+    ::std::unordered_map<const TransList_Function*, size_t> node_indexes;
+    nodes.reserve(list.m_functions.size());
+    for(auto& fcn_ent : list.m_functions)
+    {
+        node_indexes.insert(::std::make_pair(fcn_ent.second.get(), nodes.size()));
+        nodes.push_back(Node { &fcn_ent });
+    }
+
+    auto get_mir = [](const TransList_Function& ent)->const ::MIR::Function* {
+        if( ent.monomorphised.code )
+            return &*ent.monomorphised.code;
+        return ent.ptr->m_code.get_mir_opt();
+        };
+    auto enum_callees = [&](Node& n) {
+        n.callees.clear();
+        if( const auto* mir = get_mir(*n.ent->second) )
+        {
+            for(const auto& bb : mir->blocks)
+            {
+                if( const auto* te = bb.terminator.opt_Call() )
+                {
+                    if( !te->fcn.is_Path() )
+                        continue;
+                    auto it = list.m_functions.find(te->fcn.as_Path());
+                    if( it != list.m_functions.end() )
+                        n.callees.push_back(node_indexes.at(it->second.get()));
+                }
+            }
+        }
+        };
+    for(auto& n : nodes)
+        enum_callees(n);
+
+    // Post-order (callees first) traversal of the call graph
+    ::std::vector<size_t>   order;
+    {
+        order.reserve(nodes.size());
+        ::std::vector<bool> visited(nodes.size());
+        ::std::vector<::std::pair<size_t,size_t>>  stack;
+        for(size_t root = 0; root < nodes.size(); root ++)
+        {
+            if( visited[root] )
+                continue;
+            visited[root] = true;
+            stack.push_back(::std::make_pair(root, 0));
+            while( !stack.empty() )
+            {
+                auto idx = stack.back().first;
+                auto next = stack.back().second;
+                if( next < nodes[idx].callees.size() )
+                {
+                    stack.back().second ++;
+                    auto c = nodes[idx].callees[next];
+                    if( !visited[c] ) {
+                        visited[c] = true;
+                        stack.push_back(::std::make_pair(c, 0));
+                    }
+                }
+                else
+                {
+                    order.push_back(idx);
+                    stack.pop_back();
+                }
+            }
+        }
+    }
+
     bool did_inline_on_pass;
 
-    size_t  MAX_ITERATIONS = 5; // TODO: Tune this.
+    // Only functions in call-graph cycles (or that gained new callees) need revisiting after the first pass
+    const size_t  MAX_ITERATIONS = 5;
     size_t  num_iterations = 0;
+    unsigned step = 0;
     do
     {
         did_inline_on_pass = false;
 
-        for(auto& fcn_ent : list.m_functions)
+        for(auto idx : order)
         {
-            const auto& path = fcn_ent.first;
-            //const auto& pp = fcn_ent.second->pp;
-            auto& hir_fcn = *const_cast<::HIR::Function*>(fcn_ent.second->ptr);
-            auto& mono_fcn = fcn_ent.second->monomorphised;
+            auto& node = nodes[idx];
+            // Skip if no callee has changed since this function was last processed
+            if( node.processed_at != 0 )
+            {
+                bool callee_changed = false;
+                for(auto c : node.callees)
+                    callee_changed |= (nodes[c].changed_at > node.processed_at);
+                if( !callee_changed )
+                    continue ;
+            }
+
+            const auto& path = node.ent->first;
+            //const auto& pp = node.ent->second->pp;
+            auto& hir_fcn = *const_cast<::HIR::Function*>(node.ent->second->ptr);
+            auto& mono_fcn = node.ent->second->monomorphised;
 
             ::std::string s = FMT(path);
             ::HIR::ItemPath ip(s);
 
+            bool did_opt = false;
             if( mono_fcn.code )
             {
-                did_inline_on_pass |= MIR_OptimiseInline(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty, list);
+                did_opt = MIR_OptimiseInline(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty, list);
 
                 MIR_Cleanup(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty);
             }
             else if( hir_fcn.m_code )
             {
                 auto& mir = hir_fcn.m_code.get_mir_or_error_mut(Span());
-                bool did_opt = MIR_OptimiseInline(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return, list);
+                did_opt = MIR_OptimiseInline(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return, list);
                 mir.trans_enum_state = ::MIR::EnumCachePtr();   // Clear MIR enum cache
-                did_inline_on_pass |= did_opt;
 
                 MIR_Cleanup(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return);
             }
@@ -6135,11 +6634,38 @@ void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list)
             {
                 // Extern, no optimisations
             }
+
+            node.processed_at = ++ step;
+            if( did_opt )
+            {
+                node.changed_at = step;
+                // Inlining pulls in the callee's calls, so refresh the edges
+                enum_callees(node);
+                did_inline_on_pass = true;
+            }
         }
+        num_iterations ++;
     } while( did_inline_on_pass && num_iterations < MAX_ITERATIONS );
 
     if( did_inline_on_pass )
     {
         DEBUG("Ran inlining optimise pass to exhaustion (maximum of " << MAX_ITERATIONS << " hit");
     }
+
+    if( s_inline_stats.enabled )
+    {
+        ::std::vector<const ::std::pair<const ::HIR::Path, unsigned>*>  sorted;
+        for(const auto& e : s_inline_stats.inlined_paths)
+            sorted.push_back(&e);
+        ::std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b){ return a->second > b->second; });
+
+        ::std::cout << "Inlining: " << nodes.size() << " functions, " << num_iterations << " passes, " << step << " visits" << ::std::endl;
+        ::std::cout << "- " << s_inline_stats.n_considered << " calls considered, " << s_inline_stats.n_inlined << " inlined"
+            << " (" << s_inline_stats.n_rejected_cost << " over budget, "
+            << s_inline_stats.n_rejected_recursion << " recursive)" << ::std::endl;
+        for(size_t i = 0; i < sorted.size() && i < 20; i ++)
+        {
+            ::std::cout << "- " << ::std::setw(6) << sorted[i]->second << " " << sorted[i]->first << ::std::endl;
+        }
+    }
 }
@@ -7,6 +7,8 @@
  */
 #include "visit_crate_mir.hpp"
 #include <hir/expr.hpp>
+#include <parallel.hpp>
+#include <deque>
 
 // NOTE: This is left here to ensure that any expressions that aren't handled by higher code cause a failure
 void MIR::OuterVisitor::visit_expr(::HIR::ExprPtr& exp)
@@ -86,3 +88,67 @@ void MIR::OuterVisitor::visit_trait_impl(const ::HIR::SimplePath& trait_path, ::
     auto _ = this->m_resolve.set_impl_generics(impl.m_params);
     ::HIR::Visitor::visit_trait_impl(trait_path, impl);
 }
+
+namespace {
+    struct BodyJob
+    {
+        /// Copy of the item path (the one passed to the visitor callback refers to the visitor's stack)
+        ::std::vector<::HIR::ItemPath>  path_nodes;
+        /// Trait paths referenced by `path_nodes` (trait items use a path that only lives as long as the visit)
+        ::std::vector<::std::unique_ptr<::HIR::SimplePath>>   trait_paths;
+        const ::HIR::GenericParams* impl_generics;
+        const ::HIR::GenericParams* item_generics;
+        ::HIR::ExprPtr* expr;
+        const ::HIR::Function::args_t*  args;
+        ::HIR::TypeRef  ret_type;
+
+        const ::HIR::ItemPath& path() const { return path_nodes.front(); }
+    };
+}
+
+void MIR::visit_crate_bodies(::HIR::Crate& crate, OuterVisitor::cb_t cb)
+{
+    if( parallel::num_jobs() <= 1 )
+    {
+        OuterVisitor    ov(crate, cb);
+        ov.visit_crate(crate);
+        return ;
+    }
+
+    // Collect the bodies (in visit order, so diagnostics come out in the same order as the serial visit)
+    static const ::HIR::Function::args_t    empty_args;
+    // NOTE: A deque, as the jobs contain pointers into themselves (and can't be copied)
+    ::std::deque<BodyJob>   jobs;
+    OuterVisitor    ov(crate, [&](const auto& res, const auto& p, ::HIR::ExprPtr& expr, const auto& args, const auto& ty) {
+        BodyJob job;
+        for(const auto* n = &p; n; n = n->parent)
+            job.path_nodes.push_back(*n);
+        for(size_t i = 0; i < job.path_nodes.size(); i ++)
+        {
+            auto& n = job.path_nodes[i];
+            if( i + 1 < job.path_nodes.size() )
+                n.parent = &job.path_nodes[i+1];
+            if( n.trait )
+            {
+                job.trait_paths.push_back(::std::make_unique<::HIR::SimplePath>(n.trait->clone()));
+                n.trait = job.trait_paths.back().get();
+            }
+        }
+        job.impl_generics = res.m_impl_generics;
+        job.item_generics = res.m_item_generics;
+        job.expr = &expr;
+        // Arguments are either from the item, or an empty temporary
+        job.args = args.empty() ? &empty_args : &args;
+        job.ret_type = ty.clone();
+        jobs.push_back(mv$(job));
+        });
+    ov.visit_crate(crate);
+    DEBUG(jobs.size() << " bodies");
+
+    parallel::for_each(jobs.size(), [&](size_t i) {
+        const auto& job = jobs[i];
+        StaticTraitResolve  resolve(crate);
+        resolve.set_both_generics_raw(job.impl_generics, job.item_generics);
+        cb(resolve, job.path(), *job.expr, *job.args, job.ret_type);
+        });
+}
@@ -16,7 +16,7 @@ class OuterVisitor:
 {
 public:
     typedef ::std::function<void(const StaticTraitResolve& resolve, const ::HIR::ItemPath& ip, ::HIR::ExprPtr& expr, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ret_type)>  cb_t;
-private:
+protected:
     StaticTraitResolve  m_resolve;
     cb_t  m_cb;
 public:
@@ -43,5 +43,10 @@ public:
     void visit_trait_impl(const ::HIR::SimplePath& trait_path, ::HIR::TraitImpl& impl) override;
 };
 
+/// Run `cb` on every MIR-containing body in the crate (as `OuterVisitor` does), with the bodies distributed across
+/// worker threads when `parallel::num_jobs` is more than one.
+///
+/// The callback gets a `StaticTraitResolve` private to the body, so must not touch anything shared between bodies.
+extern void visit_crate_bodies(::HIR::Crate& crate, OuterVisitor::cb_t cb);
 
 }   // namespace MIR
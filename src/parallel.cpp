@@ -0,0 +1,156 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * parallel.cpp
+ * - Running independent per-item work on multiple threads
+ */
+#include <parallel.hpp>
+#include <debug.hpp>
+#include <rc_string.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <exception>
+#include <algorithm>  // std::min
+#include <cstdlib>  // abort/exit
+
+namespace {
+    unsigned s_num_jobs = 1;
+
+    /// Thrown by `fatal_error` to unwind a failed item
+    struct ItemFailed {};
+
+    /// Diagnostic buffer of the item being run by this thread (null if not in a worker)
+    thread_local ::std::ostringstream*  t_diag_buffer = nullptr;
+
+    /// Unwind the current item, or stop the compiler (the part of `fatal_error` after the trace is printed)
+    [[noreturn]] void fail_current()
+    {
+        if( t_diag_buffer )
+            throw ItemFailed();
+#ifndef _WIN32
+        abort();
+#else
+        exit(1);
+#endif
+    }
+}
+
+namespace parallel {
+
+void set_num_jobs(unsigned n)
+{
+    s_num_jobs = (n == 0 ? 1 : n);
+}
+unsigned num_jobs()
+{
+    return s_num_jobs;
+}
+bool in_worker()
+{
+    return t_diag_buffer != nullptr;
+}
+
+void for_each(size_t count, ::std::function<void(size_t)> cb)
+{
+    // Nested calls run serially
+    if( s_num_jobs <= 1 || count <= 1 || in_worker() )
+    {
+        for(size_t i = 0; i < count; i ++)
+            cb(i);
+        return ;
+    }
+
+    struct Item {
+        ::std::ostringstream    diag;
+        ::std::ostringstream    debug;
+        bool    fatal = false;
+        ::std::exception_ptr    exception;
+    };
+    ::std::vector<Item> items(count);
+    ::std::atomic<size_t>   next_item { 0 };
+    // Index of the first item to fail, items after this are not started (a serial run would never reach them)
+    ::std::atomic<size_t>   first_failure { count };
+
+    // Debug output from each item is buffered (like diagnostics), and printed in item order
+    int parent_indent = g_debug_indent_level;
+    auto worker = [&]() {
+        g_debug_indent_level = parent_indent;
+        for(;;)
+        {
+            size_t i = next_item.fetch_add(1);
+            if( i >= count || i > first_failure.load() )
+                break;
+            auto& item = items[i];
+            t_diag_buffer = &item.diag;
+            auto* prev_sink = debug_set_thread_sink(&item.debug);
+            try
+            {
+                cb(i);
+            }
+            catch(const ItemFailed& )
+            {
+                item.fatal = true;
+            }
+            catch(...)
+            {
+                item.exception = ::std::current_exception();
+            }
+            t_diag_buffer = nullptr;
+            debug_set_thread_sink(prev_sink);
+
+            if( item.fatal || item.exception )
+            {
+                size_t cur = first_failure.load();
+                while( i < cur && !first_failure.compare_exchange_weak(cur, i) )
+                    ;
+            }
+        }
+        };
+
+    size_t n_threads = ::std::min<size_t>(s_num_jobs, count);
+    ::std::vector<::std::thread>    threads;
+    threads.reserve(n_threads - 1);
+    RcString::set_threaded(true);
+    for(size_t i = 1; i < n_threads; i ++)
+        threads.push_back(::std::thread(worker));
+    worker();
+    for(auto& t : threads)
+        t.join();
+    RcString::set_threaded(false);
+
+    // Emit diagnostics in item order, up to (and including) the first failure
+    size_t failed_idx = first_failure.load();
+    for(size_t i = 0; i < count && i <= failed_idx; i ++)
+    {
+        ::std::cout << items[i].debug.str();
+        ::std::cerr << items[i].diag.str();
+    }
+    ::std::cout.flush();
+    ::std::cerr.flush();
+    if( failed_idx < count )
+    {
+        if( items[failed_idx].exception )
+            ::std::rethrow_exception(items[failed_idx].exception);
+        // The failed item's trace was printed (from its own thread) with its diagnostics
+        fail_current();
+    }
+}
+
+::std::ostream& diag_stream()
+{
+    if( t_diag_buffer )
+        return *t_diag_buffer;
+    return ::std::cerr;
+}
+
+void fatal_error()
+{
+    debug_dump_trace(diag_stream());
+    fail_current();
+}
+
+}   // namespace parallel
@@ -8,9 +8,11 @@
 #include "lex.hpp"
 #include "tokentree.hpp"
 #include "parseerror.hpp"
+#include "prefetch.hpp"
 #include "../common.hpp"
 #include <cassert>
 #include <iostream>
+#include <sstream>  // istringstream
 #include <cstdlib>  // strtol
 #include <typeinfo>
 #include <algorithm>    // std::count
@@ -18,20 +20,36 @@
 //#define TRACE_CHARS
 //#define TRACE_RAW_TOKENS
 
+namespace {
+    /// Open a source file (using the contents loaded by the module prefetcher if present)
+    ::std::istream* open_source_file(const ::std::string& filename)
+    {
+        if( filename == "-" )
+            return nullptr;
+        ::std::string   contents;
+        if( Parse_TakePrefetchedFile(filename, contents) )
+        {
+            DEBUG("Prefetched " << filename);
+            return new ::std::istringstream(mv$(contents));
+        }
+        return new ::std::ifstream(filename.c_str());
+    }
+}
+
 Lexer::Lexer(const ::std::string& filename, AST::Edition edition, ParseState ps):
     TokenStream(ps),
     m_path(filename.c_str()),
     m_line(1),
     m_line_ofs(0),
-    m_istream_fp(filename != "-" ? new std::ifstream(filename.c_str()) : nullptr),
-    m_istream(filename != "-" ? *m_istream_fp : std::cin),
+    m_istream_fp(open_source_file(filename)),
+    m_istream(m_istream_fp ? *m_istream_fp : std::cin),
     m_last_char_valid(false),
     m_edition(edition),
     m_hygiene( Ident::Hygiene::new_scope() )
 {
     if( m_istream_fp )
     {
-        if( !m_istream_fp->is_open() )
+        if( m_istream_fp->fail() )
         {
             throw ::std::runtime_error("Unable to open file '" + filename + "'");
         }
@@ -39,7 +39,7 @@ class Lexer:
     unsigned int m_line;
     unsigned int m_line_ofs;
 
-    ::std::unique_ptr<::std::ifstream>  m_istream_fp;
+    ::std::unique_ptr<::std::istream>  m_istream_fp;
     ::std::istream& m_istream;
     bool    m_last_char_valid;
     Codepoint   m_last_char;
@@ -0,0 +1,267 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * parse/prefetch.cpp
+ * - Background loading of module source files
+ */
+#include "prefetch.hpp"
+#include <path.h>
+#include <cctype>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    struct Task {
+        ::std::string   path;
+        /// Directory that child modules are relative to
+        ::std::string   dir;
+        /// Name of the module (used for child modules of a non-`mod.rs` file)
+        ::std::string   mod_name;
+        /// Child modules are in `dir` (instead of `dir/mod_name`)
+        bool    controls_dir;
+    };
+    struct FileEntry {
+        bool    ready = false;
+        ::std::string   contents;
+    };
+
+    struct State
+    {
+        ::std::mutex    lock;
+        ::std::condition_variable   cv_tasks;
+        ::std::condition_variable   cv_ready;
+        bool    stop = false;
+        ::std::deque<Task>  queue;
+        /// Files queued or loaded (and not yet taken), keyed by normalised path
+        ::std::map<::std::string, FileEntry>    files;
+        /// Every path that has been queued (so a file is never loaded twice)
+        ::std::set<::std::string>   seen;
+        ::std::vector<::std::thread>    threads;
+    };
+    State*  s_state = nullptr;
+
+    ::std::string get_key(const ::std::string& path)
+    {
+        return ::helpers::path(path).str();
+    }
+    ::std::string get_dirname(::std::string input)
+    {
+        while( input.size() > 0 && input.back() != '/' && input.back() != '\\' ) {
+            input.pop_back();
+        }
+        return input;
+    }
+
+    /// Find the names of `mod name;` items in a source file (skipping comments and strings)
+    ///
+    /// This doesn't know about `#[cfg]` or `#[path]`, so it can find files that the parser won't load (and miss ones
+    /// that it will), which just costs a wasted read (or a read on the parser's thread).
+    void find_submodules(const ::std::string& s, ::std::vector<::std::string>& out)
+    {
+        auto is_ident = [](char c) { return ::std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+        auto skip_ws = [&](size_t i) { while( i < s.size() && ::std::isspace(static_cast<unsigned char>(s[i])) ) i ++; return i; };
+        size_t i = 0;
+        while( i < s.size() )
+        {
+            char c = s[i];
+            char c2 = i + 1 < s.size() ? s[i+1] : '\0';
+            if( c == '/' && c2 == '/' )
+            {
+                i = s.find('\n', i);
+                if( i == ::std::string::npos )
+                    break;
+            }
+            else if( c == '/' && c2 == '*' )
+            {
+                unsigned level = 1;
+                i += 2;
+                while( i < s.size() && level > 0 )
+                {
+                    if( s.compare(i, 2, "/*") == 0 ) { level ++; i += 2; }
+                    else if( s.compare(i, 2, "*/") == 0 ) { level --; i += 2; }
+                    else { i ++; }
+                }
+            }
+            else if( c == '\'' && c2 == '"' )
+            {
+                // Character literal of a double quote (don't treat as the start of a string)
+                i += 2;
+            }
+            else if( c == '"' )
+            {
+                i ++;
+                while( i < s.size() && s[i] != '"' )
+                {
+                    i += (s[i] == '\\' ? 2 : 1);
+                }
+                i ++;
+            }
+            else if( is_ident(c) )
+            {
+                size_t start = i;
+                while( i < s.size() && is_ident(s[i]) )
+                    i ++;
+                if( i - start == 3 && s.compare(start, 3, "mod") == 0 )
+                {
+                    size_t name_start = skip_ws(i);
+                    size_t name_end = name_start;
+                    while( name_end < s.size() && is_ident(s[name_end]) )
+                        name_end ++;
+                    if( name_end > name_start && skip_ws(name_end) < s.size() && s[skip_ws(name_end)] == ';' )
+                    {
+                        out.push_back(s.substr(name_start, name_end - name_start));
+                        i = name_end;
+                    }
+                }
+            }
+            else
+            {
+                i ++;
+            }
+        }
+    }
+
+    /// Queue a file to be loaded (lock must be held)
+    void queue_file(State& state, Task task)
+    {
+        auto key = get_key(task.path);
+        if( !state.seen.insert(key).second )
+            return ;
+        state.files[key];
+        state.queue.push_back(::std::move(task));
+        state.cv_tasks.notify_one();
+    }
+
+    void worker(State& state)
+    {
+        for(;;)
+        {
+            Task    task;
+            {
+                ::std::unique_lock<::std::mutex>    lh { state.lock };
+                state.cv_tasks.wait(lh, [&]{ return state.stop || !state.queue.empty(); });
+                if( state.stop )
+                    return ;
+                task = ::std::move(state.queue.front());
+                state.queue.pop_front();
+            }
+
+            ::std::string   contents;
+            bool found = false;
+            {
+                ::std::ifstream ifs(task.path, ::std::ios::binary);
+                if( ifs.is_open() )
+                {
+                    ::std::stringstream ss;
+                    ss << ifs.rdbuf();
+                    contents = ss.str();
+                    found = true;
+                }
+            }
+
+            // Child module files, using the same rules as `Parse_Mod_Item_S` (without `#[path]`)
+            ::std::vector<Task> children;
+            if( found )
+            {
+                ::std::vector<::std::string>    names;
+                find_submodules(contents, names);
+                for(const auto& name : names)
+                {
+                    if( task.controls_dir )
+                    {
+                        auto sub_path = ::helpers::path(task.dir) / name.c_str();
+                        children.push_back(Task { (sub_path + ".rs").str(), get_dirname((sub_path + ".rs").str()), name, false });
+                        children.push_back(Task { sub_path.str() + "/mod.rs", sub_path.str() + "/", name, true });
+                    }
+                    else
+                    {
+                        auto sub_path = ::helpers::path(task.dir) / task.mod_name.c_str() / name.c_str() + ".rs";
+                        children.push_back(Task { sub_path.str(), get_dirname(sub_path.str()), name, false });
+                    }
+                }
+            }
+
+            ::std::lock_guard<::std::mutex> lh { state.lock };
+            auto it = state.files.find(get_key(task.path));
+            if( it != state.files.end() )
+            {
+                if( found )
+                {
+                    it->second.ready = true;
+                    it->second.contents = ::std::move(contents);
+                }
+                else
+                {
+                    state.files.erase(it);
+                }
+                state.cv_ready.notify_all();
+            }
+            for(auto& t : children)
+                queue_file(state, ::std::move(t));
+        }
+    }
+}
+
+Parse_PrefetchScope::Parse_PrefetchScope(const ::std::string& root_file, unsigned num_threads)
+{
+    if( num_threads == 0 || root_file == "-" )
+        return ;
+    s_state = new State();
+
+    // Root module's directory, same as `Parse_Crate`
+    auto dir = get_dirname(root_file);
+    if( dir.empty() )
+        dir = "./";
+    {
+        ::std::lock_guard<::std::mutex> lh { s_state->lock };
+        queue_file(*s_state, Task { root_file, dir, "", true });
+    }
+    for(unsigned i = 0; i < num_threads; i ++)
+    {
+        auto* state = s_state;
+        s_state->threads.push_back(::std::thread([state]{ worker(*state); }));
+    }
+}
+Parse_PrefetchScope::~Parse_PrefetchScope()
+{
+    if( !s_state )
+        return ;
+    {
+        ::std::lock_guard<::std::mutex> lh { s_state->lock };
+        s_state->stop = true;
+        s_state->cv_tasks.notify_all();
+    }
+    for(auto& t : s_state->threads)
+        t.join();
+    delete s_state;
+    s_state = nullptr;
+}
+
+bool Parse_TakePrefetchedFile(const ::std::string& path, ::std::string& out_contents)
+{
+    if( !s_state || path.empty() )
+        return false;
+    auto key = get_key(path);
+    ::std::unique_lock<::std::mutex>    lh { s_state->lock };
+    for(;;)
+    {
+        auto it = s_state->files.find(key);
+        if( it == s_state->files.end() )
+            return false;
+        if( it->second.ready )
+        {
+            out_contents = ::std::move(it->second.contents);
+            s_state->files.erase(it);
+            return true;
+        }
+        s_state->cv_ready.wait(lh);
+    }
+}
@@ -0,0 +1,27 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * parse/prefetch.hpp
+ * - Background loading of module source files
+ */
+#pragma once
+#include <string>
+
+/// Loads the files of out-of-line modules (`mod foo;`) on worker threads while the crate is being parsed
+///
+/// Each loaded file is scanned for `mod name;` items, and the files those would be loaded from (using the default path
+/// rules) are queued too. Only the file contents are loaded early, lexing and parsing stay on the main thread (so
+/// hygiene, spans, and diagnostics are unchanged).
+class Parse_PrefetchScope
+{
+public:
+    /// Start loading from the crate root `root_file` (does nothing if `num_threads` is zero)
+    Parse_PrefetchScope(const ::std::string& root_file, unsigned num_threads);
+    /// Stops (and waits for) the worker threads, discarding any unused files
+    ~Parse_PrefetchScope();
+};
+
+/// Take the contents of a prefetched file (waiting if it's still being loaded). Returns false if the file wasn't
+/// prefetched.
+extern bool Parse_TakePrefetchedFile(const ::std::string& path, ::std::string& out_contents);
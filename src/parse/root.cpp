@@ -18,6 +18,8 @@
 #include <expand/cfg.hpp>   // check_cfg - for `mod nonexistant;`
 #include <fstream>  // Used by directory path
 #include "lex.hpp"  // New file lexer
+#include "prefetch.hpp"
+#include <parallel.hpp>   // num_jobs
 #include <parse/interpolated_fragment.hpp>
 #include <ast/expr.hpp>
 #include <macro_rules/macro_rules.hpp>
@@ -2318,6 +2320,9 @@ AST::Crate Parse_Crate(::std::string mainfile, AST::Edition edition)
 {
     Token   tok;
 
+    // Load module files on worker threads (ahead of the parser)
+    Parse_PrefetchScope prefetch(mainfile, parallel::num_jobs() > 1 ? parallel::num_jobs() - 1 : 0);
+
     Lexer lex(mainfile, edition, ParseState());
 
     size_t p = mainfile.find_last_of('/');
@@ -10,6 +10,7 @@
 #include <string>
 #include <iostream>
 #include <algorithm>    // std::max
+#include <mutex>
 
 RcString::RcString(const char* s, size_t len):
     m_ptr(nullptr)
@@ -18,7 +19,7 @@ RcString::RcString(const char* s, size_t len):
     {
         size_t nwords = (len+1 + sizeof(unsigned int)-1) / sizeof(unsigned int);
         m_ptr = reinterpret_cast<Inner*>(malloc(sizeof(Inner) + (nwords - 1) * sizeof(unsigned int)));
-        m_ptr->refcount = 1;
+        new(&m_ptr->refcount) ::std::atomic<unsigned int>(1);
         m_ptr->size = static_cast<unsigned>(len);
         m_ptr->ordering = 0;
         char* data_mut = reinterpret_cast<char*>(m_ptr->data);
@@ -33,9 +34,8 @@ RcString::~RcString()
 {
     if(m_ptr)
     {
-        m_ptr->refcount -= 1;
         //::std::cout << "RcString(" << m_ptr << " \"" << *this << "\") - " << *m_ptr << " refs left (drop)" << ::std::endl;
-        if( m_ptr->refcount == 0 )
+        if( m_ptr->refcount.fetch_sub(1, ::std::memory_order_acq_rel) == 1 )
         {
             free(m_ptr);
         }
@@ -90,12 +90,19 @@ struct Cmp_RcString_Raw {
 };
 // A set with a comparison function that always checks bytes (avoiding recursion with the cache)
 ::std::set<RcString,Cmp_RcString_Raw>    RcString_interned_strings;
-bool    RcString_interned_ordering_valid;
+::std::mutex    RcString_interned_lock;
+::std::atomic<bool> RcString_interned_ordering_valid;
+bool    RcString_threaded;
 
+void RcString::set_threaded(bool is_threaded)
+{
+    RcString_threaded = is_threaded;
+}
 RcString RcString::new_interned(const char* s, size_t len)
 {
     if(len == 0)
         return RcString();
+    ::std::lock_guard<::std::mutex> lh { RcString_interned_lock };
     auto ret = RcString_interned_strings.insert(RcString(s, len));
     // Set interned and invalidate the cache if an insert happened
     if(ret.second)
@@ -110,6 +117,9 @@ Ordering RcString::ord_interned(const RcString& s) const
     assert(s.is_interned() && this->is_interned());
     if(!RcString_interned_ordering_valid)
     {
+        // The cache order is the byte order, so that can be used until it's safe to re-populate the cache
+        if( RcString_threaded )
+            return this->ord(s.c_str(), s.size());
         // Populate cache
         unsigned i = 1;
         for(auto& e : RcString_interned_strings)
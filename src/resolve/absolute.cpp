@@ -16,6 +16,7 @@
 #include <ast/expr.hpp>
 #include <main_bindings.hpp>
 #include <hir/hir.hpp>
+#include <unordered_map>
 
 #define FLAG_CONST_GENERIC  (1u << 31)
 
@@ -1441,7 +1442,83 @@ namespace {
     }
 }
 
+namespace {
+    /// Results of `Resolve_Absolute_Path_BindAbsolute` for paths without generic parameters
+    ///
+    /// Binding an absolute path only looks at the crate's module tree and index (not at the module it's used from), so
+    /// the result is shared by every use of the same path. The index doesn't change during `Resolve_Absolutise`, so
+    /// the cache lives for that pass.
+    struct BindAbsoluteCache
+    {
+        struct Entry {
+            Context::LookupMode mode;
+            ::AST::Path path;
+        };
+        ::std::unordered_map<::std::string, Entry>  entries;
+        size_t  n_hits = 0;
+        size_t  n_misses = 0;
+
+        /// Get the cache key for a path (empty if the result can't be cached)
+        static ::std::string get_key(Context::LookupMode mode, const ::AST::Path& path)
+        {
+            if( path.m_bindings.has_binding() )
+                return "";
+            const auto& path_abs = path.m_class.as_Absolute();
+            ::std::string   rv;
+            rv += static_cast<char>('0' + static_cast<int>(mode));
+            rv += path_abs.crate.c_str();
+            for(const auto& n : path_abs.nodes)
+            {
+                if( !n.args().is_empty() )
+                    return "";
+                rv += "::";
+                rv += n.name().c_str();
+            }
+            return rv;
+        }
+        /// Only plain absolute paths are stored (UFCS results would carry types from the first use)
+        static bool can_store(const ::AST::Path& path)
+        {
+            if( !path.m_class.is_Absolute() )
+                return false;
+            for(const auto& n : path.m_class.as_Absolute().nodes)
+                if( !n.args().is_empty() )
+                    return false;
+            return true;
+        }
+    };
+    BindAbsoluteCache*  s_bind_absolute_cache = nullptr;
+}
+
+void Resolve_Absolute_Path_BindAbsolute_Inner(Context& context, const Span& sp, Context::LookupMode& mode, ::AST::Path& path);
 void Resolve_Absolute_Path_BindAbsolute(Context& context, const Span& sp, Context::LookupMode& mode, ::AST::Path& path)
+{
+    if( !s_bind_absolute_cache ) {
+        return Resolve_Absolute_Path_BindAbsolute_Inner(context, sp, mode, path);
+    }
+    auto& cache = *s_bind_absolute_cache;
+
+    auto key = BindAbsoluteCache::get_key(mode, path);
+    if( key == "" ) {
+        return Resolve_Absolute_Path_BindAbsolute_Inner(context, sp, mode, path);
+    }
+    auto it = cache.entries.find(key);
+    if( it != cache.entries.end() )
+    {
+        DEBUG("Cached: " << path << " = " << it->second.path);
+        cache.n_hits ++;
+        mode = it->second.mode;
+        path = ::AST::Path(it->second.path);
+        return ;
+    }
+    cache.n_misses ++;
+    Resolve_Absolute_Path_BindAbsolute_Inner(context, sp, mode, path);
+    if( BindAbsoluteCache::can_store(path) )
+    {
+        cache.entries.insert(::std::make_pair( mv$(key), BindAbsoluteCache::Entry { mode, ::AST::Path(path) } ));
+    }
+}
+void Resolve_Absolute_Path_BindAbsolute_Inner(Context& context, const Span& sp, Context::LookupMode& mode, ::AST::Path& path)
 {
     TRACE_FUNCTION_FR("path = " << path, path);
     auto& path_abs = path.m_class.as_Absolute();
@@ -2863,7 +2940,24 @@ void Resolve_Absolute_Mod( Context item_context, ::AST::Module& mod )
 
 void Resolve_Absolutise(AST::Crate& crate)
 {
-    Resolve_Absolute_Mod(crate, crate.root_module());
+    BindAbsoluteCache   cache;
+    s_bind_absolute_cache = &cache;
+    try
+    {
+        Resolve_Absolute_Mod(crate, crate.root_module());
+    }
+    catch(...)
+    {
+        s_bind_absolute_cache = nullptr;
+        throw;
+    }
+    s_bind_absolute_cache = nullptr;
+
+    if( getenv("MRUSTC_RESOLVE_CACHE_STATS") )
+    {
+        ::std::cout << "Resolve: " << cache.entries.size() << " cached absolute paths, "
+            << cache.n_hits << " hits, " << cache.n_misses << " misses" << ::std::endl;
+    }
 }
 
 
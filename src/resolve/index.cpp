@@ -10,6 +10,9 @@
 #include <main_bindings.hpp>
 #include <hir/hir.hpp>
 #include <macro_rules/macro_rules.hpp>
+#include <parallel.hpp>
+#include <map>
+#include <sstream>
 
 enum class IndexName
 {
@@ -306,36 +309,37 @@ void Resolve_Index_Module_Base(const AST::Crate& crate, AST::Module& mod)
     }
 
     mod.m_index_populated = (has_pub_wildcard ? 1 : 2);
+}
 
-    // Handle child modules
-    for( auto& i : mod.m_items )
-    {
-        if(auto* e = i->data.opt_Module())
-        {
-            Resolve_Index_Module_Base(crate, *e);
-        }
-    }
-    for(auto& mp : mod.anon_mods())
-    {
-        if( mp ) {
-            Resolve_Index_Module_Base(crate, *mp);
-        }
-    }
+namespace {
+    /// An item added to the index by a glob import of a HIR module
+    template<typename T>
+    struct HirGlobEnt {
+        RcString    name;
+        ::AST::PathBinding<T>   pb;
+        /// Item is defined in the globbed module (its path is the glob's path plus `name`, not `pb.path`)
+        bool    is_local;
+    };
+    /// Items added by a glob of a HIR module, in the order they're added to the index
+    struct HirGlobItems {
+        ::std::vector<HirGlobEnt<::AST::PathBinding_Type>>  types;
+        ::std::vector<HirGlobEnt<::AST::PathBinding_Value>> values;
+        ::std::vector<HirGlobEnt<::AST::PathBinding_Macro>> macros;
+    };
+    /// Pre-computed glob items for the HIR modules that are globbed by the crate (null if not pre-computed)
+    const ::std::map<const ::HIR::Module*, HirGlobItems>*   s_hir_glob_items = nullptr;
 }
 
-void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
-    const Span& sp, const AST::Crate& crate, AST::Module& dst_mod,
-    /*const AST::ExternCrate& hcrate,*/ const ::HIR::Module& hmod,
-    const ::AST::Path& path, bool is_pub,
-    AST::AbsolutePath mod_ap
-    )
+HirGlobItems Resolve_Index_Module_Wildcard__get_hir_items(const Span& sp, const AST::Crate& crate, const ::HIR::Module& hmod)
 {
+    HirGlobItems    rv;
     for(const auto& it : hmod.m_mod_items) {
         const auto& ve = *it.second;
         if( ve.publicity.is_global() ) {
             const auto* vep = &ve.ent;
 
             ::AST::PathBinding<::AST::PathBinding_Type> pb;
+            bool is_local = false;
             if( vep->is_Import() ) {
                 const auto& spath = vep->as_Import().path;
                 pb.path.crate = spath.m_crate_name;
@@ -348,7 +352,7 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
                     // Only support enums on the penultimate component
                     if( i == spath.m_components.size()-2 && hit->ent.is_Enum() ) {
                         pb.binding = ::AST::PathBinding_Type::make_EnumVar({nullptr, 0});
-                        _add_item_type( sp, dst_mod, it.first, is_pub, mv$(pb), false );
+                        rv.types.push_back(HirGlobEnt<::AST::PathBinding_Type> { it.first, mv$(pb), false });
                         hmod = nullptr;
                         break ;
                     }
@@ -360,7 +364,7 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
                 vep = &hmod->m_mod_items.at( spath.m_components.back() )->ent;
             }
             else {
-                pb.path = mod_ap + it.first;
+                is_local = true;
             }
             TU_MATCH_HDRA( (*vep), {)
             TU_ARMA(Import, e) {
@@ -392,7 +396,7 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
                 pb.binding = ::AST::PathBinding_Type::make_TypeAlias({nullptr});
                 }
             }
-            _add_item_type( sp, dst_mod, it.first, is_pub, mv$(pb), false );
+            rv.types.push_back(HirGlobEnt<::AST::PathBinding_Type> { it.first, mv$(pb), is_local });
         }
     }
     for(const auto& it : hmod.m_value_items) {
@@ -401,6 +405,7 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
             const auto* vep = &ve.ent;
 
             ::AST::PathBinding<::AST::PathBinding_Value> pb;
+            bool is_local = false;
             if( ve.ent.is_Import() ) {
                 const auto& spath = ve.ent.as_Import().path;
                 pb.path.crate = spath.m_crate_name;
@@ -413,7 +418,7 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
                     if(hit->ent.is_Enum()) {
                         ASSERT_BUG(sp, i + 1 == spath.m_components.size() - 1, "Found enum not at penultimate component of HIR import path");
                         pb.binding = ::AST::PathBinding_Value::make_EnumVar({nullptr, 0});  // TODO: What's the index?
-                        _add_item_value( sp, dst_mod, it.first, is_pub, mv$(pb), false );
+                        rv.values.push_back(HirGlobEnt<::AST::PathBinding_Value> { it.first, mv$(pb), false });
                         hmod = nullptr;
                         break ;
                     }
@@ -425,7 +430,7 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
                 vep = &hmod->m_value_items.at( spath.m_components.back() )->ent;
             }
             else {
-                pb.path = mod_ap + it.first;
+                is_local = true;
             }
             assert(vep);
             TU_MATCH_HDRA( (*vep), {)
@@ -449,20 +454,21 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
                 pb.binding = ::AST::PathBinding_Value::make_Function({nullptr});
                 }
             }
-            _add_item_value( sp, dst_mod, it.first, is_pub, mv$(pb), false );
+            rv.values.push_back(HirGlobEnt<::AST::PathBinding_Value> { it.first, mv$(pb), is_local });
         }
     }
     for(const auto& it : hmod.m_macro_items) {
         const auto& e = *it.second;
         if( e.publicity.is_global() ) {
             ::AST::PathBinding<::AST::PathBinding_Macro>    pb;
+            bool is_local = false;
             if(const auto* ep = e.ent.opt_Import()) {
                 pb.path.crate = ep->path.m_crate_name;
                 pb.path.nodes = ep->path.m_components;
                 // NOTE: This shouldn't ever be pointing at an import, and no other handling needed
             }
             else {
-                pb.path = mod_ap + it.first;
+                is_local = true;
             }
 
             TU_MATCH_HDRA( (e.ent), {)
@@ -476,9 +482,50 @@ void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
                 pb.binding = ::AST::PathBinding_Macro::make_MacroRules({ nullptr, &*me });
                 }
             }
-            _add_item(sp, dst_mod, IndexName::Macro, it.first, is_pub, mv$(pb), false );
+            rv.macros.push_back(HirGlobEnt<::AST::PathBinding_Macro> { it.first, mv$(pb), is_local });
         }
     }
+    return rv;
+}
+
+void Resolve_Index_Module_Wildcard__glob_in_hir_mod(
+    const Span& sp, const AST::Crate& crate, AST::Module& dst_mod,
+    /*const AST::ExternCrate& hcrate,*/ const ::HIR::Module& hmod,
+    const ::AST::Path& path, bool is_pub,
+    AST::AbsolutePath mod_ap
+    )
+{
+    // Every module has a glob of the prelude, so the lookups into the HIR are done once per globbed module
+    const HirGlobItems* items = nullptr;
+    if( s_hir_glob_items ) {
+        auto it = s_hir_glob_items->find(&hmod);
+        if( it != s_hir_glob_items->end() )
+            items = &it->second;
+    }
+    HirGlobItems    local_items;
+    if( !items ) {
+        local_items = Resolve_Index_Module_Wildcard__get_hir_items(sp, crate, hmod);
+        items = &local_items;
+    }
+
+    for(const auto& e : items->types) {
+        auto pb = e.pb.clone();
+        if( e.is_local )
+            pb.path = mod_ap + e.name;
+        _add_item_type( sp, dst_mod, e.name, is_pub, mv$(pb), false );
+    }
+    for(const auto& e : items->values) {
+        auto pb = e.pb.clone();
+        if( e.is_local )
+            pb.path = mod_ap + e.name;
+        _add_item_value( sp, dst_mod, e.name, is_pub, mv$(pb), false );
+    }
+    for(const auto& e : items->macros) {
+        auto pb = e.pb.clone();
+        if( e.is_local )
+            pb.path = mod_ap + e.name;
+        _add_item(sp, dst_mod, IndexName::Macro, e.name, is_pub, mv$(pb), false );
+    }
 }
 
 void Resolve_Index_Module_Wildcard__submod(AST::Crate& crate, AST::Module& dst_mod, const AST::Module& src_mod, bool import_as_pub)
@@ -928,12 +975,121 @@ void Resolve_Index_Module_ExportedMacros(::AST::Crate& crate, const Span& mod_sp
     }
 }
 
-void Resolve_Index(AST::Crate& crate)
+namespace {
+    /// All modules in the crate, in the order that a recursive walk visits them
+    void Resolve_Index_GetModules(AST::Module& mod, ::std::vector<AST::Module*>& out)
+    {
+        out.push_back(&mod);
+        for( auto& i : mod.m_items )
+        {
+            if( auto* e = i->data.opt_Module() )
+            {
+                Resolve_Index_GetModules(*e, out);
+            }
+        }
+        for(auto& mp : mod.anon_mods())
+        {
+            if( mp ) {
+                Resolve_Index_GetModules(*mp, out);
+            }
+        }
+    }
+
+    /// Text form of a module's index (sorted, for comparing two builds)
+    ::std::string Resolve_Index_DumpModule(AST::Module& mod)
+    {
+        ::std::stringstream ss;
+        for(auto loc : { IndexName::Namespace, IndexName::Type, IndexName::Value, IndexName::Macro })
+        {
+            ::std::map<::std::string, const ::AST::Module::IndexEnt*>   sorted;
+            for(const auto& ent : get_mod_index(mod, loc))
+                sorted.insert(::std::make_pair(ent.first.c_str(), &ent.second));
+            for(const auto& ent : sorted)
+            {
+                const auto& e = *ent.second;
+                ss << loc << " " << ent.first << (e.is_pub ? " pub" : "") << (e.is_import ? " import" : "") << " = " << e.path
+                    << " {" << e.path.m_bindings.type << ", " << e.path.m_bindings.value << ", " << e.path.m_bindings.macro << "}\n";
+            }
+        }
+        return ss.str();
+    }
+}
+
+/// Build the index for every module
+///
+/// `serial` selects the original version that handles one module (and one glob) at a time, otherwise the named items
+/// of each module are indexed on worker threads, and the items imported by globs of HIR modules are found (also on
+/// the worker threads) before the wildcard pass.
+void Resolve_Index_Build(AST::Crate& crate, bool serial)
 {
+    ::std::vector<AST::Module*> modules;
+    Resolve_Index_GetModules(crate.m_root_module, modules);
+
     // - Index all explicitly named items
-    Resolve_Index_Module_Base(crate, crate.m_root_module);
+    //  > This only writes to the module being indexed, and only reads `use` bindings (which are already resolved)
+    if( serial ) {
+        for(auto* mod : modules)
+            Resolve_Index_Module_Base(crate, *mod);
+    }
+    else {
+        parallel::for_each(modules.size(), [&](size_t i) {
+            Resolve_Index_Module_Base(crate, *modules[i]);
+            });
+    }
+
+    // - Get the contents of globbed HIR modules
+    ::std::map<const ::HIR::Module*, HirGlobItems>  hir_glob_items;
+    if( !serial )
+    {
+        ::std::vector<::std::pair<const Span*, const ::HIR::Module*>>  hir_globs;
+        for(const auto* mod : modules)
+        {
+            for( const auto& i : mod->m_items )
+            {
+                if( ! i->data.is_Use() )
+                    continue ;
+                for(const auto& e : i->data.as_Use().entries )
+                {
+                    if( e.name != "" )
+                        continue ;
+                    const ::HIR::Module* hmod = nullptr;
+                    const auto& b = e.path.m_bindings.type.binding;
+                    if( const auto* be = b.opt_Crate() ) {
+                        hmod = &be->crate_->m_hir->m_root_module;
+                    }
+                    else if( const auto* be = b.opt_Module() ) {
+                        if( !be->module_ )
+                            hmod = be->hir.mod;
+                    }
+                    if( hmod && hir_glob_items.insert(::std::make_pair(hmod, HirGlobItems())).second ) {
+                        hir_globs.push_back(::std::make_pair(&e.sp, hmod));
+                    }
+                }
+            }
+        }
+        ::std::vector<HirGlobItems> items(hir_globs.size());
+        parallel::for_each(hir_globs.size(), [&](size_t i) {
+            items[i] = Resolve_Index_Module_Wildcard__get_hir_items(*hir_globs[i].first, crate, *hir_globs[i].second);
+            });
+        for(size_t i = 0; i < hir_globs.size(); i ++)
+            hir_glob_items.at(hir_globs[i].second) = mv$(items[i]);
+        DEBUG(hir_globs.size() << " globbed HIR modules");
+    }
+
     // - Index wildcard imports
-    Resolve_Index_Module_Wildcard(crate, crate.m_root_module);
+    //  > Globs of AST modules read the index of the source module (which could be being written by a different glob),
+    //    so this stays serial.
+    s_hir_glob_items = serial ? nullptr : &hir_glob_items;
+    try
+    {
+        Resolve_Index_Module_Wildcard(crate, crate.m_root_module);
+    }
+    catch(...)
+    {
+        s_hir_glob_items = nullptr;
+        throw;
+    }
+    s_hir_glob_items = nullptr;
 
     // Macros marked with `#[macro_export]` actually live in the root
     Resolve_Index_Module_ExportedMacros(crate, Span(), crate.m_root_module);
@@ -941,3 +1097,41 @@ void Resolve_Index(AST::Crate& crate)
     // - Normalise the index (ensuring all paths point directly to the item)
     Resolve_Index_Module_Normalise(crate, Span(), crate.m_root_module);
 }
+
+void Resolve_Index(AST::Crate& crate)
+{
+    if( getenv("MRUSTC_RESOLVE_INDEX_CHECK") )
+    {
+        // Build with the serial version first, then check that the threaded version gives the same index
+        Resolve_Index_Build(crate, /*serial=*/true);
+
+        ::std::vector<AST::Module*> modules;
+        Resolve_Index_GetModules(crate.m_root_module, modules);
+        ::std::vector<::std::string>    expected;
+        for(auto* mod : modules)
+        {
+            expected.push_back(Resolve_Index_DumpModule(*mod));
+            // Replaced (instead of cleared) so the maps' iteration order is the same as a fresh build
+            mod->m_namespace_items = decltype(mod->m_namespace_items)();
+            mod->m_type_items = decltype(mod->m_type_items)();
+            mod->m_value_items = decltype(mod->m_value_items)();
+            mod->m_macro_items = decltype(mod->m_macro_items)();
+            mod->m_index_populated = 0;
+        }
+
+        Resolve_Index_Build(crate, /*serial=*/false);
+        for(size_t i = 0; i < modules.size(); i ++)
+        {
+            auto found = Resolve_Index_DumpModule(*modules[i]);
+            if( found != expected[i] )
+            {
+                BUG(Span(), "Index of " << modules[i]->path() << " differs between serial and threaded builds\n"
+                    << "Serial:\n" << expected[i] << "Threaded:\n" << found);
+            }
+        }
+        ::std::cout << "Resolve Index: " << modules.size() << " modules checked" << ::std::endl;
+        return ;
+    }
+
+    Resolve_Index_Build(crate, /*serial=*/false);
+}
@@ -10,6 +10,7 @@
 #include <span.hpp>
 #include <parse/lex.hpp>
 #include <common.hpp>
+#include <parallel.hpp>
 
 SpanInner Span::s_empty_span;
 
@@ -23,14 +24,13 @@ Span::Span(Span parent, const Position& pos):
 Span::Span(const Span& x):
     m_ptr(x.m_ptr)
 {
-    m_ptr->reference_count += 1;
+    m_ptr->reference_count.fetch_add(1, ::std::memory_order_relaxed);
 }
 Span::~Span()
 {
     if(m_ptr && m_ptr != &s_empty_span)
     {
-        m_ptr->reference_count --;
-        if( m_ptr->reference_count == 0 )
+        if( m_ptr->reference_count.fetch_sub(1, ::std::memory_order_acq_rel) == 1 )
         {
             delete m_ptr;
         }
@@ -41,7 +41,7 @@ Span::~Span()
 namespace {
     void print_span_message(const Span& sp, ::std::function<void(::std::ostream&)> tag, ::std::function<void(::std::ostream&)> msg)
     {
-        auto& sink = ::std::cerr;
+        auto& sink = parallel::diag_stream();
         sink << sp->filename << ":" << sp->start_line << ": ";
         tag(sink);
         sink << ":";
@@ -57,20 +57,12 @@ namespace {
 void Span::bug(::std::function<void(::std::ostream&)> msg) const
 {
     print_span_message(*this, [](auto& os){os << "BUG";}, msg);
-#ifndef _WIN32
-    abort();
-#else
-    exit(1);
-#endif
+    parallel::fatal_error();
 }
 
 void Span::error(ErrorType tag, ::std::function<void(::std::ostream&)> msg) const {
     print_span_message(*this, [&](auto& os){os << "error:" << tag;}, msg);
-#ifndef _WIN32
-    abort();
-#else
-    exit(1);
-#endif
+    parallel::fatal_error();
 }
 void Span::warning(WarningType tag, ::std::function<void(::std::ostream&)> msg) const {
     print_span_message(*this, [&](auto& os){os << "warn:" << tag;}, msg);
@@ -15,6 +15,7 @@
 
 #include "codegen.hpp"
 #include "monomorphise.hpp"
+#include "mangling.hpp"
 
 void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, const ::HIR::Crate& crate, const TransList& list, const ::std::string& hir_file)
 {
@@ -27,7 +28,7 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
     }
     else if( opt.mode == "c" )
     {
-        codegen = Trans_Codegen_GetGeneratorC(crate, outfile);
+        codegen = Trans_Codegen_GetGeneratorC(crate, outfile, opt);
     }
     else
     {
@@ -189,5 +190,6 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
     }
 
     codegen->finalise(opt, out_ty, hir_file);
+    Trans_Mangle_ClearCache();
 }
 
@@ -19,6 +19,7 @@
 #include "target.hpp"
 #include "allocator.hpp"
 #include <iomanip>
+#include <unordered_map>
 
 namespace {
     struct FmtShell
@@ -193,13 +194,17 @@ namespace {
         struct {
             bool emulated_i128 = false;
             bool disallow_empty_structs = false;
+            bool structured = false;
         } m_options;
 
 
         ::std::set< ::HIR::TypeRef> m_emitted_fn_types;
         ::std::set< const TypeRepr*>    m_embedded_tags;
+
+        /// Cached C spellings of types (the declarator before the name), see `get_ctype_prefix`
+        ::std::unordered_map< ::HIR::TypeRef, ::std::string, Trans_MangleHash>  m_ctype_prefixes;
     public:
-        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile):
+        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt):
             m_crate(crate),
             m_resolve(crate),
             m_outfile_path(outfile),
@@ -208,6 +213,7 @@ namespace {
         {
             ASSERT_BUG(Span(), m_of.is_open(), "Failed to open `" << m_outfile_path_c << "` for writing");
             m_options.emulated_i128 = Target_GetCurSpec().m_backend_c.m_emulated_i128;
+            m_options.structured = opt.structured_c;
             switch(Target_GetCurSpec().m_backend_c.m_codegen_mode)
             {
             case CodegenMode::Gnu11:
@@ -2628,273 +2634,269 @@ namespace {
                 m_of << "\tbool df" << i << " = " << code->drop_flags[i] << ";\n";
             }
 
-            ::std::vector<unsigned> bb_use_counts( code->blocks.size() );
-            for(const auto& blk : code->blocks)
+            if( m_options.structured )
             {
-                MIR::visit::visit_terminator_target(blk.terminator, [&](const auto& tgt){ bb_use_counts[tgt] ++; });
-                // Ignore the panic arm. (TODO: is this correct?)
-                if( const auto* te = blk.terminator.opt_Call() )
-                {
-                    bb_use_counts[te->panic_block] --;
-                }
+                emit_fcn_structured(mir_res, *code);
             }
-
-            const bool EMIT_STRUCTURED = (nullptr != getenv("MRUSTC_STRUCTURED_C")); // Saves time.
-            const bool USE_STRUCTURED = EMIT_STRUCTURED && (0 == strcmp("1", getenv("MRUSTC_STRUCTURED_C")));  // Still not correct.
-            if( EMIT_STRUCTURED )
+            else
             {
-                m_of << "#if " << USE_STRUCTURED << "\n";
-                auto nodes = MIR_To_Structured(*code);
-
-                ::std::set<unsigned> goto_targets;
-                struct H {
-                    static void find_goto_targets(const Node& n, ::std::set<unsigned>& goto_targets) {
-                        switch(n.tag())
-                        {
-                        case Node::TAGDEAD: throw "";
-                        TU_ARM(n, Block, ne) {
-                            for(const auto& sn : ne.nodes)
-                            {
-                                if(sn.node)
-                                    find_goto_targets(*sn.node, goto_targets);
-                            }
-                            if(ne.next_bb != SIZE_MAX)
-                                goto_targets.insert(ne.next_bb);
-                            } break;
-                        TU_ARM(n, If, ne) {
-                            find_goto_targets_ref(ne.arm_true, goto_targets);
-                            find_goto_targets_ref(ne.arm_false, goto_targets);
-                            if(ne.next_bb != SIZE_MAX)
-                                goto_targets.insert(ne.next_bb);
-                            } break;
-                        TU_ARM(n, Switch, ne) {
-                            for(const auto& sn : ne.arms) {
-                                find_goto_targets_ref(sn, goto_targets);
-                                if( sn.has_target() && sn.target() != ne.next_bb )
-                                {
-                                    goto_targets.insert(sn.target());
-                                }
-                            }
-                            if(ne.next_bb != SIZE_MAX)
-                                goto_targets.insert(ne.next_bb);
-                            } break;
-                        TU_ARM(n, SwitchValue, ne) {
-                            for(const auto& sn : ne.arms)
-                            {
-                                find_goto_targets_ref(sn, goto_targets);
-                                if( sn.has_target() && sn.target() != ne.next_bb )
-                                {
-                                    goto_targets.insert(sn.target());
-                                }
-                            }
-                            find_goto_targets_ref(ne.def_arm, goto_targets);
-                            if( ne.def_arm.has_target() && ne.def_arm.target() != ne.next_bb )
-                            {
-                                goto_targets.insert(ne.def_arm.target());
-                            }
-                            if(ne.next_bb != SIZE_MAX)
-                                goto_targets.insert(ne.next_bb);
-                            } break;
-                        TU_ARM(n, Loop, ne) {
-                            assert(ne.code.node);
-                            find_goto_targets(*ne.code.node, goto_targets);
-                            if(ne.next_bb != SIZE_MAX)
-                                goto_targets.insert(ne.next_bb);
-                            } break;
-                        }
-                    }
-                    static void find_goto_targets_ref(const NodeRef& r, ::std::set<unsigned>& goto_targets) {
-                        if(r.node)
-                            find_goto_targets(*r.node, goto_targets);
-                        else
-                            goto_targets.insert(r.bb_idx);
-                    }
-                };
-                for(const auto& node : nodes)
+                ::std::vector<unsigned> bb_use_counts( code->blocks.size() );
+                for(const auto& blk : code->blocks)
                 {
-                    H::find_goto_targets(node, goto_targets);
-                }
-
-                for(const auto& node : nodes)
-                {
-                    m_of << "\t" << "// Node\n";
-                    emit_fcn_node(mir_res, node, 1,  goto_targets);
-
-                    switch(node.tag())
+                    MIR::visit::visit_terminator_target(blk.terminator, [&](const auto& tgt){ bb_use_counts[tgt] ++; });
+                    // Ignore the panic arm. (TODO: is this correct?)
+                    if( const auto* te = blk.terminator.opt_Call() )
                     {
-                    case Node::TAGDEAD: throw "";
-                    TU_ARM(node, Block, e)
-                        if( e.next_bb != SIZE_MAX )
-                            m_of << "\t""goto bb" << e.next_bb << ";\n";
-                        break;
-                    TU_ARM(node, If, e)
-                        if( e.next_bb != SIZE_MAX )
-                            m_of << "\t""goto bb" << e.next_bb << ";\n";
-                        break;
-                    TU_ARM(node, Switch, e)
-                        if( e.next_bb != SIZE_MAX )
-                            m_of << "\t""goto bb" << e.next_bb << ";\n";
-                        break;
-                    TU_ARM(node, SwitchValue, e)
-                        if( e.next_bb != SIZE_MAX )
-                            m_of << "\t""goto bb" << e.next_bb << ";\n";
-                        break;
-                    TU_ARM(node, Loop, e)
-                        if( e.next_bb != SIZE_MAX )
-                            m_of << "\t""goto bb" << e.next_bb << ";\n";
-                        break;
+                        bb_use_counts[te->panic_block] --;
                     }
                 }
 
-                m_of << "#else\n";
-            }
-
-            for(unsigned int i = 0; i < code->blocks.size(); i ++)
-            {
-                TRACE_FUNCTION_F(p << " bb" << i);
-
-                // HACK: Ignore any blocks that only contain `diverge;`
-                if( code->blocks[i].statements.size() == 0 && code->blocks[i].terminator.is_Diverge() ) {
-                    DEBUG("- Diverge only, omitting");
-                    m_of << "bb" << i << ": _Unwind_Resume(); // Diverge\n";
-                    continue ;
-                }
-
-                // If the previous block is a goto/function call to this
-                // block, AND this block only has a single reference, omit the
-                // label.
-                if( bb_use_counts.at(i) == 0 )
+                for(unsigned int i = 0; i < code->blocks.size(); i ++)
                 {
-                    if( i == 0 )
-                    {
-                        // First BB, don't print label
+                    TRACE_FUNCTION_F(p << " bb" << i);
+
+                    // HACK: Ignore any blocks that only contain `diverge;`
+                    if( code->blocks[i].statements.size() == 0 && code->blocks[i].terminator.is_Diverge() ) {
+                        DEBUG("- Diverge only, omitting");
+                        m_of << "bb" << i << ": _Unwind_Resume(); // Diverge\n";
+                        continue ;
                     }
-                    else
+
+                    // If the previous block is a goto/function call to this
+                    // block, AND this block only has a single reference, omit the
+                    // label.
+                    if( bb_use_counts.at(i) == 0 )
                     {
-                        // Unused BB (likely part of unsupported panic path)
-                        continue ;
+                        if( i == 0 )
+                        {
+                            // First BB, don't print label
+                        }
+                        else
+                        {
+                            // Unused BB (likely part of unsupported panic path)
+                            continue ;
+                        }
                     }
-                }
-                else if( bb_use_counts.at(i) == 1 )
-                {
-                    if( i > 0 && (TU_TEST1(code->blocks[i-1].terminator, Goto, == i) || TU_TEST1(code->blocks[i-1].terminator, Call, .ret_block == i)) )
+                    else if( bb_use_counts.at(i) == 1 )
                     {
-                        // Don't print the label, only use is previous block
+                        if( i > 0 && (TU_TEST1(code->blocks[i-1].terminator, Goto, == i) || TU_TEST1(code->blocks[i-1].terminator, Call, .ret_block == i)) )
+                        {
+                            // Don't print the label, only use is previous block
+                        }
+                        else
+                        {
+                            m_of << "bb" << i << ":\n";
+                        }
                     }
                     else
                     {
                         m_of << "bb" << i << ":\n";
                     }
-                }
-                else
-                {
-                    m_of << "bb" << i << ":\n";
-                }
-
-                for(const auto& stmt : code->blocks[i].statements)
-                {
-                    mir_res.set_cur_stmt(i, (&stmt - &code->blocks[i].statements.front()));
-                    emit_statement(mir_res, stmt);
-                }
 
-                mir_res.set_cur_stmt_term(i);
-                DEBUG("- " << code->blocks[i].terminator);
-                TU_MATCH_HDRA( (code->blocks[i].terminator), {)
-                TU_ARMA(Incomplete, e) {
-                    m_of << "\tfor(;;);\n";
-                    }
-                TU_ARMA(Return, e) {
-                    // If the return type is (), don't return a value.
-                    if( ret_type == ::HIR::TypeRef::new_unit() )
-                        m_of << "\treturn ;\n";
-                    else
-                        m_of << "\treturn rv;\n";
-                    }
-                TU_ARMA(Diverge, e) {
-                    m_of << "\t_Unwind_Resume();\n";
-                    }
-                TU_ARMA(Goto, e) {
-                    if( e == i+1 )
+                    for(const auto& stmt : code->blocks[i].statements)
                     {
-                        // Let it flow on to the next block
+                        mir_res.set_cur_stmt(i, (&stmt - &code->blocks[i].statements.front()));
+                        emit_statement(mir_res, stmt);
                     }
-                    else
-                    {
-                        m_of << "\tgoto bb" << e << ";\n";
-                    }
-                    }
-                TU_ARMA(Panic, e) {
-                    m_of << "\tgoto bb" << e << "; /* panic */\n";
-                    }
-                TU_ARMA(If, e) {
-                    m_of << "\tif("; emit_lvalue(e.cond); m_of << ") goto bb" << e.bb0 << "; else goto bb" << e.bb1 << ";\n";
-                    }
-                TU_ARMA(Switch, e) {
 
-                    // If all arms except one are the same, then emit an `if` instead
-                    size_t odd_arm = -1;
-                    if( e.targets.size() >= 2 )
-                    {
-                        int n_unique = 0;
-                        struct {
-                            size_t  first_idx;
-                            MIR::BasicBlockId   id;
-                            unsigned    count;
-                            bool operator==(MIR::BasicBlockId x) const { return id == x; }
-                        } uniques[2];
-                        for(size_t i = 0; i < e.targets.size(); i ++)
+                    mir_res.set_cur_stmt_term(i);
+                    DEBUG("- " << code->blocks[i].terminator);
+                    TU_MATCH_HDRA( (code->blocks[i].terminator), {)
+                    TU_ARMA(Incomplete, e) {
+                        m_of << "\tfor(;;);\n";
+                        }
+                    TU_ARMA(Return, e) {
+                        emit_term_return(mir_res, 1);
+                        }
+                    TU_ARMA(Diverge, e) {
+                        m_of << "\t_Unwind_Resume();\n";
+                        }
+                    TU_ARMA(Goto, e) {
+                        if( e == i+1 )
                         {
-                            auto t = e.targets[i];
-                            auto it = std::find(uniques, uniques+n_unique, t);
-                            if( it != uniques+n_unique ) {
-                                it->count += 1;
-                                continue ;
+                            // Let it flow on to the next block
+                        }
+                        else
+                        {
+                            m_of << "\tgoto bb" << e << ";\n";
+                        }
+                        }
+                    TU_ARMA(Panic, e) {
+                        m_of << "\tgoto bb" << e << "; /* panic */\n";
+                        }
+                    TU_ARMA(If, e) {
+                        m_of << "\tif("; emit_lvalue(e.cond); m_of << ") goto bb" << e.bb0 << "; else goto bb" << e.bb1 << ";\n";
+                        }
+                    TU_ARMA(Switch, e) {
+
+                        // If all arms except one are the same, then emit an `if` instead
+                        size_t odd_arm = -1;
+                        if( e.targets.size() >= 2 )
+                        {
+                            int n_unique = 0;
+                            struct {
+                                size_t  first_idx;
+                                MIR::BasicBlockId   id;
+                                unsigned    count;
+                                bool operator==(MIR::BasicBlockId x) const { return id == x; }
+                            } uniques[2];
+                            for(size_t i = 0; i < e.targets.size(); i ++)
+                            {
+                                auto t = e.targets[i];
+                                auto it = std::find(uniques, uniques+n_unique, t);
+                                if( it != uniques+n_unique ) {
+                                    it->count += 1;
+                                    continue ;
+                                }
+                                n_unique += 1;
+                                if( n_unique > 2 ) {
+                                    break;
+                                }
+                                uniques[n_unique-1].first_idx = i;
+                                uniques[n_unique-1].id = t;
+                                uniques[n_unique-1].count = 1;
                             }
-                            n_unique += 1;
-                            if( n_unique > 2 ) {
-                                break;
+                            if( n_unique == 2 && (uniques[0].count == 1 || uniques[1].count == 1) )
+                            {
+                                odd_arm = uniques[(uniques[0].count == 1 ? 0 : 1)].first_idx;
+                                DEBUG("Odd arm " << odd_arm);
                             }
-                            uniques[n_unique-1].first_idx = i;
-                            uniques[n_unique-1].id = t;
-                            uniques[n_unique-1].count = 1;
                         }
-                        if( n_unique == 2 && (uniques[0].count == 1 || uniques[1].count == 1) )
+                        emit_term_switch(mir_res, e.val, e.targets.size(), 1, [&](size_t idx) {
+                            m_of << "goto bb" << e.targets[idx] << ";";
+                            }, odd_arm);
+                        }
+                    TU_ARMA(SwitchValue, e) {
+                        emit_term_switchvalue(mir_res, e.val, e.values, 1, [&](size_t idx) {
+                            m_of << "goto bb" << (idx == SIZE_MAX ? e.def_target : e.targets[idx]) << ";";
+                            });
+                        }
+                    TU_ARMA(Call, e) {
+                        emit_term_call(mir_res, e, 1);
+                        if( e.ret_block == i+1 )
                         {
-                            odd_arm = uniques[(uniques[0].count == 1 ? 0 : 1)].first_idx;
-                            DEBUG("Odd arm " << odd_arm);
+                            // Let it flow on to the next block
+                        }
+                        else
+                        {
+                            m_of << "\tgoto bb" << e.ret_block << ";\n";
+                        }
                         }
                     }
-                    emit_term_switch(mir_res, e.val, e.targets.size(), 1, [&](size_t idx) {
-                        m_of << "goto bb" << e.targets[idx] << ";";
-                        }, odd_arm);
-                    }
-                TU_ARMA(SwitchValue, e) {
-                    emit_term_switchvalue(mir_res, e.val, e.values, 1, [&](size_t idx) {
-                        m_of << "goto bb" << (idx == SIZE_MAX ? e.def_target : e.targets[idx]) << ";";
-                        });
-                    }
-                TU_ARMA(Call, e) {
-                    emit_term_call(mir_res, e, 1);
-                    if( e.ret_block == i+1 )
+                    m_of << "\t// ^ " << code->blocks[i].terminator << "\n";
+                }
+            }
+
+            m_of << "}\n";
+            m_of.flush();
+            m_mir_res = nullptr;
+        }
+
+        void emit_term_return(const ::MIR::TypeResolve& mir_res, unsigned indent_level)
+        {
+            auto indent = RepeatLitStr { "\t", static_cast<int>(indent_level) };
+            // If the return type is (), don't return a value.
+            if( mir_res.m_ret_type == ::HIR::TypeRef::new_unit() )
+                m_of << indent << "return ;\n";
+            else
+                m_of << indent << "return rv;\n";
+        }
+
+        /// Emit the function body as nested C statements (see `MIR_To_Structured`), using `goto` only for edges that
+        /// don't fit the nesting
+        void emit_fcn_structured(::MIR::TypeResolve& mir_res, const ::MIR::Function& code)
+        {
+            auto nodes = MIR_To_Structured(code);
+
+            ::std::set<unsigned> goto_targets;
+            struct H {
+                static void find_goto_targets(const Node& n, ::std::set<unsigned>& goto_targets) {
+                    switch(n.tag())
                     {
-                        // Let it flow on to the next block
+                    case Node::TAGDEAD: throw "";
+                    TU_ARM(n, Block, ne) {
+                        for(const auto& sn : ne.nodes)
+                        {
+                            if(sn.node)
+                                find_goto_targets(*sn.node, goto_targets);
+                        }
+                        if(ne.next_bb != SIZE_MAX)
+                            goto_targets.insert(ne.next_bb);
+                        } break;
+                    TU_ARM(n, If, ne) {
+                        find_goto_targets_ref(ne.arm_true, goto_targets);
+                        find_goto_targets_ref(ne.arm_false, goto_targets);
+                        if(ne.next_bb != SIZE_MAX)
+                            goto_targets.insert(ne.next_bb);
+                        } break;
+                    TU_ARM(n, Switch, ne) {
+                        for(const auto& sn : ne.arms) {
+                            find_goto_targets_ref(sn, goto_targets);
+                            if( sn.has_target() && sn.target() != ne.next_bb )
+                            {
+                                goto_targets.insert(sn.target());
+                            }
+                        }
+                        if(ne.next_bb != SIZE_MAX)
+                            goto_targets.insert(ne.next_bb);
+                        } break;
+                    TU_ARM(n, SwitchValue, ne) {
+                        for(const auto& sn : ne.arms)
+                        {
+                            find_goto_targets_ref(sn, goto_targets);
+                            if( sn.has_target() && sn.target() != ne.next_bb )
+                            {
+                                goto_targets.insert(sn.target());
+                            }
+                        }
+                        find_goto_targets_ref(ne.def_arm, goto_targets);
+                        if( ne.def_arm.has_target() && ne.def_arm.target() != ne.next_bb )
+                        {
+                            goto_targets.insert(ne.def_arm.target());
+                        }
+                        if(ne.next_bb != SIZE_MAX)
+                            goto_targets.insert(ne.next_bb);
+                        } break;
+                    TU_ARM(n, Loop, ne) {
+                        assert(ne.code.node);
+                        find_goto_targets(*ne.code.node, goto_targets);
+                        if(ne.next_bb != SIZE_MAX)
+                            goto_targets.insert(ne.next_bb);
+                        } break;
                     }
+                }
+                static void find_goto_targets_ref(const NodeRef& r, ::std::set<unsigned>& goto_targets) {
+                    if(r.node)
+                        find_goto_targets(*r.node, goto_targets);
                     else
-                    {
-                        m_of << "\tgoto bb" << e.ret_block << ";\n";
-                    }
-                    }
+                        goto_targets.insert(r.bb_idx);
                 }
-                m_of << "\t// ^ " << code->blocks[i].terminator << "\n";
+            };
+            for(const auto& node : nodes)
+            {
+                H::find_goto_targets(node, goto_targets);
             }
 
-            if( EMIT_STRUCTURED )
+            for(size_t i = 0; i < nodes.size(); i ++)
             {
-                m_of << "#endif\n";
+                const auto& node = nodes[i];
+                emit_fcn_node(mir_res, node, 1,  goto_targets);
+
+                size_t next_bb = SIZE_MAX;
+                switch(node.tag())
+                {
+                case Node::TAGDEAD: throw "";
+                TU_ARM(node, Block, e)  next_bb = e.next_bb;    break;
+                TU_ARM(node, If, e)     next_bb = e.next_bb;    break;
+                TU_ARM(node, Switch, e) next_bb = e.next_bb;    break;
+                TU_ARM(node, SwitchValue, e)    next_bb = e.next_bb;    break;
+                TU_ARM(node, Loop, e)   next_bb = e.next_bb;    break;
+                }
+                if( next_bb != SIZE_MAX )
+                {
+                    m_of << "\t""goto bb" << next_bb << ";\n";
+                }
             }
-            m_of << "}\n";
-            m_of.flush();
-            m_mir_res = nullptr;
         }
 
         void emit_fcn_node(::MIR::TypeResolve& mir_res, const Node& node, unsigned indent_level,  const ::std::set<unsigned>& goto_targets)
@@ -2923,12 +2925,14 @@ namespace {
                             this->emit_statement(mir_res, stmt, indent_level);
                         }
 
+                        mir_res.set_cur_stmt_term(snr.bb_idx);
                         TU_MATCH_HDRA( (bb.terminator), {)
-                        TU_ARMA(Incomplete, te) {}
+                        TU_ARMA(Incomplete, te) {
+                            m_of << indent << "for(;;);\n";
+                            }
                         TU_ARMA(Return, te) {
-                            // TODO: If the return type is (), just emit "return"
                             assert(i == e.nodes.size()-1 && "Return");
-                            m_of << indent << "return rv;\n";
+                            emit_term_return(mir_res, indent_level);
                             }
                         TU_ARMA(Goto, te) {
                             // Ignore (handled by caller)
@@ -2937,6 +2941,7 @@ namespace {
                             m_of << indent << "_Unwind_Resume();\n";
                             }
                         TU_ARMA(Panic, te) {
+                            // Ignore (handled by caller, as a goto)
                             }
                         TU_ARMA(If, te) {
                             //assert(i == e.nodes.size()-1 && "If");
@@ -7139,38 +7144,62 @@ namespace {
             emit_ctype(ty, FMT_CB(_,));
         }
         void emit_ctype(const ::HIR::TypeRef& ty, ::FmtLambda inner, bool is_extern_c=false) {
+            if( ty.data().is_Infer() ) {
+                m_of << "@" << ty << "@" << inner;
+                return ;
+            }
+            // Primitives are cheaper to format than to look up
+            if( ty.data().is_Primitive() || ty.data().is_Diverge() ) {
+                fmt_ctype_prefix(m_of, ty);
+            }
+            else {
+                m_of << get_ctype_prefix(ty);
+            }
+            m_of << inner;
+        }
+        /// Get the C spelling of a type up to the declared name (e.g. `struct s_Foo *` for `&Foo`)
+        const ::std::string& get_ctype_prefix(const ::HIR::TypeRef& ty) {
+            auto it = m_ctype_prefixes.find(ty);
+            if( it == m_ctype_prefixes.end() ) {
+                ::std::stringstream ss;
+                fmt_ctype_prefix(ss, ty);
+                it = m_ctype_prefixes.insert(::std::make_pair( ty.clone(), ss.str() )).first;
+            }
+            return it->second;
+        }
+        void fmt_ctype_prefix(::std::ostream& os, const ::HIR::TypeRef& ty) {
             TU_MATCH_HDRA( (ty.data()), {)
             TU_ARMA(Infer, te) {
-                m_of << "@" << ty << "@" << inner;
+                MIR_BUG(*m_mir_res, "Infer in trans - " << ty);
                 }
             TU_ARMA(Diverge, te) {
-                m_of << "tBANG " << inner;
+                os << "tBANG ";
                 }
             TU_ARMA(Primitive, te) {
                 switch(te)
                 {
-                case ::HIR::CoreType::Usize:    m_of << "uintptr_t";   break;
-                case ::HIR::CoreType::Isize:    m_of << "intptr_t";  break;
-                case ::HIR::CoreType::U8:  m_of << "uint8_t"; break;
-                case ::HIR::CoreType::I8:  m_of << "int8_t"; break;
-                case ::HIR::CoreType::U16: m_of << "uint16_t"; break;
-                case ::HIR::CoreType::I16: m_of << "int16_t"; break;
-                case ::HIR::CoreType::U32: m_of << "uint32_t"; break;
-                case ::HIR::CoreType::I32: m_of << "int32_t"; break;
-                case ::HIR::CoreType::U64: m_of << "uint64_t"; break;
-                case ::HIR::CoreType::I64: m_of << "int64_t"; break;
-                case ::HIR::CoreType::U128: m_of << "uint128_t"; break;
-                case ::HIR::CoreType::I128: m_of << "int128_t"; break;
-
-                case ::HIR::CoreType::F32: m_of << "float"; break;
-                case ::HIR::CoreType::F64: m_of << "double"; break;
-
-                case ::HIR::CoreType::Bool: m_of << "RUST_BOOL"; break;
-                case ::HIR::CoreType::Char: m_of << "RUST_CHAR";  break;
+                case ::HIR::CoreType::Usize:    os << "uintptr_t";   break;
+                case ::HIR::CoreType::Isize:    os << "intptr_t";  break;
+                case ::HIR::CoreType::U8:  os << "uint8_t"; break;
+                case ::HIR::CoreType::I8:  os << "int8_t"; break;
+                case ::HIR::CoreType::U16: os << "uint16_t"; break;
+                case ::HIR::CoreType::I16: os << "int16_t"; break;
+                case ::HIR::CoreType::U32: os << "uint32_t"; break;
+                case ::HIR::CoreType::I32: os << "int32_t"; break;
+                case ::HIR::CoreType::U64: os << "uint64_t"; break;
+                case ::HIR::CoreType::I64: os << "int64_t"; break;
+                case ::HIR::CoreType::U128: os << "uint128_t"; break;
+                case ::HIR::CoreType::I128: os << "int128_t"; break;
+
+                case ::HIR::CoreType::F32: os << "float"; break;
+                case ::HIR::CoreType::F64: os << "double"; break;
+
+                case ::HIR::CoreType::Bool: os << "RUST_BOOL"; break;
+                case ::HIR::CoreType::Char: os << "RUST_CHAR";  break;
                 case ::HIR::CoreType::Str:
                     MIR_BUG(*m_mir_res, "Raw str");
                 }
-                m_of << " " << inner;
+                os << " ";
                 }
             TU_ARMA(Path, te) {
                 //if( const auto* ity = m_resolve.is_type_owned_box(ty) ) {
@@ -7179,16 +7208,16 @@ namespace {
                 //}
                 TU_MATCH_HDRA( (te.binding), { )
                 TU_ARMA(Struct, tpb) {
-                    m_of << "struct s_" << Trans_Mangle(te.path);
+                    os << "struct s_" << Trans_Mangle(te.path);
                     }
                 TU_ARMA(Union, tpb) {
-                    m_of << "union u_" << Trans_Mangle(te.path);
+                    os << "union u_" << Trans_Mangle(te.path);
                     }
                 TU_ARMA(Enum, tpb) {
-                    m_of << "struct e_" << Trans_Mangle(te.path);
+                    os << "struct e_" << Trans_Mangle(te.path);
                     }
                 TU_ARMA(ExternType, tpb) {
-                    m_of << "struct x_" << Trans_Mangle(te.path);
+                    os << "struct x_" << Trans_Mangle(te.path);
                     }
                 TU_ARMA(Unbound, tpb) {
                     MIR_BUG(*m_mir_res, "Unbound type path in trans - " << ty);
@@ -7197,7 +7226,7 @@ namespace {
                     MIR_BUG(*m_mir_res, "Opaque path in trans - " << ty);
                     }
                 }
-                m_of << " " << inner;
+                os << " ";
                 }
             TU_ARMA(Generic, te) {
                 MIR_BUG(*m_mir_res, "Generic in trans - " << ty);
@@ -7209,33 +7238,31 @@ namespace {
                 MIR_BUG(*m_mir_res, "ErasedType in trans - " << ty);
                 }
             TU_ARMA(Array, te) {
-                m_of << "t_" << Trans_Mangle(ty) << " " << inner;
-                //emit_ctype(te.inner, inner);
-                //m_of << "[" << te.size.as_Known() << "]";
+                os << "t_" << Trans_Mangle(ty) << " ";
                 }
             TU_ARMA(Slice, te) {
                 MIR_BUG(*m_mir_res, "Raw slice object - " << ty);
                 }
             TU_ARMA(Tuple, te) {
                 if( te.size() == 0 )
-                    m_of << "tUNIT";
+                    os << "tUNIT";
                 else {
-                    m_of << "TUP_" << te.size();
+                    os << "TUP_" << te.size();
                     for(const auto& t : te)
                     {
-                        m_of << "_" << Trans_Mangle(t);
+                        os << "_" << Trans_Mangle(t);
                     }
                 }
-                m_of << " " << inner;
+                os << " ";
                 }
             TU_ARMA(Borrow, te) {
-                emit_ctype_ptr(te.inner, inner);
+                fmt_ctype_ptr_prefix(os, te.inner);
                 }
             TU_ARMA(Pointer, te) {
-                emit_ctype_ptr(te.inner, inner);
+                fmt_ctype_ptr_prefix(os, te.inner);
                 }
             TU_ARMA(Function, te) {
-                m_of << "t_" << Trans_Mangle(ty) << " " << inner;
+                os << "t_" << Trans_Mangle(ty) << " ";
                 }
                 break;
             case ::HIR::TypeData::TAG_Closure:
@@ -7244,6 +7271,23 @@ namespace {
                 break;
             }
         }
+        void fmt_ctype_ptr_prefix(::std::ostream& os, const ::HIR::TypeRef& inner_ty) {
+            switch( this->metadata_type(inner_ty) )
+            {
+            case MetadataType::Unknown:
+                BUG(sp, inner_ty << " unknown metadata type");
+            case MetadataType::None:
+            case MetadataType::Zero:
+                os << get_ctype_prefix(inner_ty) << "*";
+                break;
+            case MetadataType::Slice:
+                os << "SLICE_PTR ";
+                break;
+            case MetadataType::TraitObject:
+                os << "TRAITOBJ_PTR ";
+                break;
+            }
+        }
 
         ::HIR::TypeRef get_inner_unsized_type(const ::HIR::TypeRef& ty)
         {
@@ -7301,30 +7345,6 @@ namespace {
             return m_resolve.metadata_type(m_mir_res ? m_mir_res->sp : sp, ty);
         }
 
-        void emit_ctype_ptr(const ::HIR::TypeRef& inner_ty, ::FmtLambda inner) {
-            //if( inner_ty.data().is_Array() ) {
-            //    emit_ctype(inner_ty, FMT_CB(ss, ss << "(*" << inner << ")";));
-            //}
-            //else
-            {
-                switch( this->metadata_type(inner_ty) )
-                {
-                case MetadataType::Unknown:
-                    BUG(sp, inner_ty << " unknown metadata type");
-                case MetadataType::None:
-                case MetadataType::Zero:
-                    emit_ctype(inner_ty, FMT_CB(ss, ss << "*" << inner;));
-                    break;
-                case MetadataType::Slice:
-                    m_of << "SLICE_PTR " << inner;
-                    break;
-                case MetadataType::TraitObject:
-                    m_of << "TRAITOBJ_PTR " << inner;
-                    break;
-                }
-            }
-        }
-
         bool is_dst(const ::HIR::TypeRef& ty) const
         {
             switch(this->metadata_type(ty))
@@ -7344,7 +7364,7 @@ namespace {
     Span CodeGenerator_C::sp;
 }
 
-::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile)
+::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt)
 {
-    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile));
+    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile, opt));
 }
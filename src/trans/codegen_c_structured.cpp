@@ -74,11 +74,73 @@ size_t NodeRef::target() const
     }
 }
 
+namespace {
+    /// Call a callback for each successor of a block that can be reached in the generated code
+    /// - The panic arm of calls is ignored (unwinding isn't supported by the C backend)
+    template<typename Cb>
+    void visit_successors(const ::MIR::Terminator& term, Cb cb)
+    {
+        TU_MATCHA( (term), (te),
+        (Incomplete,
+            ),
+        (Goto,
+            cb(te);
+            ),
+        (Panic,
+            cb(te.dst);
+            ),
+        (Diverge,
+            ),
+        (Return,
+            ),
+        (If,
+            cb(te.bb0);
+            cb(te.bb1);
+            ),
+        (Switch,
+            for(auto tgt : te.targets)
+                cb(tgt);
+            ),
+        (SwitchValue,
+            for(auto tgt : te.targets)
+                cb(tgt);
+            cb(te.def_target);
+            ),
+        (Call,
+            cb(te.ret_block);
+            )
+        )
+    }
+
+    /// Pick the most common exit target of a set of arms
+    size_t most_common_target(::std::vector<size_t> next_blocks)
+    {
+        ::std::sort(next_blocks.begin(), next_blocks.end());
+        size_t  exit_bb = SIZE_MAX;
+        size_t  max_count = 0;
+        for(size_t i = 0; i < next_blocks.size(); )
+        {
+            size_t j = i;
+            while(j < next_blocks.size() && next_blocks[j] == next_blocks[i])
+                j ++;
+            if( j - i > max_count ) {
+                exit_bb = next_blocks[i];
+                max_count = j - i;
+            }
+            i = j;
+        }
+        return exit_bb;
+    }
+}
+
 class Converter
 {
     const ::MIR::Function& m_fcn;
 public:
+    /// Number of (reachable) references to each block
     ::std::vector<unsigned> m_block_ref_count;
+    /// Number of references to each block from blocks that have already been placed
+    ::std::vector<unsigned> m_block_ref_seen;
     ::std::vector<bool> m_blocks_used;
 
     Converter(const ::MIR::Function& fcn):
@@ -101,6 +163,21 @@ public:
             return true;
         }
     }
+    // Returns true if the passed block can follow a branch (all of its other references have already been placed)
+    // - i.e. it's the point where the arms of an if/switch join
+    bool bb_is_join(size_t bb_idx)
+    {
+        if( m_blocks_used[bb_idx] ) {
+            return false;
+        }
+        return m_block_ref_seen[bb_idx] == m_block_ref_count[bb_idx];
+    }
+    void mark_used(size_t bb_idx)
+    {
+        assert( !m_blocks_used[bb_idx] );
+        m_blocks_used[bb_idx] = true;
+        visit_successors(m_fcn.blocks.at(bb_idx).terminator, [&](size_t tgt){ m_block_ref_seen[tgt] += 1; });
+    }
     NodeRef process_node_ref(size_t bb_idx)
     {
         if( bb_is_opening(bb_idx) ) {
@@ -120,8 +197,9 @@ public:
             DEBUG("bb_idx = " << bb_idx);
             assert(bb_idx != SIZE_MAX);
             bool stop = false;
-            assert( !m_blocks_used[bb_idx] );
-            m_blocks_used[bb_idx] = true;
+            // Set if the terminator was a branch, allowing the join block to follow
+            bool is_branch = false;
+            mark_used(bb_idx);
 
             refs.push_back( NodeRef(bb_idx) );
 
@@ -135,7 +213,8 @@ public:
                 bb_idx = te;
                 ),
             (Panic,
-                TODO(Span(), "Panic");
+                // Emitted as a goto
+                bb_idx = te.dst;
                 ),
             (Diverge,
                 stop = true;
@@ -174,6 +253,7 @@ public:
                     stop = true;
                 }
                 refs.push_back(Node::make_If({ bb_idx, &te.cond, mv$(arm0), mv$(arm1) }));
+                is_branch = true;
                 ),
             (Switch,
                 ::std::vector<NodeRef>  arms;
@@ -186,35 +266,13 @@ public:
                         next_blocks.push_back( arms.back().target() );
                     }
                 }
-                // TODO: Make the next block common
-                ::std::sort(next_blocks.begin(), next_blocks.end());
-                size_t  exit_bb = SIZE_MAX;
-                if(!next_blocks.empty())
-                {
-                    size_t  cur = next_blocks[0];
-                    size_t  cur_count = 0;
-                    size_t  max_count = 0;
-                    for(auto b : next_blocks)
-                    {
-                        if(cur == b) {
-                            cur_count ++;
-                        }
-                        else {
-                            if( cur_count > max_count ) {
-                                exit_bb = cur;
-                            }
-                            cur = b;
-                            cur_count = 1;
-                        }
-                    }
-                    if( cur_count > max_count ) {
-                        exit_bb = cur;
-                    }
-                }
+                // Exit to the most common next block (other arms use `goto`)
+                size_t  exit_bb = most_common_target(mv$(next_blocks));
                 refs.push_back(Node::make_Switch({ exit_bb, &te.val, mv$(arms) }));
                 bb_idx = exit_bb;
                 if( bb_idx == SIZE_MAX )
                     stop = true;
+                is_branch = true;
                 ),
             (SwitchValue,
                 ::std::vector<NodeRef>  arms;
@@ -233,35 +291,13 @@ public:
                     next_blocks.push_back(def_arm.target());
                 }
 
-                // TODO: Make the next block common
-                ::std::sort(next_blocks.begin(), next_blocks.end());
-                size_t  exit_bb = SIZE_MAX;
-                if(!next_blocks.empty())
-                {
-                    size_t  cur = next_blocks[0];
-                    size_t  cur_count = 0;
-                    size_t  max_count = 0;
-                    for(auto b : next_blocks)
-                    {
-                        if(cur == b) {
-                            cur_count ++;
-                        }
-                        else {
-                            if( cur_count > max_count ) {
-                                exit_bb = cur;
-                            }
-                            cur = b;
-                            cur_count = 1;
-                        }
-                    }
-                    if( cur_count > max_count ) {
-                        exit_bb = cur;
-                    }
-                }
+                size_t  exit_bb = most_common_target(mv$(next_blocks));
 
                 refs.push_back(Node::make_SwitchValue({ exit_bb, &te.val, mv$(def_arm), mv$(arms), &te.values }));
-                stop = true;
-
+                bb_idx = exit_bb;
+                if( bb_idx == SIZE_MAX )
+                    stop = true;
+                is_branch = true;
                 ),
             (Call,
                 // NOTE: Let the panic arm just be a goto
@@ -297,6 +333,10 @@ public:
             {
                 DEBUG("Destination " << bb_idx << " is unreferenced+unvisited");
             }
+            else if( is_branch && bb_is_join(bb_idx) )
+            {
+                DEBUG("Destination " << bb_idx << " is the join of the branch");
+            }
             else
             {
                 break;
@@ -321,40 +361,12 @@ public:
 {
     Converter   conv(fcn);
     conv.m_block_ref_count.resize( fcn.blocks.size() );
+    conv.m_block_ref_seen.resize( fcn.blocks.size() );
     conv.m_block_ref_count[0] += 1;
+    conv.m_block_ref_seen[0] += 1;
     for(const auto& blk : fcn.blocks)
     {
-        TU_MATCHA( (blk.terminator), (te),
-        (Incomplete,
-            ),
-        (Goto,
-            conv.m_block_ref_count[te] += 1;
-            ),
-        (Panic,
-            conv.m_block_ref_count[te.dst] += 1;
-            ),
-        (Diverge,
-            ),
-        (Return,
-            ),
-        (If,
-            conv.m_block_ref_count[te.bb0] += 1;
-            conv.m_block_ref_count[te.bb1] += 1;
-            ),
-        (Switch,
-            for(auto tgt : te.targets)
-                conv.m_block_ref_count[tgt] += 1;
-            ),
-        (SwitchValue,
-            for(auto tgt : te.targets)
-                conv.m_block_ref_count[tgt] += 1;
-            conv.m_block_ref_count[te.def_target] += 1;
-            ),
-        (Call,
-            conv.m_block_ref_count[te.ret_block] += 1;
-            conv.m_block_ref_count[te.panic_block] += 1;
-            )
-        )
+        visit_successors(blk.terminator, [&](size_t tgt){ conv.m_block_ref_count[tgt] += 1; });
     }
 
     // First Block: Becomes a block in structured output
@@ -368,6 +380,9 @@ public:
     {
         if( conv.m_blocks_used[bb_idx] )
             continue;
+        // Unreferenced (e.g. only used by a call's panic arm), so never reached
+        if( conv.m_block_ref_count[bb_idx] == 0 )
+            continue;
 
         nodes.push_back( conv.process_node(bb_idx) );
     }
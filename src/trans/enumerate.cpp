@@ -17,7 +17,9 @@
 #include <hir/item_path.hpp>
 #include <deque>
 #include <algorithm>
+#include <iostream>
 #include "target.hpp"
+#include "polymorphise.hpp"
 
 namespace {
     struct EnumState
@@ -29,8 +31,17 @@ namespace {
         ::std::deque<TransList_Function*>  fcn_queue;
         ::std::vector<TransList_Function*> fcns_to_type_visit;
 
-        EnumState(const ::HIR::Crate& crate):
-            crate(crate)
+        // Sharing of instances that only differ in parameters the function doesn't depend on
+        bool    polymorphise;
+        StaticTraitResolve  resolve;
+        ::std::map<const ::HIR::Function*, FunctionParamUsage>  param_usage;
+        ::std::map<::std::pair<const ::HIR::Function*, ::std::string>, const ::HIR::Path*>  shared_instances;
+        unsigned    n_generic_instances = 0;
+
+        EnumState(const ::HIR::Crate& crate, bool polymorphise=false):
+            crate(crate),
+            polymorphise(polymorphise),
+            resolve(crate)
         {}
 
         void enum_fcn(::HIR::Path p, const ::HIR::Function& fcn, Trans_Params pp)
@@ -40,9 +51,41 @@ namespace {
                 fcns_to_type_visit.push_back(e);
                 e->ptr = &fcn;
                 e->pp = mv$(pp);
-                fcn_queue.push_back(e);
+                if( const auto* shared = get_shared_instance(*e) )
+                {
+                    DEBUG(*e->path << " = " << *shared);
+                    e->shared_instance = shared;
+                }
+                else
+                {
+                    fcn_queue.push_back(e);
+                }
             }
         }
+
+    private:
+        /// Get an existing instance that `e` can forward to, or register it as the instance to use for its key
+        const ::HIR::Path* get_shared_instance(const TransList_Function& e)
+        {
+            const auto& fcn = *e.ptr;
+            if( !polymorphise )
+                return nullptr;
+            if( !e.pp.has_types() && e.pp.self_type.data().is_Infer() )
+                return nullptr;
+            if( !fcn.m_code.m_mir || !(fcn.m_abi == ABI_RUST || fcn.m_abi == "rust-call") || fcn.m_variadic || fcn.m_linkage.name != "" )
+                return nullptr;
+            n_generic_instances ++;
+
+            auto it = param_usage.find(&fcn);
+            if( it == param_usage.end() )
+                it = param_usage.insert(::std::make_pair( &fcn, Trans_Polymorphise_GetParamUsage(fcn) )).first;
+            auto key = Trans_Polymorphise_GetKey(resolve, it->second, e.pp);
+            if( key == "" )
+                return nullptr;
+
+            auto ins = shared_instances.insert(::std::make_pair( ::std::make_pair(&fcn, mv$(key)), e.path ));
+            return ins.second ? nullptr : ins.first->second;
+        }
     };
 }
 
@@ -101,11 +144,11 @@ namespace MIR {
 }
 
 /// Enumerate trans items starting from `::main` (binary crate)
-TransList Trans_Enumerate_Main(const ::HIR::Crate& crate)
+TransList Trans_Enumerate_Main(const ::HIR::Crate& crate, bool polymorphise)
 {
     static Span sp;
 
-    EnumState   state { crate };
+    EnumState   state { crate, polymorphise };
 
     auto c_start_path = crate.get_lang_item_path_opt("mrustc-start");
     if( c_start_path == ::HIR::SimplePath() )
@@ -280,10 +323,10 @@ namespace {
 }
 
 /// Enumerate trans items for all public non-generic items (library crate)
-TransList Trans_Enumerate_Public(::HIR::Crate& crate)
+TransList Trans_Enumerate_Public(::HIR::Crate& crate, bool polymorphise)
 {
     static Span sp;
-    EnumState   state { crate };
+    EnumState   state { crate, polymorphise };
 
     Trans_Enumerate_Public_Mod(state, crate.m_root_module,  ::HIR::SimplePath(crate.m_crate_name,{}), true);
 
@@ -467,6 +510,13 @@ TransList Trans_Enumerate_CommonPost(EnumState& state)
     Trans_Enumerate_CommonPost_Run(state);
     Trans_Enumerate_Types(state);
 
+    if( getenv("MRUSTC_POLYMORPHISE_STATS") )
+    {
+        size_t n_shared = ::std::count_if(state.rv.m_functions.begin(), state.rv.m_functions.end(), [](const auto& e){ return e.second->shared_instance != nullptr; });
+        ::std::cout << "Polymorphisation: " << state.n_generic_instances << " generic instances, "
+            << n_shared << " sharing code with another" << ::std::endl;
+    }
+
     return mv$(state.rv);
 }
 
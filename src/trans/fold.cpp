@@ -0,0 +1,669 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * trans/fold.cpp
+ * - Identical code folding of monomorphised functions
+ *
+ * Monomorphised functions are often identical other than the types they use (e.g. `Vec<*const A>` and
+ * `Vec<*const B>`), so bodies are compared with each type replaced by a "layout class" (a string that only
+ * describes how the value is stored), and duplicates are replaced by a stub that calls the first copy.
+ */
+#include "main_bindings.hpp"
+#include "trans_list.hpp"
+#include "mangling.hpp" // Trans_MangleHash
+#include "target.hpp"
+#include "monomorphise.hpp"  // Trans_MakeForwardingStub
+#include <hir/hir.hpp>
+#include <mir/mir.hpp>
+#include <mir/helpers.hpp>
+#include <mir/operations.hpp>   // MIR_Validate
+#include <hir_typeck/static.hpp>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>    // any_of
+#include <sstream>
+#include <numeric>  // iota
+#include <iostream>
+
+namespace {
+    /// Write a length-prefixed string (so concatenated keys can't alias)
+    void put_str(::std::ostream& os, const ::std::string& s)
+    {
+        os << s.size() << ':' << s;
+    }
+    /// Write the exact form of an item (for when the layout isn't enough to know the behaviour)
+    template<typename T>
+    void put_exact(::std::ostream& os, const T& v)
+    {
+        put_str(os, FMT(v));
+    }
+
+    /// Layout classes - equal for two types when a value of one can be handled (moved, compared, accessed) using
+    /// the code generated for the other.
+    /// - Primitives are kept exactly (signedness/floats matter)
+    /// - Thin pointers are all the same (dereferences record the pointee class separately)
+    /// - Structs/enums/unions/tuples are described by their `TypeRepr` (offsets, tag encoding, field classes)
+    /// - Anything else is kept exactly
+    class LayoutClasses
+    {
+        const StaticTraitResolve&   m_resolve;
+        ::std::unordered_map<::HIR::TypeRef, ::std::string, Trans_MangleHash>   m_cache;
+    public:
+        LayoutClasses(const StaticTraitResolve& resolve):
+            m_resolve(resolve)
+        {
+        }
+
+        const ::std::string& get(const ::HIR::TypeRef& ty)
+        {
+            auto it = m_cache.find(ty);
+            if( it != m_cache.end() )
+                return it->second;
+            ::std::ostringstream    os;
+            fmt(os, ty);
+            return m_cache.insert(::std::make_pair(ty.clone(), os.str())).first->second;
+        }
+
+    private:
+        void fmt(::std::ostream& os, const ::HIR::TypeRef& ty)
+        {
+            static Span sp;
+            TU_MATCH_HDRA( (ty.data()), {)
+            default:
+                os << "="; put_exact(os, ty);
+                break;
+            TU_ARMA(Diverge, te) {
+                os << "!";
+                }
+            TU_ARMA(Primitive, te) {
+                os << te;
+                }
+            TU_ARMA(Array, te) {
+                os << "["; put_str(os, get(te.inner)); os << ";" << te.size << "]";
+                }
+            TU_ARMA(Slice, te) {
+                os << "[]"; put_str(os, get(te.inner));
+                }
+            TU_ARMA(Borrow, te) {
+                fmt_pointer(os, ty, te.inner);
+                }
+            TU_ARMA(Pointer, te) {
+                fmt_pointer(os, ty, te.inner);
+                }
+            TU_ARMA(Tuple, te) {
+                os << "T";
+                fmt_repr(os, ty);
+                }
+            TU_ARMA(Path, te) {
+                TU_MATCH_HDRA( (te.binding), {)
+                default:
+                    os << "="; put_exact(os, ty);
+                    break;
+                TU_ARMA(Struct, tpb) {
+                    os << "S";
+                    fmt_repr(os, ty);
+                    }
+                TU_ARMA(Enum, tpb) {
+                    os << "E";
+                    fmt_repr(os, ty);
+                    }
+                TU_ARMA(Union, tpb) {
+                    os << "U";
+                    fmt_repr(os, ty);
+                    }
+                }
+                }
+            }
+        }
+        void fmt_pointer(::std::ostream& os, const ::HIR::TypeRef& ty, const ::HIR::TypeRef& inner)
+        {
+            static Span sp;
+            switch( m_resolve.metadata_type(sp, inner) )
+            {
+            case MetadataType::None:
+            case MetadataType::Zero:
+                os << "*";
+                break;
+            case MetadataType::Slice:
+                os << "*[]";
+                break;
+            case MetadataType::TraitObject:
+                os << "*dyn";
+                break;
+            case MetadataType::Unknown:
+                os << "="; put_exact(os, ty);
+                break;
+            }
+        }
+        void fmt_repr(::std::ostream& os, const ::HIR::TypeRef& ty)
+        {
+            static Span sp;
+            // Unsized types (only seen behind pointers) are kept exact
+            if( m_resolve.metadata_type(sp, ty) != MetadataType::None ) {
+                os << "="; put_exact(os, ty);
+                return ;
+            }
+            const auto* repr = Target_GetTypeRepr(sp, m_resolve, ty);
+            if( !repr ) {
+                os << "="; put_exact(os, ty);
+                return ;
+            }
+            os << "{" << repr->size << "," << repr->align << ";";
+            TU_MATCH_HDRA( (repr->variants), {)
+            TU_ARMA(None, ve) {
+                }
+            TU_ARMA(Linear, ve) {
+                os << "L" << ve.field << "+" << ve.offset << "/" << ve.num_variants;
+                }
+            TU_ARMA(Values, ve) {
+                os << "V" << ve.field;
+                for(auto v : ve.values)
+                    os << "," << v;
+                }
+            TU_ARMA(NonZero, ve) {
+                os << "Z" << ve.field << "/" << ve.zero_variant;
+                }
+            }
+            for(const auto& f : repr->fields)
+            {
+                os << ";" << f.offset << ":";
+                put_str(os, get(f.ty));
+            }
+            os << "}";
+        }
+    };
+
+    /// Canonical form of a function body, with references to other enumerated functions left as slots (filled in
+    /// with the current fold representative for each pass)
+    struct FunctionKey
+    {
+        bool    valid = true;
+        ::std::string   text;
+        ::std::vector<size_t>   callees;
+        size_t  weight = 0;
+    };
+
+    class KeyBuilder
+    {
+        const StaticTraitResolve&   m_resolve;
+        LayoutClasses&  m_classes;
+        ::MIR::TypeResolve& m_mir_res;
+        const ::std::function<size_t(const ::HIR::Path&)>&  m_get_index;
+
+        ::std::ostringstream    m_os;
+        FunctionKey&    m_out;
+    public:
+        KeyBuilder(const StaticTraitResolve& resolve, LayoutClasses& classes, ::MIR::TypeResolve& mir_res, const ::std::function<size_t(const ::HIR::Path&)>& get_index, FunctionKey& out):
+            m_resolve(resolve),
+            m_classes(classes),
+            m_mir_res(mir_res),
+            m_get_index(get_index),
+            m_out(out)
+        {
+        }
+
+        void build(const ::MIR::Function& fcn, const ::HIR::TypeRef& ret_ty, const ::HIR::Function::args_t& args)
+        {
+            m_os << "R"; put_class(ret_ty);
+            m_os << "A" << args.size();
+            for(const auto& a : args)
+                put_class(a.second);
+            m_os << "L" << fcn.locals.size();
+            for(const auto& ty : fcn.locals)
+                put_class(ty);
+            m_os << "F";
+            for(bool f : fcn.drop_flags)
+                m_os << (f ? "1" : "0");
+
+            for(const auto& bb : fcn.blocks)
+            {
+                m_os << "\nB" << bb.statements.size();
+                for(const auto& stmt : bb.statements)
+                {
+                    m_mir_res.set_cur_stmt(bb, stmt);
+                    m_os << "\n";
+                    fmt_stmt(stmt);
+                }
+                m_mir_res.set_cur_stmt_term(bb);
+                m_os << "\n";
+                fmt_term(bb.terminator);
+                m_out.weight += 1 + bb.statements.size();
+            }
+            m_out.text = m_os.str();
+        }
+
+    private:
+        void put_class(const ::HIR::TypeRef& ty)
+        {
+            put_str(m_os, m_classes.get(ty));
+        }
+        void put_fcn_ref(const ::HIR::Path& p)
+        {
+            auto idx = m_get_index(p);
+            if( idx != SIZE_MAX ) {
+                m_os << "@";
+                m_out.callees.push_back(idx);
+            }
+            else {
+                m_os << "="; put_exact(m_os, p);
+            }
+        }
+
+        void fmt_lvalue(const ::MIR::LValue& lv)
+        {
+            const auto& root = lv.m_root;
+            if( root.is_Return() ) {
+                m_os << "r";
+            }
+            else if( root.is_Argument() ) {
+                m_os << "a" << root.as_Argument();
+            }
+            else if( root.is_Local() ) {
+                m_os << "l" << root.as_Local();
+            }
+            else {
+                m_os << "s"; put_exact(m_os, root.as_Static());
+            }
+            for(size_t i = 0; i < lv.m_wrappers.size(); i ++)
+            {
+                const auto& w = lv.m_wrappers[i];
+                if( w.is_Deref() ) {
+                    // Thin pointers don't include the pointee in their class, so record it here
+                    ::HIR::TypeRef  tmp;
+                    const auto& ty = m_mir_res.get_lvalue_type(tmp, lv, lv.m_wrappers.size() - (i+1));
+                    m_os << "*"; put_class(ty);
+                }
+                else if( w.is_Field() ) {
+                    m_os << "." << w.as_Field();
+                }
+                else if( w.is_Downcast() ) {
+                    m_os << "#" << w.as_Downcast();
+                }
+                else {
+                    m_os << "[" << w.as_Index() << "]";
+                }
+            }
+            m_os << ";";
+        }
+        void fmt_const(const ::MIR::Constant& c)
+        {
+            TU_MATCH_HDRA( (c), {)
+            TU_ARMA(Int, ce) {
+                m_os << "i" << ce.v << ce.t;
+                }
+            TU_ARMA(Uint, ce) {
+                m_os << "u" << ce.v << ce.t;
+                }
+            TU_ARMA(Float, ce) {
+                m_os << "f"; put_exact(m_os, c);
+                }
+            TU_ARMA(Bool, ce) {
+                m_os << (ce.v ? "T" : "F");
+                }
+            TU_ARMA(Bytes, ce) {
+                m_os << "b"; put_str(m_os, ::std::string(ce.begin(), ce.end()));
+                }
+            TU_ARMA(StaticString, ce) {
+                m_os << "t"; put_str(m_os, ce);
+                }
+            TU_ARMA(Const, ce) {
+                m_os << "c"; put_exact(m_os, *ce.p);
+                }
+            TU_ARMA(Generic, ce) {
+                m_os << "g"; put_exact(m_os, c);
+                }
+            TU_ARMA(ItemAddr, ce) {
+                m_os << "&";
+                if( ce ) {
+                    put_fcn_ref(*ce);
+                }
+                else {
+                    m_os << "-";
+                }
+                }
+            }
+            m_os << ";";
+        }
+        void fmt_param(const ::MIR::Param& p)
+        {
+            TU_MATCH_HDRA( (p), {)
+            TU_ARMA(LValue, pe) {
+                fmt_lvalue(pe);
+                }
+            TU_ARMA(Borrow, pe) {
+                m_os << "&" << pe.type;
+                fmt_lvalue(pe.val);
+                }
+            TU_ARMA(Constant, pe) {
+                fmt_const(pe);
+                }
+            }
+        }
+        void fmt_params(const ::std::vector<::MIR::Param>& ps)
+        {
+            m_os << "(" << ps.size();
+            for(const auto& p : ps)
+                fmt_param(p);
+            m_os << ")";
+        }
+        void fmt_intrinsic_params(const RcString& name, const ::HIR::PathParams& params)
+        {
+            // Intrinsics that only depend on the size/layout of their type parameters
+            static const char* LAYOUT_ONLY[] = {
+                "size_of", "min_align_of", "align_of", "pref_align_of",
+                "transmute", "forget", "move_val_init", "uninit", "init",
+                "copy", "copy_nonoverlapping", "write_bytes",
+                "offset", "arith_offset", "ptr_offset_from",
+                "volatile_load", "volatile_store",
+                "discriminant_value",
+                };
+            bool layout_only = ::std::any_of(::std::begin(LAYOUT_ONLY), ::std::end(LAYOUT_ONLY), [&](const char* n){ return name == n; });
+            // `drop_in_place` is a no-op (so just layout dependent) if the type doesn't need drop glue
+            if( name == "drop_in_place" && !params.m_types.empty() ) {
+                layout_only = !m_resolve.type_needs_drop_glue(m_mir_res.sp, params.m_types[0]);
+            }
+            if( layout_only && params.m_values.empty() ) {
+                m_os << "<" << params.m_types.size();
+                for(const auto& ty : params.m_types)
+                    put_class(ty);
+                m_os << ">";
+            }
+            else {
+                put_exact(m_os, params);
+            }
+        }
+        void fmt_stmt(const ::MIR::Statement& stmt)
+        {
+            TU_MATCH_HDRA( (stmt), {)
+            TU_ARMA(Assign, se) {
+                m_os << "=";
+                fmt_lvalue(se.dst);
+                fmt_rvalue(se.dst, se.src);
+                }
+            TU_ARMA(Asm, se) {
+                // Operand types aren't visible to the key, so don't fold these
+                m_out.valid = false;
+                }
+            TU_ARMA(Asm2, se) {
+                m_out.valid = false;
+                }
+            TU_ARMA(SetDropFlag, se) {
+                m_os << "F" << se.idx << (se.new_val ? "T" : "F") << se.other;
+                }
+            TU_ARMA(Drop, se) {
+                m_os << "D" << (se.kind == ::MIR::eDropKind::DEEP ? "d" : "s") << se.flag_idx << ";";
+                fmt_lvalue(se.slot);
+                // Drop glue depends on the actual type (not just the layout)
+                ::HIR::TypeRef  tmp;
+                const auto& ty = m_mir_res.get_lvalue_type(tmp, se.slot);
+                if( se.kind == ::MIR::eDropKind::SHALLOW || m_resolve.type_needs_drop_glue(m_mir_res.sp, ty) ) {
+                    put_exact(m_os, ty);
+                }
+                }
+            TU_ARMA(ScopeEnd, se) {
+                m_os << "E" << se.slots.size();
+                for(auto s : se.slots)
+                    m_os << "," << s;
+                }
+            }
+        }
+        void fmt_rvalue(const ::MIR::LValue& dst, const ::MIR::RValue& rv)
+        {
+            TU_MATCH_HDRA( (rv), {)
+            TU_ARMA(Use, re) {
+                m_os << "U";
+                fmt_lvalue(re);
+                }
+            TU_ARMA(Borrow, re) {
+                m_os << "&" << re.type;
+                fmt_lvalue(re.val);
+                }
+            TU_ARMA(Constant, re) {
+                m_os << "C";
+                fmt_const(re);
+                }
+            TU_ARMA(SizedArray, re) {
+                m_os << "A" << re.count;
+                fmt_param(re.val);
+                }
+            TU_ARMA(Cast, re) {
+                m_os << "as";
+                fmt_lvalue(re.val);
+                put_class(re.type);
+                }
+            TU_ARMA(BinOp, re) {
+                m_os << "B" << static_cast<int>(re.op);
+                fmt_param(re.val_l);
+                fmt_param(re.val_r);
+                }
+            TU_ARMA(UniOp, re) {
+                m_os << "N" << static_cast<int>(re.op);
+                fmt_lvalue(re.val);
+                }
+            TU_ARMA(DstMeta, re) {
+                m_os << "M";
+                fmt_lvalue(re.val);
+                }
+            TU_ARMA(DstPtr, re) {
+                m_os << "P";
+                fmt_lvalue(re.val);
+                }
+            TU_ARMA(MakeDst, re) {
+                m_os << "D";
+                fmt_param(re.ptr_val);
+                fmt_param(re.meta_val);
+                }
+            TU_ARMA(Tuple, re) {
+                m_os << "T";
+                fmt_params(re.vals);
+                }
+            TU_ARMA(Array, re) {
+                m_os << "R";
+                fmt_params(re.vals);
+                }
+            TU_ARMA(UnionVariant, re) {
+                m_os << "V" << re.index;
+                put_dst_class(dst);
+                fmt_param(re.val);
+                }
+            TU_ARMA(EnumVariant, re) {
+                m_os << "E" << re.index;
+                put_dst_class(dst);
+                fmt_params(re.vals);
+                }
+            TU_ARMA(Struct, re) {
+                m_os << "S";
+                put_dst_class(dst);
+                fmt_params(re.vals);
+                }
+            }
+        }
+        void put_dst_class(const ::MIR::LValue& dst)
+        {
+            ::HIR::TypeRef  tmp;
+            put_class(m_mir_res.get_lvalue_type(tmp, dst));
+        }
+        void fmt_term(const ::MIR::Terminator& term)
+        {
+            TU_MATCH_HDRA( (term), {)
+            TU_ARMA(Incomplete, te) {
+                m_os << "I";
+                }
+            TU_ARMA(Return, te) {
+                m_os << "R";
+                }
+            TU_ARMA(Diverge, te) {
+                m_os << "D";
+                }
+            TU_ARMA(Goto, te) {
+                m_os << "G" << te;
+                }
+            TU_ARMA(Panic, te) {
+                m_os << "P" << te.dst;
+                }
+            TU_ARMA(If, te) {
+                m_os << "I" << te.bb0 << "," << te.bb1;
+                fmt_lvalue(te.cond);
+                }
+            TU_ARMA(Switch, te) {
+                m_os << "S";
+                fmt_lvalue(te.val);
+                for(auto t : te.targets)
+                    m_os << "," << t;
+                }
+            TU_ARMA(SwitchValue, te) {
+                m_os << "V" << te.def_target;
+                fmt_lvalue(te.val);
+                for(auto t : te.targets)
+                    m_os << "," << t;
+                TU_MATCH_HDRA( (te.values), {)
+                TU_ARMA(Unsigned, vals) {
+                    for(auto v : vals)
+                        m_os << ",u" << v;
+                    }
+                TU_ARMA(Signed, vals) {
+                    for(auto v : vals)
+                        m_os << ",i" << v;
+                    }
+                TU_ARMA(String, vals) {
+                    for(const auto& v : vals) {
+                        m_os << ",s"; put_str(m_os, v);
+                    }
+                    }
+                TU_ARMA(ByteString, vals) {
+                    for(const auto& v : vals) {
+                        m_os << ",b"; put_str(m_os, ::std::string(v.begin(), v.end()));
+                    }
+                    }
+                }
+                }
+            TU_ARMA(Call, te) {
+                m_os << "C" << te.ret_block << "," << te.panic_block;
+                fmt_lvalue(te.ret_val);
+                TU_MATCH_HDRA( (te.fcn), {)
+                TU_ARMA(Value, e) {
+                    m_os << "v";
+                    fmt_lvalue(e);
+                    }
+                TU_ARMA(Path, e) {
+                    m_os << "p";
+                    put_fcn_ref(e);
+                    }
+                TU_ARMA(Intrinsic, e) {
+                    m_os << "i";
+                    put_str(m_os, e.name.c_str());
+                    fmt_intrinsic_params(e.name, e.params);
+                    }
+                }
+                fmt_params(te.args);
+                }
+            }
+        }
+    };
+}
+
+void Trans_FoldIdentical(const ::HIR::Crate& crate, TransList& list)
+{
+    static Span sp;
+    ::StaticTraitResolve    resolve { crate };
+    LayoutClasses   classes { resolve };
+
+    struct Ent {
+        ::std::pair<const ::HIR::Path, ::std::unique_ptr<TransList_Function>>*  ent;
+        FunctionKey key;
+    };
+    ::std::vector<Ent>  ents;
+    ::std::unordered_map<const TransList_Function*, size_t> indexes;
+    ents.reserve(list.m_functions.size());
+    for(auto& fcn_ent : list.m_functions)
+    {
+        indexes.insert(::std::make_pair(fcn_ent.second.get(), ents.size()));
+        ents.push_back(Ent { &fcn_ent });
+    }
+    ::std::function<size_t(const ::HIR::Path&)> get_index = [&](const ::HIR::Path& p)->size_t {
+        auto it = list.m_functions.find(p);
+        if( it == list.m_functions.end() )
+            return SIZE_MAX;
+        return indexes.at(it->second.get());
+        };
+
+    // 1. Build the keys for all candidate functions
+    // - Only monomorphised Rust-ABI functions (others are either shared with other crates, or have a fixed ABI)
+    ::std::vector<size_t>   candidates;
+    for(size_t i = 0; i < ents.size(); i ++)
+    {
+        const auto& path = ents[i].ent->first;
+        const auto& tl_fcn = *ents[i].ent->second;
+        const auto& fcn = *tl_fcn.ptr;
+        if( !tl_fcn.monomorphised.code || tl_fcn.force_prototype )
+            continue ;
+        if( !(fcn.m_abi == ABI_RUST || fcn.m_abi == "rust-call") || fcn.m_variadic || fcn.m_linkage.name != "" )
+            continue ;
+        TRACE_FUNCTION_F(path);
+        const auto& mon = tl_fcn.monomorphised;
+        ::MIR::TypeResolve  mir_res { sp, resolve, FMT_CB(ss, ss << path), mon.ret_ty, mon.arg_tys, *mon.code };
+        KeyBuilder(resolve, classes, mir_res, get_index, ents[i].key).build(*mon.code, mon.ret_ty, mon.arg_tys);
+        if( ents[i].key.valid ) {
+            candidates.push_back(i);
+        }
+    }
+
+    // 2. Group functions with equal keys, repeating until no new groups form (as merging callees can make their
+    //    callers equal)
+    // - Recursive functions only fold if they're already identical, as the self-reference keeps them apart.
+    ::std::vector<size_t>   reps(ents.size());
+    ::std::iota(reps.begin(), reps.end(), 0);
+    unsigned n_passes = 0;
+    for(bool changed = true; changed; )
+    {
+        changed = false;
+        n_passes += 1;
+        ::std::unordered_map<::std::string, size_t>   groups;
+        for(size_t i : candidates)
+        {
+            const auto& key = ents[i].key;
+            ::std::string   k = key.text;
+            for(size_t c : key.callees) {
+                k += ',';
+                k += ::std::to_string(reps[c]);
+            }
+            auto new_rep = groups.insert(::std::make_pair(mv$(k), i)).first->second;
+            if( new_rep != reps[i] ) {
+                reps[i] = new_rep;
+                changed = true;
+            }
+        }
+    }
+
+    // 3. Replace the bodies of duplicates with a call to the representative
+    // - Functions that aren't much larger than the stub are left alone (they still count as folded for their
+    //   callers), as the stub's C (call + argument conversions) is more verbose than most MIR statements.
+    size_t n_folded = 0;
+    size_t n_stubbed = 0;
+    for(size_t i : candidates)
+    {
+        if( reps[i] == i )
+            continue ;
+        n_folded ++;
+        const auto& path = ents[i].ent->first;
+        auto& dst = ents[i].ent->second->monomorphised;
+        const auto& src_path = ents[reps[i]].ent->first;
+        const auto& src = ents[reps[i]].ent->second->monomorphised;
+
+        auto code = Trans_MakeForwardingStub(src_path, dst, src);
+        size_t stub_weight = code->blocks.size() + 1;
+        if( ents[i].key.weight <= 3 * stub_weight )
+            continue ;
+        DEBUG(path << " = " << src_path);
+        MIR_Validate(resolve, ::HIR::ItemPath(path), *code, dst.arg_tys, dst.ret_ty);
+        dst.code = mv$(code);
+        n_stubbed ++;
+    }
+
+    if( getenv("MRUSTC_FOLD_STATS") )
+    {
+        ::std::cout << "Folding: " << candidates.size() << " candidates, " << n_passes << " passes, "
+            << n_folded << " folded (" << n_stubbed << " replaced with stubs)" << ::std::endl;
+    }
+}
@@ -18,6 +18,8 @@ struct TransOptions
     ::std::string   mode = "c";
     unsigned int opt_level = 0;
     bool emit_debug_info = false;
+    /// C backend: emit function bodies as nested if/switch/loop statements instead of a `goto` per block
+    bool structured_c = false;
     ::std::string   build_command_file;
 
     ::std::string   panic_crate;
@@ -33,9 +35,10 @@ enum class CodegenOutput {
     Executable, // no suffix, includes main stub (TODO: Can't that just be added earlier?)
 };
 
-extern TransList Trans_Enumerate_Main(const ::HIR::Crate& crate);
+/// `polymorphise` allows instances that only differ in unused (or pointer-only) generic parameters to share code
+extern TransList Trans_Enumerate_Main(const ::HIR::Crate& crate, bool polymorphise);
 // NOTE: This also sets the saveout flags
-extern TransList Trans_Enumerate_Public(::HIR::Crate& crate);
+extern TransList Trans_Enumerate_Public(::HIR::Crate& crate, bool polymorphise);
 
 /// Re-run enumeration on monomorphised functions, removing now-unused items
 extern void Trans_Enumerate_Cleanup(const ::HIR::Crate& crate, TransList& list);
@@ -44,4 +47,7 @@ extern void Trans_AutoImpls(::HIR::Crate& crate, TransList& trans_list);
 
 extern void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list);
 
+/// Replace monomorphised functions that are identical to another (up to type layout) with a call to that function
+extern void Trans_FoldIdentical(const ::HIR::Crate& crate, TransList& list);
+
 extern void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, const ::HIR::Crate& crate, const TransList& list, const ::std::string& hir_file);
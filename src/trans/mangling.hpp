@@ -21,3 +21,17 @@ extern ::FmtLambda Trans_Mangle(const ::HIR::GenericPath& path);
 extern ::FmtLambda Trans_Mangle(const ::HIR::Path& path);
 extern ::FmtLambda Trans_Mangle(const ::HIR::TypeRef& ty);
 
+/// Structural hash for paths and types (consistent with `==`, skips some details), for keying caches
+struct Trans_MangleHash
+{
+    size_t operator()(const ::HIR::SimplePath& p) const;
+    size_t operator()(const ::HIR::GenericPath& p) const;
+    size_t operator()(const ::HIR::Path& p) const;
+    size_t operator()(const ::HIR::TypeRef& ty) const;
+private:
+    static size_t combine(size_t a, size_t b);
+};
+
+/// Release the memoised symbols (called once codegen is complete)
+extern void Trans_Mangle_ClearCache();
+
@@ -13,13 +13,15 @@
 #include <hir/hir.hpp>  // ABI_RUST
 #include <hir/type.hpp>
 #include <cctype>
-#include <algorithm>	// std::find
 #include <cmath>	// ceil/log10
+#include <unordered_map>
+#include "mangling.hpp"
 
 class Mangler
 {
     ::std::ostream& m_os;
-    std::vector<RcString>    m_name_cache;
+    /// Back-reference table: name -> index (in order of first use)
+    std::unordered_map<RcString, unsigned>  m_name_cache;
 public:
     Mangler(::std::ostream& os):
         m_os(os)
@@ -46,10 +48,10 @@ public:
     void fmt_name(const RcString& s)
     {
         // Support back-references to names (if shorter than the literal name)
-        auto it = std::find(m_name_cache.begin(), m_name_cache.end(), s);
-        if(it != m_name_cache.end())
+        auto ins = m_name_cache.insert(std::make_pair(s, static_cast<unsigned>(m_name_cache.size())));
+        if(!ins.second)
         {
-            auto idx = it - m_name_cache.begin();
+            auto idx = ins.first->second;
             // Only emit this way if shorter than the formatted name would be.
             auto len = 1 + static_cast<unsigned>(std::ceil(std::log10(idx+1) / std::log10(26)));
             if(len < s.size())
@@ -58,10 +60,6 @@ public:
                 return ;
             }
         }
-        else
-        {
-            m_name_cache.push_back(s);
-        }
 
         this->fmt_name(s.c_str());
     }
@@ -376,8 +374,88 @@ public:
     return FMT_CB(os, os << "ZRT"; Mangler(os).fmt_type(p));
 }
 
+size_t Trans_MangleHash::combine(size_t a, size_t b)
+{
+    return a ^ (b + 0x9e3779b9 + (a << 6) + (a >> 2));
+}
+size_t Trans_MangleHash::operator()(const ::HIR::SimplePath& p) const
+{
+    size_t h = ::std::hash<RcString>()(p.m_crate_name);
+    for(const auto& c : p.m_components)
+        h = combine(h, ::std::hash<RcString>()(c));
+    return h;
+}
+size_t Trans_MangleHash::operator()(const ::HIR::GenericPath& p) const
+{
+    size_t h = (*this)(p.m_path);
+    for(const auto& ty : p.m_params.m_types)
+        h = combine(h, (*this)(ty));
+    return h;
+}
+size_t Trans_MangleHash::operator()(const ::HIR::Path& p) const
+{
+    size_t h = p.m_data.tag();
+    TU_MATCH_HDRA( (p.m_data), {)
+    TU_ARMA(Generic, e) {
+        h = combine(h, (*this)(e));
+        }
+    TU_ARMA(UfcsInherent, e) {
+        h = combine(h, (*this)(e.type));
+        h = combine(h, ::std::hash<RcString>()(e.item));
+        }
+    TU_ARMA(UfcsKnown, e) {
+        h = combine(h, (*this)(e.type));
+        h = combine(h, (*this)(e.trait));
+        h = combine(h, ::std::hash<RcString>()(e.item));
+        }
+    TU_ARMA(UfcsUnknown, e) {
+        }
+    }
+    return h;
+}
+size_t Trans_MangleHash::operator()(const ::HIR::TypeRef& ty) const
+{
+    size_t h = ty.data().tag();
+    TU_MATCH_HDRA( (ty.data()), {)
+    default:
+        break;
+    TU_ARMA(Primitive, e) {
+        h = combine(h, static_cast<size_t>(e));
+        }
+    TU_ARMA(Path, e) {
+        if( e.path.m_data.is_Generic() )
+            h = combine(h, (*this)(e.path.m_data.as_Generic()));
+        }
+    TU_ARMA(Tuple, e) {
+        for(const auto& sty : e)
+            h = combine(h, (*this)(sty));
+        }
+    TU_ARMA(Slice, e) {
+        h = combine(h, (*this)(e.inner));
+        }
+    TU_ARMA(Array, e) {
+        h = combine(h, (*this)(e.inner));
+        }
+    TU_ARMA(Borrow, e) {
+        h = combine(h, static_cast<size_t>(e.type));
+        h = combine(h, (*this)(e.inner));
+        }
+    TU_ARMA(Pointer, e) {
+        h = combine(h, static_cast<size_t>(e.type));
+        h = combine(h, (*this)(e.inner));
+        }
+    TU_ARMA(Function, e) {
+        h = combine(h, e.m_arg_types.size());
+        }
+    TU_ARMA(TraitObject, e) {
+        h = combine(h, (*this)(e.m_trait.m_path));
+        }
+    }
+    return h;
+}
+
 namespace {
-    ::FmtLambda max_len(::FmtLambda v) {
+    ::std::string max_len(::FmtLambda v) {
         std::stringstream   ss;
         ss << v;
         auto s = ss.str();
@@ -391,16 +469,48 @@ namespace {
         }
         else {
         }
-        return ::FmtLambda([=](::std::ostream& os){
-            os << s;
-            });
+        return s;
+    }
+
+    template<typename T>
+    using t_mangle_cache = ::std::unordered_map<T, ::std::string, Trans_MangleHash>;
+
+    /// Finished symbols, the same paths/types are mangled many times by codegen (each use of a type or function)
+    /// - Not locked, only used by codegen (which is single-threaded)
+    struct MangleCache {
+        t_mangle_cache<::HIR::SimplePath>   simple_paths;
+        t_mangle_cache<::HIR::GenericPath>  generic_paths;
+        t_mangle_cache<::HIR::Path> paths;
+        t_mangle_cache<::HIR::TypeRef>  types;
+    };
+    MangleCache s_mangle_cache;
+
+    template<typename T>
+    ::FmtLambda get_cached(t_mangle_cache<T>& cache, const T& v, ::FmtLambda (*mangle)(const T&))
+    {
+        auto it = cache.find(v);
+        if( it == cache.end() ) {
+            it = cache.insert(::std::make_pair(v.clone(), max_len(mangle(v)))).first;
+        }
+        // NOTE: Map entries are stable (even across rehashing) until `Trans_Mangle_ClearCache`
+        const auto* s = &it->second;
+        return ::FmtLambda([s](::std::ostream& os){ os << *s; });
     }
 }
 // TODO: If the mangled name exceeds a limit, stop emitting the real name and start hashing the rest.
-#define DO_MANGLE(ty) ::FmtLambda Trans_Mangle(const ::HIR::ty& v) { \
-    return max_len(Trans_Mangle##ty(v)); \
+::FmtLambda Trans_Mangle(const ::HIR::SimplePath& v) {
+    return get_cached(s_mangle_cache.simple_paths, v, Trans_MangleSimplePath);
+}
+::FmtLambda Trans_Mangle(const ::HIR::GenericPath& v) {
+    return get_cached(s_mangle_cache.generic_paths, v, Trans_MangleGenericPath);
+}
+::FmtLambda Trans_Mangle(const ::HIR::Path& v) {
+    return get_cached(s_mangle_cache.paths, v, Trans_ManglePath);
+}
+::FmtLambda Trans_Mangle(const ::HIR::TypeRef& v) {
+    return get_cached(s_mangle_cache.types, v, Trans_MangleTypeRef);
+}
+void Trans_Mangle_ClearCache()
+{
+    s_mangle_cache = MangleCache();
 }
-DO_MANGLE(SimplePath)
-DO_MANGLE(GenericPath)
-DO_MANGLE(Path)
-DO_MANGLE(TypeRef)
@@ -410,6 +410,12 @@ void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list)
         const auto& pp = ent.second->pp;
         const auto& c = *ent.second->ptr;
         TRACE_FUNCTION_FR("CONSTANT " << path, "CONSTANT " << path);
+        // Already evaluated (e.g. by the crate that defined the constant)
+        if( ConvertHIR_ConstantEvaluate_GetCached(c, path) )
+        {
+            DEBUG("Cached");
+            continue ;
+        }
         auto ty = pp.monomorph(resolve, c.m_type);
         // 1. Evaluate the constant
         struct Nvs: public ::HIR::Evaluator::Newval
@@ -441,6 +447,31 @@ void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list)
     for(auto& fcn_ent : list.m_functions)
     {
         const auto& fcn = *fcn_ent.second->ptr;
+        if( fcn_ent.second->shared_instance )
+        {
+            // Shares code with another instance, so just forward to it
+            const auto& path = fcn_ent.first;
+            const auto& target = *fcn_ent.second->shared_instance;
+            TRACE_FUNCTION_FR("FUNCTION " << path << " = " << target, "FUNCTION " << path);
+            const auto& pp = fcn_ent.second->pp;
+            const auto& target_pp = list.m_functions.at(target)->pp;
+            resolve.set_both_generics_raw(pp.gdef_impl, &fcn.m_params);
+
+            CachedFunction  dst, src;
+            dst.ret_ty = pp.monomorph(resolve, fcn.m_return);
+            src.ret_ty = target_pp.monomorph(resolve, fcn.m_return);
+            for(const auto& a : fcn.m_args)
+            {
+                dst.arg_tys.push_back(::std::make_pair( ::HIR::Pattern{}, pp.monomorph(resolve, a.second) ));
+                src.arg_tys.push_back(::std::make_pair( ::HIR::Pattern{}, target_pp.monomorph(resolve, a.second) ));
+            }
+            dst.code = Trans_MakeForwardingStub(target, dst, src);
+            MIR_Validate(resolve, ::HIR::ItemPath(path), *dst.code, dst.arg_tys, dst.ret_ty);
+
+            fcn_ent.second->monomorphised = ::std::move(dst);
+            resolve.clear_both_generics();
+            continue ;
+        }
         // Trait methods (which are the only case where `Self` can exist in the argument list at this stage) always need to be monomorphised.
         bool is_method = ( fcn.m_args.size() > 0 && visit_ty_with(fcn.m_args[0].second, [&](const auto& x){return x == ::HIR::TypeRef("Self",0xFFFF);}) );
         if(fcn_ent.second->pp.has_types() || is_method)
@@ -483,3 +514,51 @@ void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list)
     }
 }
 
+::MIR::FunctionPointer Trans_MakeForwardingStub(const ::HIR::Path& target, const CachedFunction& dst, const CachedFunction& src)
+{
+    auto* fcn = new ::MIR::Function();
+    fcn->blocks.resize(2);
+    fcn->blocks[1].terminator = ::MIR::Terminator::make_Diverge({});
+    ::MIR::BasicBlockId cur_bb = 0;
+    auto push_call = [&](::MIR::LValue ret_val, ::MIR::CallTarget call_target, ::std::vector<::MIR::Param> args) {
+        auto next_bb = static_cast<::MIR::BasicBlockId>(fcn->blocks.size());
+        fcn->blocks.push_back(::MIR::BasicBlock());
+        fcn->blocks[cur_bb].terminator = ::MIR::Terminator::make_Call({ next_bb, 1, mv$(ret_val), mv$(call_target), mv$(args) });
+        cur_bb = next_bb;
+        };
+    auto push_transmute = [&](::MIR::LValue ret_val, ::MIR::LValue val, const ::HIR::TypeRef& from, const ::HIR::TypeRef& to) {
+        ::HIR::PathParams   pp;
+        pp.m_types.push_back(from.clone());
+        pp.m_types.push_back(to.clone());
+        ::std::vector<::MIR::Param> args;
+        args.push_back(mv$(val));
+        push_call(mv$(ret_val), ::MIR::CallTarget::make_Intrinsic({ "transmute", mv$(pp) }), mv$(args));
+        };
+
+    ::std::vector<::MIR::Param> args;
+    for(size_t i = 0; i < dst.arg_tys.size(); i ++)
+    {
+        const auto& dst_ty = dst.arg_tys[i].second;
+        const auto& src_ty = src.arg_tys[i].second;
+        if( dst_ty == src_ty ) {
+            args.push_back( ::MIR::LValue::new_Argument(i) );
+        }
+        else {
+            auto tmp = ::MIR::LValue::new_Local(static_cast<unsigned>(fcn->locals.size()));
+            fcn->locals.push_back(src_ty.clone());
+            push_transmute(tmp.clone(), ::MIR::LValue::new_Argument(i), dst_ty, src_ty);
+            args.push_back( mv$(tmp) );
+        }
+    }
+    if( dst.ret_ty == src.ret_ty ) {
+        push_call(::MIR::LValue::new_Return(), ::MIR::CallTarget::make_Path(target.clone()), mv$(args));
+    }
+    else {
+        auto tmp = ::MIR::LValue::new_Local(static_cast<unsigned>(fcn->locals.size()));
+        fcn->locals.push_back(src.ret_ty.clone());
+        push_call(tmp.clone(), ::MIR::CallTarget::make_Path(target.clone()), mv$(args));
+        push_transmute(::MIR::LValue::new_Return(), mv$(tmp), src.ret_ty, dst.ret_ty);
+    }
+    fcn->blocks[cur_bb].terminator = ::MIR::Terminator::make_Return({});
+    return ::MIR::FunctionPointer(fcn);
+}
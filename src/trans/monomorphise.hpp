@@ -15,3 +15,6 @@ namespace HIR {
 }
 
 extern ::MIR::FunctionPointer Trans_Monomorphise(const ::StaticTraitResolve& crate, const Trans_Params& params, const ::MIR::FunctionPointer& tpl);
+/// Create the body of a function (with signature `dst`) that transmutes its arguments to the types used by `target`
+/// (with signature `src`), calls it, and transmutes the result back
+extern ::MIR::FunctionPointer Trans_MakeForwardingStub(const ::HIR::Path& target, const CachedFunction& dst, const CachedFunction& src);
@@ -0,0 +1,327 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * trans/polymorphise.cpp
+ * - Detection of generic parameters that don't affect a function's code
+ *
+ * Enumeration uses this to share one instance between all argument sets that only differ in parameters that the
+ * function doesn't use (or only uses as the pointee of a thin pointer), the other instances become a stub that
+ * calls the shared one.
+ */
+#include "polymorphise.hpp"
+#include <hir/hir.hpp>
+#include <mir/mir.hpp>
+#include <mir/helpers.hpp>  // visit_mir_lvalues
+#include <hir_typeck/static.hpp>
+#include <sstream>
+
+namespace {
+    class UsageVisitor
+    {
+        const ::HIR::Function&  m_fcn;
+        const ::MIR::Function&  m_mir;
+        FunctionParamUsage& m_out;
+    public:
+        UsageVisitor(const ::HIR::Function& fcn, FunctionParamUsage& out):
+            m_fcn(fcn),
+            m_mir(*fcn.m_code.m_mir),
+            m_out(out)
+        {
+        }
+
+        void visit()
+        {
+            visit_type(m_fcn.m_return);
+            for(const auto& a : m_fcn.m_args)
+                visit_type(a.second);
+            for(const auto& ty : m_mir.locals)
+                visit_type(ty);
+
+            for(const auto& bb : m_mir.blocks)
+            {
+                for(const auto& stmt : bb.statements)
+                {
+                    visit_stmt(stmt);
+                    ::MIR::visit::visit_mir_lvalues(stmt, [&](const ::MIR::LValue& lv, ::MIR::visit::ValUsage ){ visit_lvalue(lv); return false; });
+                }
+                visit_term(bb.terminator);
+                ::MIR::visit::visit_mir_lvalues(bb.terminator, [&](const ::MIR::LValue& lv, ::MIR::visit::ValUsage ){ visit_lvalue(lv); return false; });
+            }
+        }
+
+    private:
+        /// Any generic within this type has an observable effect
+        void mark_used(const ::HIR::TypeRef& ty)
+        {
+            visit_ty_with(ty, [&](const ::HIR::TypeRef& t) {
+                if( t.data().is_Generic() )
+                    m_out.mark(t.data().as_Generic().binding, ParamUsage::Used);
+                return false;
+                });
+        }
+        void mark_used(const ::HIR::Path& p)
+        {
+            visit_path_tys_with(p, [&](const ::HIR::TypeRef& t) {
+                if( t.data().is_Generic() )
+                    m_out.mark(t.data().as_Generic().binding, ParamUsage::Used);
+                return false;
+                });
+        }
+        void mark_used(const ::HIR::GenericPath& p)
+        {
+            for(const auto& ty : p.m_params.m_types)
+                mark_used(ty);
+        }
+
+        /// Type of a value stored in the function (argument, local, ...)
+        void visit_type(const ::HIR::TypeRef& ty)
+        {
+            if( const auto* te = ty.data().opt_Borrow() ) {
+                visit_pointee(te->inner);
+            }
+            else if( const auto* te = ty.data().opt_Pointer() ) {
+                visit_pointee(te->inner);
+            }
+            else if( const auto* te = ty.data().opt_Tuple() ) {
+                for(const auto& sty : *te)
+                    visit_type(sty);
+            }
+            else {
+                mark_used(ty);
+            }
+        }
+        void visit_pointee(const ::HIR::TypeRef& ty)
+        {
+            if( ty.data().is_Generic() ) {
+                m_out.mark(ty.data().as_Generic().binding, ParamUsage::PointeeOnly);
+            }
+            else {
+                visit_type(ty);
+            }
+        }
+
+        const ::HIR::TypeRef& get_root_type(const ::MIR::LValue::Storage& root) const
+        {
+            static ::HIR::TypeRef   empty;
+            if( root.is_Return() )
+                return m_fcn.m_return;
+            if( root.is_Argument() )
+                return m_fcn.m_args.at(root.as_Argument()).second;
+            if( root.is_Local() )
+                return m_mir.locals.at(root.as_Local());
+            return empty;
+        }
+
+        void visit_lvalue(const ::MIR::LValue& lv)
+        {
+            if( lv.m_root.is_Static() ) {
+                mark_used(lv.m_root.as_Static());
+            }
+            // Dereferencing a pointer accesses the pointee, so its layout matters
+            for(const auto& w : lv.m_wrappers)
+            {
+                if( w.is_Deref() ) {
+                    mark_used(get_root_type(lv.m_root));
+                    break;
+                }
+            }
+        }
+        /// The whole value is used by an operation that depends on its type
+        void mark_used_value(const ::MIR::LValue& lv)
+        {
+            mark_used(get_root_type(lv.m_root));
+        }
+        void mark_used_value(const ::MIR::Param& p)
+        {
+            if( const auto* e = p.opt_LValue() ) {
+                mark_used_value(*e);
+            }
+            else if( const auto* e = p.opt_Borrow() ) {
+                mark_used_value(e->val);
+            }
+        }
+        void visit_const(const ::MIR::Constant& c)
+        {
+            if( const auto* ce = c.opt_Const() ) {
+                mark_used(*ce->p);
+            }
+            else if( const auto* ce = c.opt_ItemAddr() ) {
+                if( *ce )
+                    mark_used(**ce);
+            }
+        }
+        void visit_param(const ::MIR::Param& p)
+        {
+            if( const auto* e = p.opt_Constant() )
+                visit_const(*e);
+        }
+
+        void visit_stmt(const ::MIR::Statement& stmt)
+        {
+            TU_MATCH_HDRA( (stmt), {)
+            TU_ARMA(Assign, se) {
+                visit_rvalue(se.src);
+                }
+            TU_ARMA(Asm, se) {
+                m_out.all_used = true;
+                }
+            TU_ARMA(Asm2, se) {
+                m_out.all_used = true;
+                }
+            TU_ARMA(SetDropFlag, se) {
+                }
+            TU_ARMA(Drop, se) {
+                // Drop glue depends on the actual type
+                mark_used_value(se.slot);
+                }
+            TU_ARMA(ScopeEnd, se) {
+                }
+            }
+        }
+        void visit_rvalue(const ::MIR::RValue& rv)
+        {
+            TU_MATCH_HDRA( (rv), {)
+            TU_ARMA(Use, re) {
+                }
+            TU_ARMA(Borrow, re) {
+                }
+            TU_ARMA(Constant, re) {
+                visit_const(re);
+                }
+            TU_ARMA(SizedArray, re) {
+                visit_param(re.val);
+                }
+            TU_ARMA(Cast, re) {
+                visit_type(re.type);
+                // Casts to integers and pointers to primitives don't care about the source, anything else could be
+                // an unsizing cast (which needs the vtable/length of the source)
+                const auto* inner = re.type.data().is_Pointer() ? &re.type.data().as_Pointer().inner
+                    : re.type.data().is_Borrow() ? &re.type.data().as_Borrow().inner
+                    : nullptr;
+                if( !( re.type.data().is_Primitive() || (inner && inner->data().is_Primitive()) ) ) {
+                    mark_used_value(re.val);
+                }
+                }
+            TU_ARMA(BinOp, re) {
+                visit_param(re.val_l);
+                visit_param(re.val_r);
+                }
+            TU_ARMA(UniOp, re) {
+                }
+            TU_ARMA(DstMeta, re) {
+                mark_used_value(re.val);
+                }
+            TU_ARMA(DstPtr, re) {
+                mark_used_value(re.val);
+                }
+            TU_ARMA(MakeDst, re) {
+                mark_used_value(re.ptr_val);
+                visit_param(re.ptr_val);
+                visit_param(re.meta_val);
+                }
+            TU_ARMA(Tuple, re) {
+                for(const auto& v : re.vals)
+                    visit_param(v);
+                }
+            TU_ARMA(Array, re) {
+                for(const auto& v : re.vals)
+                    visit_param(v);
+                }
+            TU_ARMA(UnionVariant, re) {
+                mark_used(re.path);
+                visit_param(re.val);
+                }
+            TU_ARMA(EnumVariant, re) {
+                mark_used(re.path);
+                for(const auto& v : re.vals)
+                    visit_param(v);
+                }
+            TU_ARMA(Struct, re) {
+                mark_used(re.path);
+                for(const auto& v : re.vals)
+                    visit_param(v);
+                }
+            }
+        }
+        void visit_term(const ::MIR::Terminator& term)
+        {
+            if( const auto* te = term.opt_Call() )
+            {
+                TU_MATCH_HDRA( (te->fcn), {)
+                TU_ARMA(Value, e) {
+                    }
+                TU_ARMA(Path, e) {
+                    mark_used(e);
+                    }
+                TU_ARMA(Intrinsic, e) {
+                    for(const auto& ty : e.params.m_types)
+                        mark_used(ty);
+                    }
+                }
+                for(const auto& a : te->args)
+                    visit_param(a);
+            }
+        }
+    };
+}
+
+FunctionParamUsage Trans_Polymorphise_GetParamUsage(const ::HIR::Function& fcn)
+{
+    FunctionParamUsage  rv;
+    if( !fcn.m_code.m_mir ) {
+        rv.all_used = true;
+        return rv;
+    }
+    UsageVisitor(fcn, rv).visit();
+    return rv;
+}
+
+::std::string Trans_Polymorphise_GetKey(const ::StaticTraitResolve& resolve, const FunctionParamUsage& usage, const Trans_Params& pp)
+{
+    if( usage.all_used )
+        return "";
+    ::std::stringstream os;
+    bool shareable = false;
+    auto put_ty = [&](const ::HIR::TypeRef& ty, uint32_t binding) {
+        switch(usage.get(binding))
+        {
+        case ParamUsage::Unused:
+            os << "_";
+            shareable = true;
+            return;
+        case ParamUsage::PointeeOnly:
+            if( resolve.metadata_type(pp.sp, ty) == MetadataType::None ) {
+                os << "*";
+                shareable = true;
+                return;
+            }
+            break;
+        case ParamUsage::Used:
+            break;
+        }
+        // Length prefixed so the concatenated list can't alias
+        auto s = FMT(ty);
+        os << s.size() << ":" << s;
+        };
+
+    for(size_t i = 0; i < pp.pp_impl.m_types.size(); i ++)
+        put_ty(pp.pp_impl.m_types[i], static_cast<uint32_t>(i));
+    os << ";";
+    for(size_t i = 0; i < pp.pp_method.m_types.size(); i ++)
+        put_ty(pp.pp_method.m_types[i], static_cast<uint32_t>(256 + i));
+    os << ";";
+    if( !pp.self_type.data().is_Infer() )
+        put_ty(pp.self_type, GENERIC_Self);
+    // Values are always used exactly
+    os << ";";
+    for(const auto& v : pp.pp_impl.m_values)
+        os << v << ",";
+    os << ";";
+    for(const auto& v : pp.pp_method.m_values)
+        os << v << ",";
+
+    if( !shareable )
+        return "";
+    return os.str();
+}
@@ -0,0 +1,48 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * trans/polymorphise.hpp
+ * - Detection of generic parameters that don't affect a function's code
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include "trans_list.hpp"
+
+/// How a function's code depends on one of its generic type parameters
+enum class ParamUsage {
+    /// Not mentioned at all
+    Unused,
+    /// Only used as the pointee of a pointer/borrow that is never dereferenced (so only the metadata matters)
+    PointeeOnly,
+    /// Anything else (layout, drop glue, trait impls, ...)
+    Used,
+};
+
+/// Usage of each generic type parameter by a function (indexed by `GenericRef::binding`)
+struct FunctionParamUsage
+{
+    ::std::map<uint32_t, ParamUsage>    params;
+    /// Set if the code uses items that can't be inspected (e.g. inline assembly)
+    bool    all_used = false;
+
+    ParamUsage get(uint32_t binding) const {
+        if( all_used )
+            return ParamUsage::Used;
+        auto it = params.find(binding);
+        return it == params.end() ? ParamUsage::Unused : it->second;
+    }
+    void mark(uint32_t binding, ParamUsage u) {
+        auto& e = params[binding];
+        if( e < u )
+            e = u;
+    }
+};
+
+/// Determine how the (generic) MIR of `fcn` uses each of its type parameters
+extern FunctionParamUsage Trans_Polymorphise_GetParamUsage(const ::HIR::Function& fcn);
+/// Get a key that is equal for all instances of a function that can share code, returns an empty string if the
+/// instance can't be shared with any other
+extern ::std::string Trans_Polymorphise_GetKey(const ::StaticTraitResolve& resolve, const FunctionParamUsage& usage, const Trans_Params& pp);
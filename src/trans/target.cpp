@@ -10,6 +10,7 @@
 #include "../expand/cfg.hpp"
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <hir/hir.hpp>
 #include <hir_typeck/helpers.hpp>
 #include <hir_conv/main_bindings.hpp>   // ConvertHIR_ConstantEvaluate_Enum
@@ -1925,11 +1926,15 @@ namespace {
         return rv;
     }
 
-    // TODO: Thread safety on this cache?
     static ::std::map<::HIR::TypeRef, ::std::unique_ptr<TypeRepr>>  s_cache;
+    // Held while a repr is being created (which can recurse, and adds the reprs of enum variants), so that MIR passes
+    // running on worker threads see each type's repr created exactly once.
+    // - The map is node-based, so returned pointers stay valid after later inserts.
+    static ::std::recursive_mutex   s_cache_lock;
 
     void set_type_repr(const Span& sp, const ::HIR::TypeRef& ty, ::std::unique_ptr<TypeRepr> repr)
     {
+        ::std::lock_guard<::std::recursive_mutex>   lh { s_cache_lock };
         auto ires = s_cache.insert(::std::make_pair( ty.clone(), mv$(repr) ));
         ASSERT_BUG(sp, ires.second, "set_type_repr called for type that already has a repr: " << ty);
         DEBUG("Set repr for " << ires.first->first);
@@ -1937,6 +1942,7 @@ namespace {
 }
 const TypeRepr* Target_GetTypeRepr(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::TypeRef& ty)
 {
+    ::std::lock_guard<::std::recursive_mutex>   lh { s_cache_lock };
     auto it = s_cache.find(ty);
     if( it != s_cache.end() )
     {
@@ -84,11 +84,15 @@ struct TransList_Function
     CachedFunction  monomorphised;
     /// Forces the function to not be emited as code (just emit the signature)
     bool    force_prototype;
+    /// Instance of the same function that this one forwards to (set by enumeration when the only differences are in
+    /// generic parameters that the function doesn't depend on)
+    const ::HIR::Path*  shared_instance;
 
     TransList_Function(const ::HIR::Path& path):
         path(&path),
         ptr(nullptr),
-        force_prototype(false)
+        force_prototype(false),
+        shared_instance(nullptr)
     {}
 };
 struct TransList_Static
@@ -0,0 +1,587 @@
+/*
+ * mrustc "minicargo" (minimal cargo clone)
+ * - By John Hodge (Mutabah)
+ *
+ * artifact_store.cpp
+ * - Local content-addressed store of build outputs (shared between output directories)
+ */
+#include "artifact_store.h"
+#include "debug.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>  // getenv
+#include <cstdio>   // remove, rename
+#include <thread>   // this_thread::get_id
+#include <functional>   // hash
+#include <iterator>   // istreambuf_iterator
+#if _WIN32
+# include <Windows.h>
+#else
+# include <unistd.h>
+# include <dirent.h>
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <sys/time.h>
+# include <sys/ioctl.h>
+# ifdef __linux__
+#  include <linux/fs.h> // FICLONE
+# endif
+#endif
+
+namespace {
+    const uint32_t SHA256_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+    inline uint32_t rotr(uint32_t v, unsigned n) {
+        return (v >> n) | (v << (32 - n));
+    }
+
+    struct FileInfo {
+        bool    exists;
+        bool    is_dir;
+        int64_t mtime;
+        uint64_t    size;
+    };
+    FileInfo get_file_info(const ::helpers::path& p)
+    {
+#if _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA   d;
+        if( !GetFileAttributesExA(p.str().c_str(), GetFileExInfoStandard, &d) )
+            return FileInfo { false, false, 0, 0 };
+        return FileInfo { true, (d.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0,
+            (int64_t(d.ftLastWriteTime.dwHighDateTime) << 32) | d.ftLastWriteTime.dwLowDateTime,
+            (uint64_t(d.nFileSizeHigh) << 32) | d.nFileSizeLow
+            };
+#else
+        struct stat s;
+        if( stat(p.str().c_str(), &s) != 0 )
+            return FileInfo { false, false, 0, 0 };
+        return FileInfo { true, S_ISDIR(s.st_mode), int64_t(s.st_mtime), uint64_t(s.st_size) };
+#endif
+    }
+
+    /// List the entries of a directory (sorted, so hashes don't depend on the filesystem's ordering)
+    ::std::vector<::std::string> list_dir(const ::helpers::path& dir)
+    {
+        ::std::vector<::std::string>    rv;
+#if _WIN32
+        WIN32_FIND_DATA find_data;
+        HANDLE find_handle = FindFirstFile( (dir / "*").str().c_str(), &find_data );
+        if( find_handle == INVALID_HANDLE_VALUE )
+            return rv;
+        do
+        {
+            rv.push_back(find_data.cFileName);
+        } while( FindNextFile(find_handle, &find_data) );
+        FindClose(find_handle);
+#else
+        auto* dp = opendir(dir.str().c_str());
+        if( dp == nullptr )
+            return rv;
+        while( const auto* dent = readdir(dp) )
+        {
+            rv.push_back(dent->d_name);
+        }
+        closedir(dp);
+#endif
+        ::std::sort(rv.begin(), rv.end());
+        return rv;
+    }
+
+    void make_dir(const ::helpers::path& p)
+    {
+#if _WIN32
+        CreateDirectoryA(p.str().c_str(), NULL);
+#else
+        mkdir(p.str().c_str(), 0755);
+#endif
+    }
+
+    bool copy_file(const ::helpers::path& src, const ::helpers::path& dst)
+    {
+        ::std::ifstream ifs(src.str(), ::std::ios::binary);
+        ::std::ofstream ofs(dst.str(), ::std::ios::binary);
+        if( !ifs.good() || !ofs.good() )
+            return false;
+        char    buf[64*1024];
+        while( ifs.read(buf, sizeof(buf)) || ifs.gcount() > 0 )
+        {
+            ofs.write(buf, ifs.gcount());
+        }
+        return ofs.good();
+    }
+
+    /// Create `dst` with the contents of `src`, sharing the data if possible
+    /// - Never a hard link, as the materialised file is touched and the store's copy must keep its own timestamp
+    bool clone_file(const ::helpers::path& src, const ::helpers::path& dst)
+    {
+        remove(dst.str().c_str());
+#if !defined(_WIN32) && defined(FICLONE)
+        {
+            int src_fd = open(src.str().c_str(), O_RDONLY);
+            if( src_fd >= 0 )
+            {
+                int dst_fd = open(dst.str().c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+                bool ok = dst_fd >= 0 && ioctl(dst_fd, FICLONE, src_fd) == 0;
+                if( dst_fd >= 0 )
+                    close(dst_fd);
+                close(src_fd);
+                if( ok )
+                    return true;
+                remove(dst.str().c_str());
+            }
+        }
+#endif
+        return copy_file(src, dst);
+    }
+
+    /// Update the modification time (so the timestamp checks see the output as new)
+    void touch_file(const ::helpers::path& p)
+    {
+#if _WIN32
+        HANDLE h = CreateFileA(p.str().c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ|FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if( h != INVALID_HANDLE_VALUE )
+        {
+            FILETIME    ft;
+            GetSystemTimeAsFileTime(&ft);
+            SetFileTime(h, NULL, NULL, &ft);
+            CloseHandle(h);
+        }
+#else
+        utimes(p.str().c_str(), nullptr);
+#endif
+    }
+
+    /// List the files below `dir`, as paths relative to it (using `/` as the separator)
+    void list_tree(const ::helpers::path& dir, const ::std::string& prefix, ::std::vector<::std::string>& out)
+    {
+        for(const auto& name : list_dir(dir))
+        {
+            if( name == "." || name == ".." )
+                continue ;
+            auto p = dir / name.c_str();
+            if( get_file_info(p).is_dir )
+                list_tree(p, prefix + name + "/", out);
+            else
+                out.push_back(prefix + name);
+        }
+    }
+}
+
+ArtifactHasher::ArtifactHasher():
+    m_state { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+    m_block_len(0),
+    m_total_len(0)
+{
+}
+void ArtifactHasher::process_block(const uint8_t* block)
+{
+    uint32_t    w[64];
+    for(int i = 0; i < 16; i ++)
+        w[i] = (uint32_t(block[i*4]) << 24) | (uint32_t(block[i*4+1]) << 16) | (uint32_t(block[i*4+2]) << 8) | block[i*4+3];
+    for(int i = 16; i < 64; i ++)
+    {
+        uint32_t s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+        uint32_t s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+    uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for(int i = 0; i < 64; i ++)
+    {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+    m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+}
+void ArtifactHasher::update(const void* data, size_t len)
+{
+    const auto* p = static_cast<const uint8_t*>(data);
+    m_total_len += len;
+    while( len > 0 )
+    {
+        if( m_block_len == 0 && len >= 64 )
+        {
+            process_block(p);
+            p += 64;
+            len -= 64;
+            continue ;
+        }
+        size_t n = ::std::min(len, 64 - m_block_len);
+        memcpy(m_block + m_block_len, p, n);
+        m_block_len += n;
+        p += n;
+        len -= n;
+        if( m_block_len == 64 )
+        {
+            process_block(m_block);
+            m_block_len = 0;
+        }
+    }
+}
+void ArtifactHasher::feed(const ::std::string& s)
+{
+    uint64_t len = s.size();
+    uint8_t len_bytes[8];
+    for(int i = 0; i < 8; i ++)
+        len_bytes[i] = uint8_t(len >> (i*8));
+    update(len_bytes, 8);
+    update(s.data(), s.size());
+}
+::std::string ArtifactHasher::finish()
+{
+    uint64_t bit_len = m_total_len * 8;
+    uint8_t pad = 0x80;
+    update(&pad, 1);
+    pad = 0;
+    while( m_block_len != 56 )
+        update(&pad, 1);
+    uint8_t len_bytes[8];
+    for(int i = 0; i < 8; i ++)
+        len_bytes[i] = uint8_t(bit_len >> (56 - i*8));
+    update(len_bytes, 8);
+
+    static const char HEX[] = "0123456789abcdef";
+    ::std::string   rv;
+    for(auto v : m_state)
+    {
+        for(int i = 28; i >= 0; i -= 4)
+            rv += HEX[(v >> i) & 0xF];
+    }
+    return rv;
+}
+
+ArtifactStore::ArtifactStore()
+{
+    const char* dir = getenv("MINICARGO_CACHE_DIR");
+    if( dir && dir[0] )
+    {
+        m_root = ::helpers::path(dir).to_absolute();
+        make_dir(m_root);
+    }
+}
+
+::helpers::path ArtifactStore::entry_dir(const ::std::string& key) const
+{
+    return m_root / key.substr(0, 2).c_str() / key.substr(2).c_str();
+}
+
+::std::string ArtifactStore::hash_file(const ::helpers::path& p) const
+{
+    auto info = get_file_info(p);
+    if( !info.exists || info.is_dir )
+        return "";
+    auto key = p.to_absolute().str();
+    {
+        ::std::lock_guard<::std::mutex> lh { m_hash_lock };
+        auto it = m_file_hashes.find(key);
+        if( it != m_file_hashes.end() && it->second.mtime == info.mtime && it->second.size == info.size )
+            return it->second.hash;
+    }
+
+    ArtifactHasher  h;
+    {
+        ::std::ifstream ifs(p.str(), ::std::ios::binary);
+        if( !ifs.good() )
+            return "";
+        char    buf[64*1024];
+        while( ifs.read(buf, sizeof(buf)) || ifs.gcount() > 0 )
+        {
+            h.update(buf, static_cast<size_t>(ifs.gcount()));
+        }
+    }
+    auto rv = h.finish();
+
+    ::std::lock_guard<::std::mutex> lh { m_hash_lock };
+    m_file_hashes[key] = FileHash { info.mtime, info.size, rv };
+    return rv;
+}
+
+::std::string ArtifactStore::hash_lib_dir(const ::helpers::path& dir) const
+{
+    auto key = dir.to_absolute().str();
+    {
+        ::std::lock_guard<::std::mutex> lh { m_hash_lock };
+        auto it = m_dir_hashes.find(key);
+        if( it != m_dir_hashes.end() )
+            return it->second;
+    }
+
+    ArtifactHasher  h;
+    for(const auto& name : list_dir(dir))
+    {
+        auto is_suffix = [&](const char* sfx) {
+            size_t l = strlen(sfx);
+            return name.size() > l && name.compare(name.size() - l, l, sfx) == 0;
+            };
+        if( !is_suffix(".hir") && !is_suffix(".rlib") )
+            continue ;
+        h.feed(name);
+        h.feed(hash_file(dir / name.c_str()));
+    }
+    auto rv = h.finish();
+
+    ::std::lock_guard<::std::mutex> lh { m_hash_lock };
+    m_dir_hashes[key] = rv;
+    return rv;
+}
+
+void ArtifactStore::hash_tree(ArtifactHasher& h, const ::helpers::path& dir, const ::helpers::path& skip, ::std::vector<::helpers::path>* out_files) const
+{
+    for(const auto& name : list_dir(dir))
+    {
+        if( name[0] == '.' || name == "target" )
+            continue ;
+        auto p = dir / name.c_str();
+        auto info = get_file_info(p);
+        if( info.is_dir )
+        {
+            if( skip.is_valid() && p.to_absolute() == skip )
+                continue ;
+            h.feed(name + "/");
+            hash_tree(h, p, skip, out_files);
+            h.feed("..");
+        }
+        else if( info.exists )
+        {
+            h.feed(name);
+            h.feed(hash_file(p));
+            if( out_files )
+                out_files->push_back(p);
+        }
+    }
+}
+
+namespace {
+    ::helpers::path metadata_file(const ::helpers::path& output)
+    {
+        auto hir = output + ".hir";
+        return get_file_info(hir).exists ? hir : output;
+    }
+}
+void ArtifactStore::write_tag(const ::helpers::path& output, const ::std::string& key) const
+{
+    ::std::ofstream ofs((output + ".artifact").str());
+    ofs << key << "\n" << hash_file(metadata_file(output)) << "\n";
+}
+::std::string ArtifactStore::dependency_hash(const ::helpers::path& output) const
+{
+    auto cur_hash = hash_file(metadata_file(output));
+    ::std::ifstream ifs((output + ".artifact").str());
+    ::std::string   key, tagged_hash;
+    if( ::std::getline(ifs, key) && ::std::getline(ifs, tagged_hash) && tagged_hash == cur_hash )
+    {
+        return "key:" + key;
+    }
+    return cur_hash;
+}
+
+bool ArtifactStore::fetch(const ::std::string& key, const ::std::vector<::helpers::path>& outputs) const
+{
+    auto dir = entry_dir(key);
+    ::std::vector<::std::string>    names;
+    {
+        ::std::ifstream ifs((dir / "outputs").str());
+        if( !ifs.good() )
+            return false;
+        ::std::string   line;
+        while( ::std::getline(ifs, line) )
+        {
+            if( !line.empty() )
+                names.push_back(line);
+        }
+    }
+    for(const auto& name : names)
+    {
+        auto it = ::std::find_if(outputs.begin(), outputs.end(), [&](const ::helpers::path& p){ return p.basename() == name; });
+        if( it == outputs.end() )
+        {
+            DEBUG("Artifact " << key << " has unexpected output " << name);
+            return false;
+        }
+        if( it->parent().is_valid() )
+            make_dir(it->parent());
+        if( !clone_file(dir / name.c_str(), *it) )
+        {
+            DEBUG("Unable to materialise " << *it << " from artifact " << key);
+            return false;
+        }
+        touch_file(*it);
+    }
+    DEBUG("Fetched " << names.size() << " outputs from artifact " << key);
+    return true;
+}
+
+::helpers::path ArtifactStore::begin_entry(const ::std::string& key) const
+{
+    auto dir = entry_dir(key);
+    if( get_file_info(dir).exists )
+        return ::helpers::path();
+    make_dir(dir.parent());
+
+    // Populate a temporary directory, then rename it into place (if another build stored the same key first, the
+    // rename fails and this copy is discarded)
+#if _WIN32
+    auto tmp_dir = dir + ::format(".tmp", GetCurrentProcessId(), "_", GetCurrentThreadId()).c_str();
+#else
+    auto tmp_dir = dir + ::format(".tmp", getpid(), "_", ::std::hash<::std::thread::id>()(::std::this_thread::get_id())).c_str();
+#endif
+    make_dir(tmp_dir);
+    return tmp_dir;
+}
+void ArtifactStore::commit_entry(const ::std::string& key, const ::helpers::path& tmp_dir, const ::std::string& names) const
+{
+    {
+        ::std::ofstream ofs((tmp_dir / "outputs").str());
+        ofs << names;
+        if( !ofs.good() )
+        {
+            remove_tree(tmp_dir);
+            return ;
+        }
+    }
+    if( rename(tmp_dir.str().c_str(), entry_dir(key).str().c_str()) != 0 )
+    {
+        remove_tree(tmp_dir);
+    }
+    else
+    {
+        DEBUG("Stored artifact " << key);
+    }
+}
+
+void ArtifactStore::store(const ::std::string& key, const ::std::vector<::helpers::path>& outputs) const
+{
+    auto tmp_dir = begin_entry(key);
+    if( !tmp_dir.is_valid() )
+        return ;
+    ::std::string   names;
+    for(const auto& p : outputs)
+    {
+        if( !get_file_info(p).exists )
+            continue ;
+        auto name = p.basename();
+        if( !copy_file(p, tmp_dir / name.c_str()) )
+        {
+            DEBUG("Unable to store " << p << " in artifact " << key);
+            remove_tree(tmp_dir);
+            return ;
+        }
+        names += name;
+        names += "\n";
+    }
+    commit_entry(key, tmp_dir, names);
+}
+
+// Tree entries list the relative paths in `outputs`, with the file contents stored as `f<index>`
+bool ArtifactStore::fetch_tree(const ::std::string& key, const ::helpers::path& dir) const
+{
+    auto entry = entry_dir(key);
+    ::std::vector<::std::string>    names;
+    {
+        ::std::ifstream ifs((entry / "outputs").str());
+        if( !ifs.good() )
+            return false;
+        ::std::string   line;
+        while( ::std::getline(ifs, line) )
+        {
+            if( !line.empty() )
+                names.push_back(line);
+        }
+    }
+    remove_tree(dir);
+    make_dir(dir);
+    for(size_t i = 0; i < names.size(); i ++)
+    {
+        // Create the containing directories
+        for(size_t pos = names[i].find('/'); pos != ::std::string::npos; pos = names[i].find('/', pos+1))
+        {
+            make_dir(dir / names[i].substr(0, pos).c_str());
+        }
+        auto dst = dir / names[i].c_str();
+        if( !clone_file(entry / ::format("f", i).c_str(), dst) )
+        {
+            DEBUG("Unable to materialise " << dst << " from artifact " << key);
+            return false;
+        }
+        touch_file(dst);
+    }
+    DEBUG("Fetched " << names.size() << " files from artifact " << key);
+    return true;
+}
+void ArtifactStore::store_tree(const ::std::string& key, const ::helpers::path& dir) const
+{
+    auto tmp_dir = begin_entry(key);
+    if( !tmp_dir.is_valid() )
+        return ;
+    ::std::vector<::std::string>    files;
+    list_tree(dir, "", files);
+    ::std::string   names;
+    for(size_t i = 0; i < files.size(); i ++)
+    {
+        if( !copy_file(dir / files[i].c_str(), tmp_dir / ::format("f", i).c_str()) )
+        {
+            DEBUG("Unable to store " << dir / files[i].c_str() << " in artifact " << key);
+            remove_tree(tmp_dir);
+            return ;
+        }
+        names += files[i];
+        names += "\n";
+    }
+    commit_entry(key, tmp_dir, names);
+}
+
+bool ArtifactStore::fetch_text(const ::std::string& key, ::std::string& out_value) const
+{
+    ::std::ifstream ifs((entry_dir(key) / "value").str(), ::std::ios::binary);
+    if( !ifs.good() )
+        return false;
+    out_value.assign(::std::istreambuf_iterator<char>(ifs), ::std::istreambuf_iterator<char>());
+    return true;
+}
+void ArtifactStore::store_text(const ::std::string& key, const ::std::string& value) const
+{
+    auto tmp_dir = begin_entry(key);
+    if( !tmp_dir.is_valid() )
+        return ;
+    {
+        ::std::ofstream ofs((tmp_dir / "value").str(), ::std::ios::binary);
+        ofs << value;
+        if( !ofs.good() )
+        {
+            remove_tree(tmp_dir);
+            return ;
+        }
+    }
+    commit_entry(key, tmp_dir, "value\n");
+}
+
+void ArtifactStore::remove_tree(const ::helpers::path& dir)
+{
+    for(const auto& name : list_dir(dir))
+    {
+        if( name == "." || name == ".." )
+            continue ;
+        auto p = dir / name.c_str();
+        if( get_file_info(p).is_dir )
+            remove_tree(p);
+        else
+            remove(p.str().c_str());
+    }
+#if _WIN32
+    RemoveDirectoryA(dir.str().c_str());
+#else
+    rmdir(dir.str().c_str());
+#endif
+}
@@ -0,0 +1,99 @@
+/*
+ * mrustc "minicargo" (minimal cargo clone)
+ * - By John Hodge (Mutabah)
+ *
+ * artifact_store.h
+ * - Local content-addressed store of build outputs (shared between output directories)
+ */
+#pragma once
+#include <path.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/// Incremental SHA-256, used to build artifact keys
+class ArtifactHasher
+{
+    uint32_t    m_state[8];
+    uint8_t m_block[64];
+    size_t  m_block_len;
+    uint64_t    m_total_len;
+public:
+    ArtifactHasher();
+
+    /// Add raw bytes
+    void update(const void* data, size_t len);
+    /// Add a length-prefixed string (so adjacent fields can't run together)
+    void feed(const ::std::string& s);
+    /// Finalise, returning the digest as lower-case hex
+    ::std::string finish();
+private:
+    void process_block(const uint8_t* block);
+};
+
+/// Content-addressed store rooted at `MINICARGO_CACHE_DIR`
+///
+/// Each entry is a directory named by the hex key (split as `<2 chars>/<rest>`) containing the output files and an
+/// `outputs` list naming them. Entries are written to a temporary directory and renamed into place, so a partially
+/// written entry is never visible.
+class ArtifactStore
+{
+    ::helpers::path m_root;
+
+    struct FileHash {
+        int64_t mtime;
+        uint64_t    size;
+        ::std::string   hash;
+    };
+    mutable ::std::mutex    m_hash_lock;
+    mutable ::std::map<::std::string, FileHash>   m_file_hashes;
+    mutable ::std::map<::std::string, ::std::string>  m_dir_hashes;
+
+public:
+    /// Create the store from `MINICARGO_CACHE_DIR` (disabled if unset/empty)
+    ArtifactStore();
+
+    bool is_enabled() const { return m_root.is_valid(); }
+
+    /// Hash the contents of a file (memoised on the file's size and modification time), empty if it can't be read
+    ::std::string hash_file(const ::helpers::path& p) const;
+    /// Hash the contents of every crate metadata/library file in a search directory (memoised)
+    ::std::string hash_lib_dir(const ::helpers::path& dir) const;
+    /// Hash the names and contents of all files below `dir`, skipping hidden entries, `target`, and `skip`
+    ///
+    /// The paths of the hashed files are added to `out_files` (if non-null)
+    void hash_tree(ArtifactHasher& h, const ::helpers::path& dir, const ::helpers::path& skip, ::std::vector<::helpers::path>* out_files) const;
+
+    /// Record the key used for an output, so crates depending on it can use the key instead of the output's contents
+    /// (outputs can contain paths specific to their output directory)
+    void write_tag(const ::helpers::path& output, const ::std::string& key) const;
+    /// Get the identity of a dependency: the recorded key (if still current), or the hash of its metadata
+    ::std::string dependency_hash(const ::helpers::path& output) const;
+
+    /// Materialise the outputs stored for `key` (by reflink, hard link, or copy). Returns false if there's no entry
+    bool fetch(const ::std::string& key, const ::std::vector<::helpers::path>& outputs) const;
+    /// Store the (existing) outputs under `key`
+    void store(const ::std::string& key, const ::std::vector<::helpers::path>& outputs) const;
+
+    /// Materialise the files stored for `key` below `dir` (replacing its existing contents). Returns false if there's no
+    /// entry
+    bool fetch_tree(const ::std::string& key, const ::helpers::path& dir) const;
+    /// Store every file below `dir` (keeping their relative paths) under `key`
+    void store_tree(const ::std::string& key, const ::helpers::path& dir) const;
+    /// Read a text value (e.g. a build script's output) stored under `key`. Returns false if there's no entry
+    bool fetch_text(const ::std::string& key, ::std::string& out_value) const;
+    /// Store a text value under `key`
+    void store_text(const ::std::string& key, const ::std::string& value) const;
+
+    /// Remove a directory and everything within it
+    static void remove_tree(const ::helpers::path& dir);
+
+private:
+    ::helpers::path entry_dir(const ::std::string& key) const;
+    /// Create a temporary directory to populate an entry in (returns an invalid path if the entry already exists)
+    ::helpers::path begin_entry(const ::std::string& key) const;
+    /// Write the `outputs` list and move a populated temporary directory into place
+    void commit_entry(const ::std::string& key, const ::helpers::path& tmp_dir, const ::std::string& names) const;
+};
@@ -22,6 +22,7 @@ extern int _putenv_s(const char*, const char*);
 #include "build.h"
 #include "debug.h"
 #include "stringlist.h"
+#include "artifact_store.h"
 #include <vector>
 #include <algorithm>
 #include <sstream>  // stringstream
@@ -43,7 +44,10 @@ extern int _putenv_s(const char*, const char*);
 # include <sys/types.h>
 # include <sys/stat.h>
 # include <sys/wait.h>
+# include <utime.h>
 # include <fcntl.h>
+# include <sys/socket.h>
+# include <sys/un.h>
 #endif
 #ifdef __APPLE__
 # include <mach-o/dyld.h>
@@ -109,19 +113,34 @@ class Builder
     ::helpers::path m_compiler_path;
     size_t m_total_targets;
     mutable size_t m_targets_built;
+    ArtifactStore   m_store;
+#ifndef DISABLE_MULTITHREAD
+    // Number of libraries that have reported their metadata as ready, but are still running the C compiler
+    mutable ::std::mutex    m_pipelined_mutex;
+    mutable ::std::condition_variable   m_pipelined_cv;
+    mutable unsigned    m_pipelined_count;
+#endif
 
 public:
     Builder(const BuildOptions& opts, size_t total_targets);
 
-    bool build_target(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, size_t index) const;
-    bool build_library(const PackageManifest& manifest, bool is_for_host, size_t index) const;
+    /// `on_metadata_ready` is called if dependents can start before the build completes (see `BuildOptions::pipeline`)
+    bool build_target(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, size_t index, const ::std::function<void()>& on_metadata_ready={}) const;
+    bool build_library(const PackageManifest& manifest, bool is_for_host, size_t index, const ::std::function<void()>& on_metadata_ready={}) const;
     ::helpers::path build_build_script(const PackageManifest& manifest, bool is_for_host, bool* out_is_rebuilt) const;
 
 private:
     ::std::string get_crate_suffix(const PackageManifest& manifest) const;
     ::std::string get_build_script_out(const PackageManifest& manifest) const;
     ::helpers::path get_crate_path(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, const char** crate_type, ::std::string* out_crate_suffix) const;
-    bool spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile) const;
+    bool spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile, const ::std::function<bool()>& on_poll={}) const;
+    /// Wait until all pipelined library builds have completed (needed before anything that links them)
+    void wait_for_pipelined_builds() const;
+    ::std::string get_artifact_key(const PackageManifest& manifest, const PackageTarget& target, const StringList& args, const StringListKV& env, ::std::vector<::helpers::path>& out_inputs) const;
+    /// Key for a build script and the environment it's run in
+    ::std::string get_build_script_key(const PackageManifest& manifest, const StringListKV& env) const;
+    /// Key for a build script's output, given the inputs it declared (`rerun`)
+    ::std::string get_build_script_output_key(const PackageManifest& manifest, const ::std::string& script_key, const ::std::string& rerun) const;
 
     ::helpers::path build_and_run_script(const PackageManifest& manifest, bool is_for_host) const;
 
@@ -154,6 +173,8 @@ class Timestamp
 
 public:
     static Timestamp for_file(const ::helpers::path& p);
+    /// Set the modification time of a file to this timestamp
+    void apply_to(const ::helpers::path& p) const;
     static Timestamp infinite_past() {
 #if _WIN32
         return Timestamp { FILETIME { 0, 0 } };
@@ -463,20 +484,30 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
                         }
 
                         DEBUG("Thread " << my_idx << ": Starting " << cur << " - " << list[cur].package->name());
-                        if( ! builder->build_library(*list[cur].package, list[cur].is_host, cur) )
+                        // Dependents can be started as soon as the metadata is ready
+                        bool released = false;
+                        auto release_dependents = [&]() {
+                            ::std::lock_guard<::std::mutex> sl { queue.mutex };
+                            released = true;
+                            int v = queue.state.complete_package(cur, list);
+                            while(v--)
+                            {
+                                queue.avaliable_tasks.notify();
+                            }
+                            };
+                        if( ! builder->build_library(*list[cur].package, list[cur].is_host, cur, release_dependents) )
                         {
                             queue.failure = true;
                             queue.signal_all();
                         }
                         else
                         {
-                            ::std::lock_guard<::std::mutex> sl { queue.mutex };
-                            queue.num_active --;
-                            int v = queue.state.complete_package(cur, list);
-                            while(v--)
+                            if( !released )
                             {
-                                queue.avaliable_tasks.notify();
+                                release_dependents();
                             }
+                            ::std::lock_guard<::std::mutex> sl { queue.mutex };
+                            queue.num_active --;
 
                             // If the queue is empty, and there's no active jobs, stop.
                             if( queue.state.build_queue.empty() && queue.num_active == 0 )
@@ -611,6 +642,9 @@ Builder::Builder(const BuildOptions& opts, size_t total_targets):
     m_opts(opts),
     m_total_targets(total_targets),
     m_targets_built(0)
+#ifndef DISABLE_MULTITHREAD
+    , m_pipelined_count(0)
+#endif
 {
     m_compiler_path = get_mrustc_path();
 }
@@ -851,7 +885,7 @@ namespace {
     }
 }
 
-bool Builder::build_target(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, size_t index) const
+bool Builder::build_target(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, size_t index, const ::std::function<void()>& on_metadata_ready/*={}*/) const
 {
     const bool is_rustc = (m_compiler_path.basename() == "rustc" || m_compiler_path.basename() == "rustc.exe");
 
@@ -877,10 +911,18 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
         // Rebuild (missing)
         DEBUG("Building " << outfile << " - Missing");
     }
+    else if( !(Timestamp::for_file(outfile + ".hir_ready") == Timestamp::infinite_past()) ) {
+        // Rebuild (a pipelined build was interrupted, `outfile` is just the placeholder created with the metadata)
+        DEBUG("Building " << outfile << " - Interrupted pipelined build");
+    }
     else if( !getenv("MINICARGO_IGNTOOLS") && ( ts_result < Timestamp::for_file(m_compiler_path) /*|| ts_result < Timestamp::for_file("bin/minicargo")*/ ) ) {
         // Rebuild (older than mrustc/minicargo)
         DEBUG("Building " << outfile << " - Older than mrustc ( " << ts_result << " < " << Timestamp::for_file(m_compiler_path) << ")");
     }
+    else if( manifest.build_script() != "" && ts_result < Timestamp::for_file(this->get_output_dir(is_for_host) / get_build_script_out(manifest) + ".txt") ) {
+        // Rebuild (build script was re-run, generated files aren't in the depfile)
+        DEBUG("Building " << outfile << " - Build script output changed");
+    }
     else {
         // Check dependencies. (from depfile)
         auto depfile_ents = load_depfile(depfile);
@@ -1073,10 +1115,262 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
     }
     push_env_common(env, manifest);
 
+    // Look for the outputs in the artifact store (keyed by the content of everything that goes into the build)
+    ::std::string   artifact_key;
+    ::std::vector<::helpers::path>  artifact_outputs { outfile, outfile + ".hir" };
+    if( m_store.is_enabled() )
+    {
+        ::std::vector<::helpers::path>  inputs;
+        artifact_key = this->get_artifact_key(manifest, target, args, env, inputs);
+        if( m_store.fetch(artifact_key, artifact_outputs) )
+        {
+            m_store.write_tag(outfile, artifact_key);
+
+            // Write a depfile naming the hashed inputs, so later timestamp checks still notice changes
+            ::std::ofstream ofs(depfile.str());
+            ofs << outfile << ":";
+            for(const auto& p : inputs)
+            {
+                ofs << " ";
+                for(char c : p.str())
+                {
+                    if( c == ' ' || c == ':' )
+                        ofs << '\\';
+                    ofs << c;
+                }
+            }
+            ofs << "\n";
+
+#ifndef DISABLE_MULTITHREAD
+            ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
+#endif
+            ::std::cout << "> " << outfile << " from artifact store (" << artifact_key << ")" << ::std::endl;
+            return true;
+        }
+    }
+    // If the old outputs came from the artifact store, remove them instead of overwriting them (they may be links to
+    // the stored files)
+    if( remove((outfile + ".artifact").str().c_str()) == 0 )
+    {
+        for(const auto& p : artifact_outputs)
+            remove(p.str().c_str());
+    }
+
+    // Libraries can let dependents start as soon as their metadata is written, other crate types link against their
+    // dependencies so need every dependency to be complete.
+    ::helpers::path metadata_ready_file;
+    bool    metadata_reported = false;
+    ::std::function<bool()> on_poll;
+    if( on_metadata_ready && m_opts.pipeline && !is_rustc && !m_opts.compile_server && !m_opts.target_name
+        && ::std::strcmp(crate_type, "rlib") == 0 )
+    {
+        metadata_ready_file = outfile + ".hir_ready";
+        remove(metadata_ready_file.str().c_str());
+        // mrustc truncates the output when the metadata is ready, so a stale one mustn't survive an interrupted build
+        remove(outfile.str().c_str());
+        args.push_back("-C"); args.push_back(format("emit-metadata-ready=", metadata_ready_file));
+        on_poll = [&]()->bool {
+            if( Timestamp::for_file(metadata_ready_file) == Timestamp::infinite_past() )
+                return true;
+            DEBUG("Metadata ready for " << outfile);
+#ifndef DISABLE_MULTITHREAD
+            {
+                ::std::lock_guard<::std::mutex> lh { m_pipelined_mutex };
+                m_pipelined_count ++;
+            }
+#endif
+            // Dependents hash this library's tag into their own keys, so it has to be current before they start (the
+            // metadata written now is final)
+            if( !artifact_key.empty() )
+            {
+                m_store.write_tag(outfile, artifact_key);
+            }
+            metadata_reported = true;
+            on_metadata_ready();
+            return false;
+            };
+    }
+    else if( ::std::strcmp(crate_type, "rlib") != 0 )
+    {
+        this->wait_for_pipelined_builds();
+    }
+
     // TODO: If emitting command files (i.e. cross-compiling), concatenate the contents of `outfile + ".sh"` onto a
     // master file.
     // - Will probably want to do this as a final stage after building everything.
-    return this->spawn_process_mrustc(args, ::std::move(env), outfile + "_dbg.txt");
+    bool ok = this->spawn_process_mrustc(args, ::std::move(env), outfile + "_dbg.txt", on_poll);
+    if( metadata_reported )
+    {
+        // Dependents compare their timestamps against this library and may have finished before the C compiler did,
+        // so date the output to when the metadata was written.
+        if( ok )
+        {
+            Timestamp::for_file(metadata_ready_file).apply_to(outfile);
+        }
+#ifndef DISABLE_MULTITHREAD
+        ::std::lock_guard<::std::mutex> lh { m_pipelined_mutex };
+        m_pipelined_count --;
+        m_pipelined_cv.notify_all();
+#endif
+    }
+    if( metadata_ready_file.is_valid() )
+    {
+        remove(metadata_ready_file.str().c_str());
+        // The output is created along with the metadata, so remove it on failure to force a rebuild next time
+        if( !ok )
+        {
+            remove(outfile.str().c_str());
+        }
+    }
+    if( !ok )
+        return false;
+    if( !artifact_key.empty() )
+    {
+        m_store.store(artifact_key, artifact_outputs);
+        m_store.write_tag(outfile, artifact_key);
+    }
+    return true;
+}
+namespace {
+    /// Replace every occurrence of `from` in `s` with `to`
+    ::std::string replace_all(::std::string s, const ::std::string& from, const ::std::string& to)
+    {
+        if( from.empty() )
+            return s;
+        for(size_t pos = s.find(from); pos != ::std::string::npos; pos = s.find(from, pos + to.size()))
+        {
+            s.replace(pos, from.size(), to);
+        }
+        return s;
+    }
+    /// Resolve a path from a build script's output (relative to the package directory)
+    ::helpers::path get_package_path(const PackageManifest& manifest, const ::std::string& p)
+    {
+        bool is_absolute = p.size() > 0 && (p[0] == '/' || p[0] == '\\' || (p.size() > 1 && p[1] == ':'));
+        return is_absolute ? ::helpers::path(p) : manifest.directory() / p.c_str();
+    }
+    /// Locate the C compiler mrustc would run by default (`$CC` or `gcc`, searched for in `PATH`)
+    ::helpers::path find_c_compiler()
+    {
+        ::std::string name = getenv("CC") ? getenv("CC") : "gcc";
+        name = name.substr(0, name.find(' '));
+        if( name.find('/') != ::std::string::npos || name.find('\\') != ::std::string::npos )
+            return ::helpers::path(name);
+#ifdef _WIN32
+        const char  sep = ';';
+#else
+        const char  sep = ':';
+#endif
+        ::std::string   search = getenv("PATH") ? getenv("PATH") : "";
+        for(size_t start = 0; start <= search.size(); )
+        {
+            auto end = ::std::min(search.find(sep, start), search.size());
+            if( end > start )
+            {
+                auto p = ::helpers::path(search.substr(start, end - start)) / name.c_str();
+                if( !(Timestamp::for_file(p) == Timestamp::infinite_past()) )
+                    return p;
+            }
+            start = end + 1;
+        }
+        return ::helpers::path();
+    }
+    /// Hash the settings that mrustc reads from its own environment, and the C compiler it runs
+    void hash_ambient_toolchain(ArtifactHasher& h, const ArtifactStore& store)
+    {
+        for(const char* var : { "MRUSTC_STRUCTURED_C", "MRUSTC_TARGET_VER", "CC" })
+        {
+            h.feed(var);
+            h.feed(getenv(var) ? getenv(var) : "");
+        }
+        auto cc_path = find_c_compiler();
+        h.feed(cc_path.is_valid() ? store.hash_file(cc_path) : "");
+    }
+}
+::std::string Builder::get_artifact_key(const PackageManifest& manifest, const PackageTarget& target, const StringList& args, const StringListKV& env, ::std::vector<::helpers::path>& out_inputs) const
+{
+    // NOTE: Paths that only depend on where the output directory or package is are left out (replaced by the content
+    // they refer to), so the same crate built from another checkout gets the same key.
+    ArtifactHasher  h;
+    h.feed("minicargo-artifact-1");
+    h.feed(m_store.hash_file(m_compiler_path));
+    hash_ambient_toolchain(h, m_store);
+    if( m_opts.target_name && (strchr(m_opts.target_name, '/') || strchr(m_opts.target_name, '\\')) )
+    {
+        h.feed(m_store.hash_file(m_opts.target_name));
+    }
+
+    const auto& argv = args.get_vec();
+    const auto output_dir = this->get_output_dir(true).str();
+    const auto target_output_dir = this->get_output_dir(false).str();
+    for(size_t i = 0; i < argv.size(); i ++)
+    {
+        const char* a = argv[i];
+        if( i == 0 ) {
+            // Crate root (contents hashed with the package)
+            h.feed(target.m_path);
+        }
+        else if( strcmp(a, "-o") == 0 && i+1 < argv.size() ) {
+            h.feed(a);
+            h.feed(::helpers::path(argv[++i]).basename());
+        }
+        else if( strcmp(a, "-L") == 0 && i+1 < argv.size() ) {
+            h.feed(a);
+            a = argv[++i];
+            bool is_lib_dir = ::std::any_of(m_opts.lib_search_dirs.begin(), m_opts.lib_search_dirs.end(), [&](const ::helpers::path& d){ return d.str() == a; });
+            if( a == output_dir || a == target_output_dir ) {
+                // Dependencies in the output directory are passed with `--extern`
+                h.feed("<output>");
+            }
+            else if( is_lib_dir ) {
+                // Pre-built crates (e.g. libstd)
+                h.feed(m_store.hash_lib_dir(a));
+            }
+            else {
+                h.feed(a);
+            }
+        }
+        else if( strcmp(a, "--extern") == 0 && i+1 < argv.size() ) {
+            h.feed(a);
+            a = argv[++i];
+            const char* eq = strchr(a, '=');
+            ::helpers::path path = eq ? eq + 1 : a;
+            h.feed(::std::string(a, eq ? eq : a + strlen(a)));
+            h.feed(m_store.dependency_hash(path));
+        }
+        else if( strncmp(a, "emit-depfile=", 13) == 0 ) {
+            h.feed("emit-depfile");
+        }
+        else if( strncmp(a, "emit-build-command=", 19) == 0 ) {
+            h.feed(::helpers::path(a + 19).basename());
+        }
+        else {
+            h.feed(a);
+        }
+    }
+
+    const char* out_dir = "";
+    for(auto kv : env)
+    {
+        h.feed(kv.first);
+        if( strcmp(kv.first, "OUT_DIR") == 0 ) {
+            // Build script output (generated source files)
+            m_store.hash_tree(h, kv.second, ::helpers::path(), nullptr);
+            out_dir = kv.second;
+        }
+        else if( strcmp(kv.first, "CARGO_MANIFEST_DIR") == 0 ) {
+            // Location of the package (contents hashed below)
+        }
+        else {
+            // - Variables set by the build script can refer to its output directory
+            h.feed(replace_all(kv.second, out_dir, "${OUT_DIR}"));
+        }
+    }
+
+    // Package sources (everything in the package directory, except for the output directory if it's in there)
+    m_store.hash_tree(h, manifest.directory(), m_opts.output_dir.to_absolute(), &out_inputs);
+
+    return h.finish();
 }
 ::helpers::path Builder::build_build_script(const PackageManifest& manifest, bool is_for_host, bool* out_is_rebuilt) const
 {
@@ -1153,6 +1447,8 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
     // TODO: If there's any dependencies marked as `links = foo` then grab `DEP_FOO_<varname>` from its metadata
     // (build script output)
 
+    // The script is linked against its dependencies, so they must be fully built
+    this->wait_for_pipelined_builds();
     if( this->spawn_process_mrustc(args, ::std::move(env), outfile + "_dbg.txt") )
     {
         *out_is_rebuilt = true;
@@ -1164,6 +1460,85 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
         return ::helpers::path();
     }
 }
+::std::string Builder::get_build_script_key(const PackageManifest& manifest, const StringListKV& env) const
+{
+    ArtifactHasher  h;
+    h.feed("minicargo-build-script-1");
+    h.feed(m_store.hash_file(m_compiler_path));
+    hash_ambient_toolchain(h, m_store);
+
+    // Script source (if it's in its own directory, then everything in that directory)
+    auto script_path = manifest.directory() / ::helpers::path(manifest.build_script());
+    h.feed(manifest.build_script());
+    if( script_path.parent().to_absolute() == manifest.directory().to_absolute() ) {
+        h.feed(m_store.hash_file(script_path));
+    }
+    else {
+        m_store.hash_tree(h, script_path.parent(), ::helpers::path(), nullptr);
+    }
+
+    // Libraries the script is linked against
+    for(const auto& d : m_opts.lib_search_dirs)
+    {
+        h.feed(m_store.hash_lib_dir(d));
+    }
+    manifest.iter_build_dependencies([&](const PackageRef& dep) {
+        if( ! dep.is_disabled() )
+        {
+            const auto& m = dep.get_package();
+            h.feed(m.get_library().m_name);
+            h.feed(m_store.dependency_hash(this->get_crate_path(m, m.get_library(), true, nullptr, nullptr)));
+        }
+    });
+
+    // Environment passed to the script (features, target, cfgs, package version, ...)
+    for(auto kv : env)
+    {
+        // - Paths specific to this output directory/checkout (`RUSTC` is covered by the compiler hash)
+        if( strcmp(kv.first, "OUT_DIR") == 0 || strcmp(kv.first, "CARGO_MANIFEST_DIR") == 0 || strcmp(kv.first, "RUSTC") == 0 )
+            continue ;
+        h.feed(kv.first);
+        h.feed(kv.second);
+    }
+    return h.finish();
+}
+::std::string Builder::get_build_script_output_key(const PackageManifest& manifest, const ::std::string& script_key, const ::std::string& rerun) const
+{
+    // `rerun` is the list of inputs the script declared (`changed <path>` and `env <name>` lines), with no
+    // `rerun-if-changed` the script depends on the whole package (same as cargo)
+    ArtifactHasher  h;
+    h.feed(script_key);
+    bool has_changed = false;
+    ::std::istringstream    is(rerun);
+    ::std::string   line;
+    while( ::std::getline(is, line) )
+    {
+        h.feed(line);
+        if( line.compare(0, 8, "changed ") == 0 ) {
+            has_changed = true;
+            auto path = get_package_path(manifest, line.substr(8));
+            if( Timestamp::for_file(path) == Timestamp::infinite_past() ) {
+                h.feed("");
+            }
+            else if( m_store.hash_file(path).empty() ) {
+                // Directory
+                m_store.hash_tree(h, path, m_opts.output_dir.to_absolute(), nullptr);
+            }
+            else {
+                h.feed(m_store.hash_file(path));
+            }
+        }
+        else if( line.compare(0, 4, "env ") == 0 ) {
+            const char* v = getenv(line.c_str() + 4);
+            h.feed(v ? ::std::string("=") + v : ::std::string("unset"));
+        }
+    }
+    if( !has_changed )
+    {
+        m_store.hash_tree(h, manifest.directory(), m_opts.output_dir.to_absolute(), nullptr);
+    }
+    return h.finish();
+}
 ::helpers::path Builder::build_and_run_script(const PackageManifest& manifest, bool is_for_host) const
 {
     auto output_dir_abs = this->get_output_dir(is_for_host).to_absolute();
@@ -1171,8 +1546,84 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
     auto out_file = output_dir_abs / get_build_script_out(manifest) + ".txt";
     auto out_dir = output_dir_abs / get_build_script_out(manifest);
 
+    // Environment variables (key-value list)
+    StringListKV    env;
+    //env.push_back("CARGO_MANIFEST_LINKS", manifest.m_links);
+    for(const auto& feat : manifest.active_features())
+    {
+        ::std::string   fn = "CARGO_FEATURE_";
+        for(char c : feat)
+            fn += c == '-' ? '_' : toupper(c);
+        env.push_back(fn, "1");
+    }
+    //env.push_back("CARGO_CFG_RELEASE", "");
+    env.push_back("OUT_DIR", out_dir);
+
+    push_env_common(env, manifest);
+
+    env.push_back("TARGET", m_opts.target_name ? m_opts.target_name : HOST_TARGET);
+    env.push_back("HOST", HOST_TARGET);
+    env.push_back("NUM_JOBS", "1");
+    env.push_back("OPT_LEVEL", "2");
+    env.push_back("DEBUG", "0");
+    env.push_back("PROFILE", "release");
+    // - Needed for `regex`'s build script, make mrustc pretend to be rustc
+    env.push_back("RUSTC", this->m_compiler_path);
+
+    // NOTE: All cfg(foo_bar) become CARGO_CFG_FOO_BAR
+    Cfg_ToEnvironment(env);
+
+    // Look for the script's output in the artifact store. The store records the inputs the script declared
+    // (`rerun-if-changed`/`rerun-if-env-changed`) under a key of the script and its environment, and the output under
+    // a key that includes the current state of those inputs.
+    // - Paths to the output directory and package are replaced by placeholders in the stored output
+    const ::std::string out_dir_str = out_dir.str();
+    const ::std::string manifest_dir_str = manifest.directory().to_absolute().str();
+    ::std::string   script_key;
+    ::std::string   output_key;
+    bool force_run = false;
+    if( m_store.is_enabled() )
+    {
+        script_key = this->get_build_script_key(manifest, env);
+        ::std::string   rerun;
+        if( m_store.fetch_text(script_key, rerun) )
+        {
+            output_key = this->get_build_script_output_key(manifest, script_key, rerun);
+            if( m_store.dependency_hash(out_file) == "key:" + output_key )
+            {
+                DEBUG(out_file << " is current (" << output_key << ")");
+                return out_file;
+            }
+            ::std::string   output;
+            ArtifactHasher  h;
+            h.feed(output_key);
+            h.feed("OUT_DIR");
+            if( m_store.fetch_text(output_key, output) && m_store.fetch_tree(h.finish(), out_dir) )
+            {
+                {
+                    ::std::ofstream ofs(out_file.str(), ::std::ios::binary);
+                    ofs << replace_all(replace_all(output, "${OUT_DIR}", out_dir_str), "${CARGO_MANIFEST_DIR}", manifest_dir_str);
+                }
+                m_store.write_tag(out_file, output_key);
+#ifndef DISABLE_MULTITHREAD
+                ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
+#endif
+                ::std::cout << "> " << out_file << " from artifact store (" << output_key << ")" << ::std::endl;
+                return out_file;
+            }
+            // The inputs have changed since the current output was generated
+            force_run = true;
+        }
+    }
+    // If the old output came from the artifact store, remove the generated files instead of overwriting them (they may
+    // be links to the stored files)
+    if( remove((out_file + ".artifact").str().c_str()) == 0 )
+    {
+        ArtifactStore::remove_tree(out_dir);
+        force_run = true;
+    }
+
     bool run_build_script = false;
-    // TODO: Handle a pre-existing script containing `cargo:rerun-if-changed`
     auto script_exe = this->build_build_script(manifest, is_for_host, &run_build_script);
     if( !script_exe.is_valid() )
     {
@@ -1180,8 +1631,25 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
         return ::helpers::path();
     }
 
+    // Re-run if any of the files that the previous run declared (with `cargo:rerun-if-changed`) are newer than its
+    // output
+    auto ts_output = Timestamp::for_file(out_file);
+    if( !run_build_script && !force_run && !(ts_output == Timestamp::infinite_past()) )
+    {
+        for(const auto& f : manifest.read_build_script(out_file.str()).rerun_if_changed)
+        {
+            auto path = get_package_path(manifest, f);
+            if( ts_output < Timestamp::for_file(path) )
+            {
+                DEBUG("Re-running build script - " << path << " changed");
+                force_run = true;
+                break;
+            }
+        }
+    }
+
     // If the script changed, OR the output file doesn't exist
-    if( run_build_script || Timestamp::for_file(out_file) == Timestamp::infinite_past() )
+    if( run_build_script || force_run || ts_output == Timestamp::infinite_past() )
     {
         auto script_exe_abs = script_exe.to_absolute();
 
@@ -1191,32 +1659,6 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
 #else
         mkdir(out_dir.str().c_str(), 0755);
 #endif
-        // Environment variables (key-value list)
-        StringListKV    env;
-        //env.push_back("CARGO_MANIFEST_LINKS", manifest.m_links);
-        for(const auto& feat : manifest.active_features())
-        {
-            ::std::string   fn = "CARGO_FEATURE_";
-            for(char c : feat)
-                fn += c == '-' ? '_' : toupper(c);
-            env.push_back(fn, "1");
-        }
-        //env.push_back("CARGO_CFG_RELEASE", "");
-        env.push_back("OUT_DIR", out_dir);
-
-        push_env_common(env, manifest);
-
-        env.push_back("TARGET", m_opts.target_name ? m_opts.target_name : HOST_TARGET);
-        env.push_back("HOST", HOST_TARGET);
-        env.push_back("NUM_JOBS", "1");
-        env.push_back("OPT_LEVEL", "2");
-        env.push_back("DEBUG", "0");
-        env.push_back("PROFILE", "release");
-        // - Needed for `regex`'s build script, make mrustc pretend to be rustc
-        env.push_back("RUSTC", this->m_compiler_path);
-
-        // NOTE: All cfg(foo_bar) become CARGO_CFG_FOO_BAR
-        Cfg_ToEnvironment(env);
 
         if( m_opts.emit_mmir )
         {
@@ -1251,11 +1693,41 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
             // Build failed, return an invalid path
             return ::helpers::path();
         }
+
+        // Save the output (and the inputs it depends on) in the artifact store
+        if( !script_key.empty() )
+        {
+            auto script_output = manifest.read_build_script(out_file.str());
+            ::std::string   rerun;
+            for(const auto& f : script_output.rerun_if_changed)
+                rerun += "changed " + f + "\n";
+            for(const auto& v : script_output.rerun_if_env_changed)
+                rerun += "env " + v + "\n";
+            m_store.store_text(script_key, rerun);
+            // NOTE: The stored inputs may differ if another build stored the same script key first, in which case
+            // this output is only found if the inputs match.
+            if( m_store.fetch_text(script_key, rerun) )
+            {
+                output_key = this->get_build_script_output_key(manifest, script_key, rerun);
+                ::std::string   output;
+                {
+                    ::std::ifstream ifs(out_file.str(), ::std::ios::binary);
+                    output.assign(::std::istreambuf_iterator<char>(ifs), ::std::istreambuf_iterator<char>());
+                }
+                ArtifactHasher  h;
+                h.feed(output_key);
+                h.feed("OUT_DIR");
+                // The output is stored last, as it's what's checked first by the lookup
+                m_store.store_tree(h.finish(), out_dir);
+                m_store.store_text(output_key, replace_all(replace_all(output, out_dir_str, "${OUT_DIR}"), manifest_dir_str, "${CARGO_MANIFEST_DIR}"));
+                m_store.write_tag(out_file, output_key);
+            }
+        }
     }
 
     return out_file;
 }
-bool Builder::build_library(const PackageManifest& manifest, bool is_for_host, size_t index) const
+bool Builder::build_library(const PackageManifest& manifest, bool is_for_host, size_t index, const ::std::function<void()>& on_metadata_ready/*={}*/) const
 {
     if( manifest.build_script() != "" )
     {
@@ -1282,12 +1754,163 @@ bool Builder::build_library(const PackageManifest& manifest, bool is_for_host, s
         }
     }
 
-    return this->build_target(manifest, manifest.get_library(), is_for_host, index);
+    return this->build_target(manifest, manifest.get_library(), is_for_host, index, on_metadata_ready);
+}
+#ifndef _WIN32
+/// Check the (`waitpid`) status of a finished process, printing an error if it failed
+static bool check_exit_status(int status, const ::std::vector<const char*>& argv)
+{
+    if( status != 0 )
+    {
+#ifndef DISABLE_MULTITHREAD
+        ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
+#endif
+        set_console_colour(std::cerr, TerminalColour::Red);
+        if( WIFEXITED(status) )
+            ::std::cerr << "Process exited with non-zero exit status " << WEXITSTATUS(status) << ::std::endl;
+        else if( WIFSIGNALED(status) )
+            ::std::cerr << "Process was terminated with signal " << WTERMSIG(status) << ::std::endl;
+        else
+            ::std::cerr << "Process terminated for unknown reason, status=" << status << ::std::endl;
+        set_console_colour(std::cerr, TerminalColour::Default);
+        ::std::cerr << "FAILING COMMAND: ";
+        for(const auto& p : argv)
+            ::std::cerr  << " " << p;
+        ::std::cerr << ::std::endl;
+        //::std::cerr << "See " << logfile << " for the compiler output" << ::std::endl;
+        return false;
+    }
+    else
+    {
+        DEBUG("Successful exit");
+    }
+    return true;
 }
-bool Builder::spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile) const
+
+/// Submit a compilation to a compile server (`mrustc --server`, see mrustc's `src/compile_server.cpp`)
+static bool spawn_process_server(const char* socket_path, const StringList& args, const StringListKV& env, const ::helpers::path& logfile)
+{
+    ::std::vector<const char*>  argv = args.get_vec();
+    argv.insert(argv.begin(), socket_path);
+    {
+#ifndef DISABLE_MULTITHREAD
+        ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
+#endif
+        ::std::cout << ">";
+        for(const auto& p : argv)
+            ::std::cout  << " " << p;
+        ::std::cout << ::std::endl;
+    }
+
+    // Build the request: working directory, environment, arguments
+    ::std::string   req;
+    auto push = [&](const ::std::string& s) { req += s; req += '\0'; };
+    {
+        char    buf[PATH_MAX];
+        if( !getcwd(buf, sizeof(buf)) ) {
+            ::std::cerr << "Unable to get current directory - " << strerror(errno) << ::std::endl;
+            return false;
+        }
+        push(buf);
+    }
+    {
+        ::std::vector<::std::string>    envp;
+        extern char **environ;
+        for(auto p = environ; *p; p++)
+            envp.push_back(*p);
+        for(auto kv : env)
+            envp.push_back(::format(kv.first, "=", kv.second));
+        push(::format(envp.size()));
+        for(const auto& e : envp)
+            push(e);
+    }
+    push(::format(args.get_vec().size()));
+    for(const auto* a : args.get_vec())
+        push(a);
+
+    mkdir(static_cast<::std::string>(logfile.parent()).c_str(), 0755);
+    int log_fd = open(static_cast<::std::string>(logfile).c_str(), O_CREAT|O_WRONLY|O_TRUNC, 0644);
+    if( log_fd < 0 ) {
+        ::std::cerr << "Unable to open " << logfile << " - " << strerror(errno) << ::std::endl;
+        return false;
+    }
+
+    struct sockaddr_un  addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path)-1);
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( sock < 0 || connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ) {
+        set_console_colour(std::cerr, TerminalColour::Red);
+        ::std::cerr << "Unable to connect to compile server at " << socket_path << " - " << strerror(errno);
+        set_console_colour(std::cerr, TerminalColour::Default);
+        ::std::cerr << ::std::endl;
+        if(sock >= 0)   close(sock);
+        close(log_fd);
+        return false;
+    }
+
+    // Send the log file (as stdout) and our stderr with the start of the request, then the rest of it
+    bool ok;
+    {
+        int fds[2] = { log_fd, 2 };
+        union {
+            struct cmsghdr  hdr;
+            char    space[CMSG_SPACE(sizeof(fds))];
+        } cmsg_buf;
+        struct iovec iov = { &req[0], req.size() };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = cmsg_buf.space;
+        msg.msg_controllen = sizeof(cmsg_buf.space);
+        auto* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(c), fds, sizeof(fds));
+        auto n = sendmsg(sock, &msg, 0);
+        ok = n > 0;
+        for(size_t ofs = ok ? n : 0; ok && ofs < req.size(); )
+        {
+            n = write(sock, req.data() + ofs, req.size() - ofs);
+            ok = n > 0;
+            if(ok)  ofs += n;
+        }
+    }
+    close(log_fd);
+    shutdown(sock, SHUT_WR);
+
+    // Wait for the wait status of the compiler
+    ::std::string   reply;
+    for(;;)
+    {
+        char    buf[64];
+        auto n = read(sock, buf, sizeof(buf));
+        if( n <= 0 )
+            break;
+        reply.append(buf, n);
+    }
+    close(sock);
+    if( !ok || reply.empty() ) {
+        ::std::cerr << "Compile server at " << socket_path << " didn't complete the request" << ::std::endl;
+        return false;
+    }
+    return check_exit_status(::std::atoi(reply.c_str()), argv);
+}
+#endif
+
+bool Builder::spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile, const ::std::function<bool()>& on_poll/*={}*/) const
 {
     //env.push_back("MRUSTC_DEBUG", "");
-    auto rv = spawn_process(m_compiler_path.str().c_str(), args, env, logfile);
+#ifndef _WIN32
+    auto rv = m_opts.compile_server
+        ? spawn_process_server(m_opts.compile_server, args, env, logfile)
+        : spawn_process(m_compiler_path.str().c_str(), args, env, logfile, {}, on_poll);
+#else
+    auto rv = spawn_process(m_compiler_path.str().c_str(), args, env, logfile, {}, on_poll);
+#endif
     if(getenv("MINICARGO_RUN_ONCE") || getenv("MINICARGO_RUN_ONCE"))
     {
         if(rv) {
@@ -1298,6 +1921,17 @@ bool Builder::spawn_process_mrustc(const StringList& args, StringListKV env, con
     return rv;
 }
 
+void Builder::wait_for_pipelined_builds() const
+{
+#ifndef DISABLE_MULTITHREAD
+    ::std::unique_lock<::std::mutex> lh { m_pipelined_mutex };
+    while( m_pipelined_count > 0 )
+    {
+        m_pipelined_cv.wait(lh);
+    }
+#endif
+}
+
 const helpers::path& get_mrustc_path()
 {
     static helpers::path    s_compiler_path;
@@ -1358,7 +1992,7 @@ const helpers::path& get_mrustc_path()
     return s_compiler_path;
 }
 
-bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory/*={}*/)
+bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory/*={}*/, const ::std::function<bool()>& on_poll/*={}*/)
 {
     if( getenv("MINICARGO_DUMPENV") )
     {
@@ -1432,6 +2066,11 @@ bool spawn_process(const char* exe_name, const StringList& args, const StringLis
     PROCESS_INFORMATION pi = { 0 };
     CreateProcessA(exe_name, (LPSTR)cmdline_str.c_str(), NULL, NULL, TRUE, 0, NULL, (working_directory != ::helpers::path() ? working_directory.str().c_str() : NULL), &si, &pi);
     CloseHandle(si.hStdOutput);
+    if( on_poll )
+    {
+        while( WaitForSingleObject(pi.hProcess, 50) == WAIT_TIMEOUT && on_poll() )
+            ;
+    }
     WaitForSingleObject(pi.hProcess, INFINITE);
     DWORD status = 1;
     GetExitCodeProcess(pi.hProcess, &status);
@@ -1446,6 +2085,7 @@ bool spawn_process(const char* exe_name, const StringList& args, const StringLis
         std::cerr << std::endl;
         return false;
     }
+    return true;
 #else
 
     // Create logfile output directory
@@ -1466,7 +2106,9 @@ bool spawn_process(const char* exe_name, const StringList& args, const StringLis
 
     if(true)
     {
+#ifndef DISABLE_MULTITHREAD
         ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
+#endif
         ::std::cout << ">";
         for(const auto& p : argv)
             ::std::cout  << " " << p;
@@ -1527,33 +2169,17 @@ bool spawn_process(const char* exe_name, const StringList& args, const StringLis
     }
     posix_spawn_file_actions_destroy(&fa);
     int status = -1;
-    waitpid(pid, &status, 0);
-    if( status != 0 )
+    pid_t waited = 0;
+    if( on_poll )
     {
-#ifndef DISABLE_MULTITHREAD
-        ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
-#endif
-        set_console_colour(std::cerr, TerminalColour::Red);
-        if( WIFEXITED(status) )
-            ::std::cerr << "Process exited with non-zero exit status " << WEXITSTATUS(status) << ::std::endl;
-        else if( WIFSIGNALED(status) )
-            ::std::cerr << "Process was terminated with signal " << WTERMSIG(status) << ::std::endl;
-        else
-            ::std::cerr << "Process terminated for unknown reason, status=" << status << ::std::endl;
-        set_console_colour(std::cerr, TerminalColour::Default);
-        ::std::cerr << "FAILING COMMAND: ";
-        for(const auto& p : argv)
-            ::std::cerr  << " " << p;
-        ::std::cerr << ::std::endl;
-        //::std::cerr << "See " << logfile << " for the compiler output" << ::std::endl;
-        return false;
-    }
-    else
-    {
-        DEBUG("Successful exit");
+        while( (waited = waitpid(pid, &status, WNOHANG)) == 0 && on_poll() )
+            usleep(50*1000);
     }
+    if( waited == 0 )
+        waitpid(pid, &status, 0);
+    argv.pop_back();
+    return check_exit_status(status, argv);
 #endif
-    return true;
 }
 
 Timestamp Timestamp::for_file(const ::helpers::path& path)
@@ -1585,4 +2211,23 @@ Timestamp Timestamp::for_file(const ::helpers::path& path)
     }
 #endif
 }
+void Timestamp::apply_to(const ::helpers::path& path) const
+{
+#if _WIN32
+    auto handle = CreateFile(path.str().c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if(handle == INVALID_HANDLE_VALUE) {
+        return ;
+    }
+    FILETIME    ft;
+    ft.dwLowDateTime = static_cast<DWORD>(m_val);
+    ft.dwHighDateTime = static_cast<DWORD>(m_val >> 32);
+    SetFileTime(handle, NULL, NULL, &ft);
+    CloseHandle(handle);
+#else
+    struct utimbuf  t;
+    t.actime = m_val;
+    t.modtime = m_val;
+    utime(path.str().c_str(), &t);
+#endif
+}
 
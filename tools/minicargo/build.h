@@ -9,6 +9,7 @@
 
 #include "manifest.h"
 #include <path.h>
+#include <functional>
 
 class StringList;
 class StringListKV;
@@ -21,6 +22,8 @@ struct BuildOptions
     ::std::vector<::helpers::path>  lib_search_dirs;
     bool emit_mmir = false;
     const char* target_name = nullptr;  // if null, host is used
+    const char* compile_server = nullptr;   // Socket of a `mrustc --server` to compile with (if null, mrustc is run directly)
+    bool pipeline = true;   // Start dependent crates once a library's metadata is written (before its C compilation is done)
     enum class Mode {
         /// Build the binary/library
         Normal,
@@ -48,4 +51,6 @@ public:
 };
 
 extern const helpers::path& get_mrustc_path();
-extern bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory={});
+/// Run a process and wait for it to complete. If `on_poll` is set, it's called periodically while the process runs
+/// (until it returns false)
+extern bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory={}, const ::std::function<bool()>& on_poll={});
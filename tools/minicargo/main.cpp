@@ -38,9 +38,15 @@ struct ProgramOptions
     // Emit Monomorphised MIR instead of C
     bool emit_mmir = false;
 
+    // Wait for each library to be fully built (including C compilation) before starting its dependents
+    bool no_pipeline = false;
+
     // Target name (if null, defaults to host)
     const char* target = nullptr;
 
+    // Socket of a running `mrustc --server` (if null, the compiler is run directly)
+    const char* compile_server = nullptr;
+
     // Library search directories
     ::std::vector<const char*>  lib_search_dirs;
 
@@ -220,7 +226,9 @@ int main(int argc, const char* argv[])
         build_opts.output_dir = opts.output_directory ? ::helpers::path(opts.output_directory) : ::helpers::path("output");
         build_opts.lib_search_dirs.reserve(opts.lib_search_dirs.size());
         build_opts.emit_mmir = opts.emit_mmir;
+        build_opts.pipeline = !opts.no_pipeline;
         build_opts.target_name = opts.target;
+        build_opts.compile_server = opts.compile_server;
         for(const auto* d : opts.lib_search_dirs)
             build_opts.lib_search_dirs.push_back( ::helpers::path(d) );
         // Indicate desire to build tests (or examples) instead of the primary target
@@ -313,6 +321,9 @@ int ProgramOptions::parse(int argc, const char* argv[])
                 if( ::std::strcmp(arg, "emit-mmir") == 0 ) {
                     this->emit_mmir = true;
                 }
+                else if( ::std::strcmp(arg, "no-pipeline") == 0 ) {
+                    this->no_pipeline = true;
+                }
                 else {
                     ::std::cerr << "Unknown debug option -Z " << arg << ::std::endl;
                     return 1;
@@ -375,6 +386,13 @@ int ProgramOptions::parse(int argc, const char* argv[])
                 }
                 this->target = argv[++i];
             }
+            else if( ::std::strcmp(arg, "--compile-server") == 0 ) {
+                if(i+1 == argc) {
+                    ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
+                    return 1;
+                }
+                this->compile_server = argv[++i];
+            }
             else if( ::std::strcmp(arg, "--features") == 0 ) {
                 if(i+1 == argc) {
                     ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
@@ -428,6 +446,7 @@ void ProgramOptions::help() const
         << "--script-overrides <dir> : Directory containing <package>.txt files containing the build script output\n"
         << "--vendor-dir <dir>       : Directory containing vendored packages (from `cargo vendor`)\n"
         << "--output-dir,-o <dir>    : Specify the compiler output directory\n"
+        << "--compile-server <path>  : Compile crates using the `mrustc --server` listening on this socket\n"
         << "-L <dir>                 : Search for pre-built crates (e.g. libstd) in the specified directory\n"
         << "-j <count>               : Run at most <count> build tasks at once (default is to run only one)\n"
         << "-n                       : Don't build any packages, just list the packages that would be built\n"
@@ -1014,6 +1014,10 @@ void PackageManifest::load_dependencies(Repository& repo, bool include_build, bo
 }
 
 void PackageManifest::load_build_script(const ::std::string& path)
+{
+    m_build_script_output = this->read_build_script(path);
+}
+BuildScriptOutput PackageManifest::read_build_script(const ::std::string& path) const
 {
     ::std::ifstream is( path );
     if( !is.good() )
@@ -1108,7 +1112,11 @@ void PackageManifest::load_build_script(const ::std::string& path)
             }
             // cargo:rerun-if-changed=foo.rs
             else if( key == "rerun-if-changed" ) {
-                DEBUG("TODO: '" << key << "' = '" << value << "'");
+                rv.rerun_if_changed.push_back(value);
+            }
+            // cargo:rerun-if-env-changed=FOO
+            else if( key == "rerun-if-env-changed" ) {
+                rv.rerun_if_env_changed.push_back(value);
             }
             // - Ignore
             else {
@@ -1129,7 +1137,7 @@ void PackageManifest::load_build_script(const ::std::string& path)
         }
     }
 
-    m_build_script_output = rv;
+    return rv;
 }
 
 void PackageRef::load_manifest(Repository& repo, const ::helpers::path& base_path, bool include_build_deps)
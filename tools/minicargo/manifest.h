@@ -267,6 +267,11 @@ public:
 
     // cargo:foo=bar when [package]links=baz
     ::std::vector<::std::pair<::std::string, ::std::string>>    downstream_env;
+
+    // cargo:rerun-if-changed=foo.rs
+    ::std::vector<::std::string>    rerun_if_changed;
+    // cargo:rerun-if-env-changed=FOO
+    ::std::vector<::std::string>    rerun_if_env_changed;
 };
 
 class PackageManifest
@@ -376,4 +381,6 @@ public:
     void load_dependencies(Repository& repo, bool include_build, bool include_dev=false);
 
     void load_build_script(const ::std::string& path);
+    /// Parse a build script's output (without loading it)
+    BuildScriptOutput read_build_script(const ::std::string& path) const;
 };
@@ -16,6 +16,9 @@
 #else
 # include <dirent.h>
 # include <sys/stat.h>
+# include <sys/wait.h>
+# include <unistd.h>
+# include <fcntl.h>
 #endif
 
 TargetVersion	gTargetVersion = TargetVersion::Rustc1_29;
@@ -35,6 +38,7 @@ struct Options
 namespace {
     MIR::FunctionPointer clone_mir(const StaticTraitResolve& resolve, const MIR::FunctionPointer& fcn);
     bool compare_mir(const MIR::Function& exp, const MIR::Function& have, const HIR::SimplePath& path);
+    bool validate_full(const HIR::Crate& crate, const HIR::SimplePath& path);
 }
 
 int main(int argc, char* argv[])
@@ -43,6 +47,7 @@ int main(int argc, char* argv[])
         "Parse",
         "Cleanup",
         "Validate",
+        "Validate Full",
         "Run Tests",
         });
 
@@ -117,6 +122,39 @@ int main(int argc, char* argv[])
         }
     }
 
+    // Check that full validation accepts/rejects the marked functions
+    {
+        auto ph = DebugTimedPhase("Validate Full");
+        for(auto& f : test_files)
+        {
+            for(const auto& test : f.m_validate_tests)
+            {
+                if(!opts.filters.empty())
+                {
+                    bool found = false;
+                    for(const auto& f : opts.filters)
+                    {
+                        if( f == test.function.m_components.back() )
+                        {
+                            found = true;
+                            break;
+                        }
+                    }
+                    if(!found)
+                    {
+                        continue;
+                    }
+                }
+                auto p = test.function;
+                p.m_crate_name = RcString(f.m_filename);
+                if( validate_full(*f.m_crate, test.function) != test.expect_valid )
+                {
+                    std::cerr << p << " Validation mismatch: expected " << (test.expect_valid ? "accept" : "reject") << std::endl;
+                }
+            }
+        }
+    }
+
     // Funally run the tests
     {
         auto ph = DebugTimedPhase("Run Tests");
@@ -217,6 +255,35 @@ void Options::print_help() const
 }
 
 namespace {
+    /// Run full validation on a function, returning false if it's rejected
+    bool validate_full(const HIR::Crate& crate, const HIR::SimplePath& path)
+    {
+        const auto& fcn = crate.get_function_by_path(Span(), path);
+        auto run = [&]() {
+            StaticTraitResolve  resolve(crate);
+            MIR_Validate_Full(resolve, ::HIR::ItemPath(path), *fcn.m_code.m_mir, fcn.m_args, fcn.m_return);
+            };
+#ifdef _WIN32
+        // Validation failures abort the process, so a rejection can't be observed
+        run();
+        return true;
+#else
+        // Validation failures abort the process, so validate in a child
+        auto pid = fork();
+        if( pid == 0 )
+        {
+            int null_fd = open("/dev/null", O_WRONLY);
+            dup2(null_fd, 1);
+            dup2(null_fd, 2);
+            run();
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+    }
+
     MIR::FunctionPointer clone_mir(const StaticTraitResolve& resolve, const MIR::FunctionPointer& fcn)
     {
         return Trans_Monomorphise(resolve, {}, fcn);
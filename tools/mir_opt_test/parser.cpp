@@ -79,6 +79,19 @@ MirOptTestFile  MirOptTestFile::load_from_file(const helpers::path& p)
 
                     rv.m_tests.push_back(mv$(t));
                 }
+                else if( attr.first == "validate_full" )
+                {
+                    MirOptTestFile::ValidateTest    t;
+                    t.function = ::HIR::SimplePath("", { fcn_name });
+                    if( attr.second == "accept" )
+                        t.expect_valid = true;
+                    else if( attr.second == "reject" )
+                        t.expect_valid = false;
+                    else
+                        TODO(lex.point_span(), "Unknown `validate_full` value - " << attr.second);
+
+                    rv.m_validate_tests.push_back(mv$(t));
+                }
                 else
                 {
                     // Ignore? Support other forms of tests?
@@ -217,6 +230,16 @@ namespace {
                 GET_CHECK_TOK(tok, lex, TOK_IDENT);
                 if( tok.ident().name == "DROP" )
                 {
+                    auto kind = MIR::eDropKind::DEEP;
+                    GET_TOK(tok, lex);
+                    if( tok.type() == TOK_IDENT && tok.ident().name == "SHALLOW" )
+                    {
+                        kind = MIR::eDropKind::SHALLOW;
+                    }
+                    else
+                    {
+                        lex.putback(mv$(tok));
+                    }
                     auto slot = parse_lvalue(lex, val_name_map);
                     if( consume_if(lex, TOK_RWORD_IF) )
                     {
@@ -224,7 +247,7 @@ namespace {
                     }
                     else
                     {
-                        bb.statements.push_back(::MIR::Statement::make_Drop({ MIR::eDropKind::DEEP, mv$(slot), ~0u }));
+                        bb.statements.push_back(::MIR::Statement::make_Drop({ kind, mv$(slot), ~0u }));
                     }
                 }
                 else if( tok.ident().name == "ASM" )
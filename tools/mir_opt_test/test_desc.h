@@ -21,5 +21,13 @@ struct MirOptTestFile
     };
     ::std::vector<Test>  m_tests;
 
+    /// Function that full validation (`MIR_Validate_Full`) should accept/reject
+    struct ValidateTest
+    {
+        ::HIR::SimplePath function;
+        bool    expect_valid;
+    };
+    ::std::vector<ValidateTest>  m_validate_tests;
+
     static MirOptTestFile  load_from_file(const helpers::path& p);
 };
@@ -0,0 +1,61 @@
+//
+// Tests for the full MIR validator (value state tracking)
+//
+
+// `v.1` is only moved out on one path, so the shallow drop leaks it on the other
+#[validate_full="reject"]
+fn cond_move_leak(c: bool, v: (&mut i32, &mut i32,))
+{
+	let t: &mut i32;
+	bb0: {
+	} IF c => bb1 else bb2;
+	bb1: {
+		ASSIGN t = v.1;
+		DROP t;
+	} GOTO bb3;
+	bb2: {
+	} GOTO bb3;
+	bb3: {
+		DROP SHALLOW v;
+		ASSIGN retval = ();
+	} RETURN;
+}
+
+// Same, but with `v.1` moved out on both paths
+#[validate_full="accept"]
+fn cond_move_both(c: bool, v: (&mut i32, &mut i32,))
+{
+	let t: &mut i32;
+	bb0: {
+	} IF c => bb1 else bb2;
+	bb1: {
+		ASSIGN t = v.1;
+		DROP t;
+	} GOTO bb3;
+	bb2: {
+		ASSIGN t = v.1;
+		DROP t;
+	} GOTO bb3;
+	bb3: {
+		DROP SHALLOW v;
+		ASSIGN retval = ();
+	} RETURN;
+}
+
+// `v` is only moved on one path, so using it after the paths join is an error
+#[validate_full="reject"]
+fn cond_move_use(c: bool, v: &mut i32) -> i32
+{
+	let t: &mut i32;
+	bb0: {
+	} IF c => bb1 else bb2;
+	bb1: {
+		ASSIGN t = v;
+		DROP t;
+	} GOTO bb3;
+	bb2: {
+	} GOTO bb3;
+	bb3: {
+		ASSIGN retval = v*;
+	} RETURN;
+}
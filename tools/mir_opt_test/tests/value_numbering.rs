@@ -0,0 +1,120 @@
+//
+// Tests for value numbering of single-assignment locals
+//
+
+// A computation repeated in a dominated block re-uses the first result
+#[test="redundant_binop_exp"]
+fn redundant_binop(a: u32, b: u32) -> u32
+{
+	let x: u32;
+	let y: u32;
+	let z: u32;
+	bb0: {
+		ASSIGN x = ADD(a, b);
+	} CALL z = "black_box"<u32>(x) => bb1 else bb_panic;
+	bb1: {
+		ASSIGN y = ADD(a, b);
+		ASSIGN retval = SUB(y, z);
+	} RETURN;
+	bb_panic: {
+	} DIVERGE;
+}
+fn redundant_binop_exp(a: u32, b: u32) -> u32
+{
+	let x: u32;
+	let z: u32;
+	bb0: {
+		ASSIGN x = ADD(a, b);
+	} CALL z = "black_box"<u32>(x) => bb1 else bb_panic;
+	bb1: {
+		ASSIGN retval = SUB(x, z);
+	} RETURN;
+	bb_panic: {
+	} DIVERGE;
+}
+
+// The first computation doesn't dominate the second, so it can't be re-used
+#[test="sibling_blocks_exp"]
+fn sibling_blocks(c: bool, a: u32, b: u32) -> u32
+{
+	let x: u32;
+	let y: u32;
+	let z: u32;
+	bb0: {
+	} IF c => bb1 else bb2;
+	bb1: {
+		ASSIGN x = ADD(a, b);
+	} CALL z = "black_box"<u32>(x) => bb3 else bb_panic;
+	bb2: {
+		ASSIGN y = ADD(a, b);
+	} CALL z = "black_box"<u32>(y) => bb3 else bb_panic;
+	bb3: {
+		ASSIGN retval = z;
+	} RETURN;
+	bb_panic: {
+	} DIVERGE;
+}
+fn sibling_blocks_exp(c: bool, a: u32, b: u32) -> u32
+{
+	let x: u32;
+	let y: u32;
+	bb0: {
+	} IF c => bb1 else bb2;
+	bb1: {
+		ASSIGN x = ADD(a, b);
+	} CALL retval = "black_box"<u32>(x) => bb3 else bb_panic;
+	bb2: {
+		ASSIGN y = ADD(a, b);
+	} CALL retval = "black_box"<u32>(y) => bb3 else bb_panic;
+	bb3: {
+	} RETURN;
+	bb_panic: {
+	} DIVERGE;
+}
+
+// Equal-hash casts in sibling blocks must not be confused with the dominating one
+#[test="cast_siblings_exp"]
+fn cast_siblings(c: bool, a: u8) -> u64
+{
+	let x: u32;
+	let y: u64;
+	let w: u64;
+	let z: u32;
+	bb0: {
+		ASSIGN x = CAST a as u32;
+	} CALL z = "black_box"<u32>(x) => bb1 else bb_panic;
+	bb1: {
+	} IF c => bb2 else bb3;
+	bb2: {
+		ASSIGN y = CAST a as u64;
+	} CALL retval = "black_box"<u64>(y) => bb4 else bb_panic;
+	bb3: {
+		ASSIGN w = CAST a as u64;
+	} CALL retval = "black_box"<u64>(w) => bb4 else bb_panic;
+	bb4: {
+	} RETURN;
+	bb_panic: {
+	} DIVERGE;
+}
+fn cast_siblings_exp(c: bool, a: u8) -> u64
+{
+	let x: u32;
+	let y: u64;
+	let w: u64;
+	let z: u32;
+	bb0: {
+		ASSIGN x = CAST a as u32;
+	} CALL z = "black_box"<u32>(x) => bb1 else bb_panic;
+	bb1: {
+	} IF c => bb2 else bb3;
+	bb_panic: {
+	} DIVERGE;
+	bb2: {
+		ASSIGN y = CAST a as u64;
+	} CALL retval = "black_box"<u64>(y) => bb4 else bb_panic;
+	bb3: {
+		ASSIGN w = CAST a as u64;
+	} CALL retval = "black_box"<u64>(w) => bb4 else bb_panic;
+	bb4: {
+	} RETURN;
+}